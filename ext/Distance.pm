@@ -90,6 +90,11 @@ BEGIN {
 require XSLoader;
 XSLoader::load('Bio::GeneOrder::Distance', $VERSION);
 
+#Hits and misses of the distances kept in memory, counted when the library
+#was built to count its own (see stats)
+our $COUNT_STATS = (stats_xs())[0];
+our %CACHE_STATS = ( 'hits' => 0, 'misses' => 0 );
+
 #Create a variable to hole our singleton instance
 our $INSTANCE;
 
@@ -117,44 +122,43 @@ sub new {
 
 =head2 pack_order
 
- Title   : packed
- Usage   : $arrayRef = $distanceObj->packed($geneOrder);
- Function: Returns the permutation of the gene order as an array of packed arrays of shorts
- Returns : An array reference
+ Title   : pack_order
+ Usage   : $packed = $distanceObj->pack_order($geneOrder);
+ Function: Returns every chromosome of the gene order packed into one string (see
+           _pack_genome). The string is kept on the gene order until it is filtered
+           or renamed, and must not be modified.
+ Returns : A packed string
 
 =cut
 
 sub pack_order {
 	my ($self,$order) = @_;
 	
-	my (@packed,%key);
+	my $cached = $order->_packed('order');
+	return $cached if defined $cached;
 	
-	my @pi = $order->pi;
-	foreach my $pi (@pi){
-		my $circular = $pi->is_circular;
-		
-		my @p = $pi->pi;
-		
-		unshift @p, $circular;
-		push @packed, pack("s*",@p);
-	}
+	my @chromosomes = map([$_->is_circular, $_->pi], $order->pi);
 	
-	return \@packed;
+	return $order->_packed('order',_pack_genome(@chromosomes));
 }
 
 =head2 pack_order_reduce
 
- Title   : packed
- Usage   : $arrayRef = $distanceObj->packed($geneOrder);
- Function: Returns the permutation of the gene order as an array of packed arrays of shorts
- Returns : An array reference
+ Title   : pack_order_reduce
+ Usage   : $packed = $distanceObj->pack_order_reduce($geneOrder);
+ Function: As pack_order, with the genes renumbered 1..N in the order of their
+           numbers, as the inversion and DCJ kernels expect.
+ Returns : A packed string
 
 =cut
 
 sub pack_order_reduce {
 	my ($self,$order) = @_;
 	
-	my (@packed,%key);
+	my $cached = $order->_packed('reduce');
+	return $cached if defined $cached;
+	
+	my (@chromosomes,%key);
 	
 	my @pi = $order->pi;
 	
@@ -164,16 +168,48 @@ sub pack_order_reduce {
 	
 	map($key{$_} = $i++, sort {$a <=> $b} keys %key);
 	foreach my $pi (@pi){
-		my $circular = $pi->is_circular;
-		
 		my @p = $pi->pi;
 		
 		map($_ = $_/abs($_)*$key{abs($_)}, @p);
-		unshift @p, $circular;
-		push @packed, pack("s*",@p);
+		push @chromosomes, [$pi->is_circular, @p];
 	}
 	
-	return \@packed;
+	return $order->_packed('reduce',_pack_genome(@chromosomes));
+}
+
+=head2 _pack_genome
+
+ Title   : _pack_genome
+ Usage   : my $packed = _pack_genome([$circular,@genes],...);
+ Function: Packs a genome for the XS library as one string: a long of flags (2 if
+           any gene number is above 32767), the number of chromosomes, the offset of
+           each chromosome's first gene and the total number of genes as longs, one
+           byte per chromosome for its circular flag padded to a long, and then the
+           genes of every chromosome back to back as shorts, or as longs if wide.
+ Returns : A packed string
+ Args    : One array reference per chromosome, holding its circular flag and its genes
+
+=cut
+
+sub _pack_genome {
+	my @chromosomes = @_;
+	
+	my (@offsets,@circular,@genes);
+	foreach my $chromosome (@chromosomes){
+		my ($circular,@p) = @$chromosome;
+		
+		push @offsets, scalar @genes;
+		push @circular, $circular ? 1 : 0;
+		push @genes, @p;
+	}
+	push @offsets, scalar @genes;
+	
+	my $wide = grep($_ > 32767 || $_ < -32767, @genes) ? 1 : 0;
+	my $n = scalar @chromosomes;
+	my $m = scalar @offsets;
+	
+	return pack("l l l$m C$n x!4", $wide ? 2 : 0, $n, @offsets, @circular) 
+		 . pack($wide ? "l*" : "s*", @genes);
 }
 
 =head2 adjacencies
@@ -191,14 +227,16 @@ sub adjacencies {
 	my $adjacencies; 
 	
 	if( defined $self->_cache('adjacencies')->{"$orderA"}{"$orderB"} ){
+		$CACHE_STATS{'hits'}++ if $COUNT_STATS;
 		$adjacencies = $self->_cache('adjacencies')->{"$orderA"}{"$orderB"};
 	}else{
+		$CACHE_STATS{'misses'}++ if $COUNT_STATS;
 		$adjacencies = adjacencies_xs($self->pack_order($orderA),$self->pack_order($orderB));
 	
 		$self->_cache('adjacencies')->{"$orderA"}{"$orderB"} = $adjacencies;
 	}
 	
-	my @adjacencies = unpack("s*",$adjacencies) if defined $adjacencies;
+	my @adjacencies = unpack("l*",$adjacencies) if defined $adjacencies;
 	my @adj_list = ();
 	
 	while(@adjacencies){
@@ -227,8 +265,15 @@ sub breakpoints {
 	my $breakpoints;
 	
 	if( defined $self->_cache('breakpoints')->{"$orderA"}{"$orderB"} ){
+		$CACHE_STATS{'hits'}++ if $COUNT_STATS;
 		$breakpoints = $self->_cache('breakpoints')->{"$orderA"}{"$orderB"};
+	}elsif( my $index = $self->_incremental(0,$orderA,$orderB) ){
+		$CACHE_STATS{'misses'}++ if $COUNT_STATS;
+		$breakpoints = incremental_distance_xs('breakpoints',$index->{"$orderA"},$index->{"$orderB"});
+		
+		$self->_cache('breakpoints')->{"$orderA"}{"$orderB"} = $breakpoints;
 	}else{
+		$CACHE_STATS{'misses'}++ if $COUNT_STATS;
 		$breakpoints = breakpoints_xs($self->pack_order($orderA),$self->pack_order($orderB));
 			  	
 		$self->_cache('breakpoints')->{"$orderA"}{"$orderB"} = $breakpoints;
@@ -252,9 +297,12 @@ sub inversions {
 	my $inversions;
 	
 	if( defined $self->_cache('inversions')->{"$orderA"}{"$orderB"} ){
+		$CACHE_STATS{'hits'}++ if $COUNT_STATS;
 		$inversions = $self->_cache('inversions')->{"$orderA"}{"$orderB"};
 	}else{
-		$inversions = inversions_xs($self->pack_order_reduce($orderA),$self->pack_order_reduce($orderB));
+		$CACHE_STATS{'misses'}++ if $COUNT_STATS;
+		$inversions = inversions_xs($self->pack_order_reduce($orderA),$self->pack_order_reduce($orderB),
+									!($self->validate($orderA) && $self->validate($orderB)));
 				
 		$self->_cache('inversions')->{"$orderA"}{"$orderB"} = $inversions;
 	}
@@ -265,7 +313,7 @@ sub inversions {
 =head2 DCJ
 
  Title   : DCJ
- Usage   : $inversions = $distanceObj->DCJ($geneOrderA,$geneOrderB);
+ Usage   : $dcj = $distanceObj->DCJ($geneOrderA,$geneOrderB);
  Function: Returns the Double-Cut and Join distance between two GeneOrder objects.
  Returns : Scalar value
 
@@ -277,15 +325,608 @@ sub DCJ {
 	my $DCJ;
 	
 	if( defined $self->_cache('DCJ')->{"$orderA"}{"$orderB"} ){
+		$CACHE_STATS{'hits'}++ if $COUNT_STATS;
 		$DCJ = $self->_cache('DCJ')->{"$orderA"}{"$orderB"};
 	}else{
-		$DCJ = DCJ_xs($self->pack_order_reduce($orderA),$self->pack_order_reduce($orderB));
+		$CACHE_STATS{'misses'}++ if $COUNT_STATS;
+		$DCJ = DCJ_xs($self->pack_order_reduce($orderA),$self->pack_order_reduce($orderB),
+					  !($self->validate($orderA) && $self->validate($orderB)));
 		$self->_cache('DCJ')->{"$orderA"}{"$orderB"} = $DCJ;
 	}
 	
 	return $DCJ;
 }
 
+=head2 inversion_scenario
+
+ Title   : inversion_scenario
+ Usage   : @inversions = $distanceObj->inversion_scenario($geneOrderA,$geneOrderB);
+ Function: Returns a shortest sequence of inversions that turns the first gene
+           order into the second, as many as the inversion distance between them.
+           Both must be a single chromosome of the same genes, both linear or
+           both circular. Each inversion applies to the first gene order as the
+           ones before it have left it; a circular gene order comes out equal
+           to the second up to the gene it is read from and its strand.
+ Returns : A list of array references, one per inversion in the order they
+           apply, each holding the signed names of the genes it inverts as they
+           read before it
+ Args    : Two Bio::GeneOrder objects
+
+=cut
+
+sub inversion_scenario {
+	my ($self,$orderA,$orderB) = @_;
+	
+	my @pi = $orderA->pi;
+	my @positions = inversion_scenario_xs($self->pack_order_reduce($orderA),$self->pack_order_reduce($orderB));
+	
+	my @genes = $pi[0]->pi;
+	my @scenario = ();
+	
+	while(@positions){
+		my ($first,$last) = splice(@positions,0,2);
+		my @segment = @genes[$first..$last];
+		
+		push @scenario, [ map($SWITCH{abs($_)/$_}.$orderA->{'key'}->{'name'}->{abs($_)}, @segment) ];
+		@genes[$first..$last] = map(-$_, reverse @segment);
+	}
+	
+	return @scenario;
+}
+
+=head2 median
+
+ Title   : median
+ Usage   : my ($median,$score,$optimal,$bound) = $distanceObj->median('inversions',$geneOrderA,$geneOrderB,$geneOrderC,60);
+ Function: Finds a gene order whose distances to three gene orders of the same
+           genes add up to the least. The inversion median is exact, searching
+           for at most the given number of seconds, and needs single
+           chromosomes, all linear or all circular. The DCJ median is found by
+           a fast heuristic, takes any number of linear and circular
+           chromosomes, and may have chromosomes of both kinds.
+ Returns : The median as a Bio::GeneOrder named 'median', its score, 1 if the
+           score is proven to be the least and 0 if not, and the lower bound
+           of half the sum of the distances between the three
+ Args    : The distance, 'inversions' or 'DCJ', three Bio::GeneOrder objects and
+           optionally the time limit of an inversion median in seconds [default none]
+
+=cut
+
+sub median {
+	my ($self,$distance,@orders) = @_;
+	my $seconds = @orders > 3 ? pop @orders : 0;
+	
+	$self->throw("median: three gene orders are needed, not ".scalar(@orders)) unless @orders == 3;
+	$self->throw("median: no $distance median") unless $distance eq 'inversions' || $distance eq 'DCJ';
+	
+	my ($score,$bound,$optimal,$evaluated,@chromosomes) =
+		median_xs($distance,map($self->pack_order_reduce($_), @orders),$seconds);
+	
+	# Gene k of the reduced numbering is the k-th smallest gene number
+	my $key = $orders[0]->{'key'};
+	my @numbers = sort {$a <=> $b} map(abs($_), map($_->pi, $orders[0]->pi));
+	my @strings;
+	
+	while(@chromosomes){
+		my ($circular,$length) = splice(@chromosomes,0,2);
+		my @genes = splice(@chromosomes,0,$length);
+		
+		push @strings, ($circular ? '' : $Bio::GeneOrder::LINEAR.' ')
+			.join(' ', map($SWITCH{abs($_)/$_}.$key->{'name'}->{$numbers[abs($_)-1]}, @genes));
+	}
+	
+	return (Bio::GeneOrder->new(@strings, -name => 'median'),$score,$optimal,$bound);
+}
+
+=head2 matrix
+
+ Title   : matrix
+ Usage   : $rows = $distanceObj->matrix('breakpoints',@geneOrders);
+ Function: Computes the distance between every pair of gene orders in a single call
+           to the XS library.  Each gene order is packed only once.  The matrix is
+           computed with the number of threads set by the threads method, and the
+           result does not depend on the number of threads.
+ Returns : A reference to an array of array references, one row per gene order,
+           in the same order as the gene orders passed.
+ Args    : The name of a distance (see supported_distances) and a list of GeneOrder objects.
+
+=cut
+
+sub matrix {
+	my ($self,$distance,@orders) = @_;
+	
+	$self->throw("distance '$distance' can not be computed as a matrix") 
+		unless grep($_ eq $distance, qw(adjacencies breakpoints inversions DCJ));
+	
+	my $n = scalar @orders;
+	my @d = unpack("i*", $self->_matrix($distance,@orders));
+	
+	my @rows;
+	for(my $i=0;$i<$n;$i++){
+		push @rows, [ @d[$i*$n .. ($i+1)*$n - 1] ];
+	}
+	
+	#Cell [i][j] with i <= j was computed with order j as the first argument
+	unless($distance eq 'adjacencies'){
+		for(my $i=0;$i<$n;$i++){
+			for(my $j=$i;$j<$n;$j++){
+				$self->_cache($distance)->{"$orders[$j]"}{"$orders[$i]"} = $rows[$i][$j];
+			}
+		}
+	}
+	
+	return \@rows;
+}
+
+=head2 _matrix
+
+ Title   : _matrix
+ Usage   : $packed = $distanceObj->_matrix('breakpoints',@geneOrders);
+ Function: Computes the distance matrix of the matrix method without unpacking it
+           or adding it to the pairwise cache.
+ Returns : The n*n distances, row by row, packed as ints
+ Args    : The name of a distance and a list of GeneOrder objects.
+
+=cut
+
+sub _matrix {
+	my ($self,$distance,@orders) = @_;
+	
+	my $index = $distance eq 'adjacencies' || $distance eq 'breakpoints' ? $self->_incremental(1,@orders) : undef;
+	if($index){
+		return incremental_matrix_xs($distance, pack("l*", map($index->{"$_"}, @orders)));
+	}
+	
+	my @packed;
+	if($distance eq 'inversions' || $distance eq 'DCJ'){
+		@packed = map($self->pack_order_reduce($_), @orders);
+	}else{
+		@packed = map($self->pack_order($_), @orders);
+	}
+	
+	my $validate = grep(!$self->validate($_), @orders) ? 1 : 0;
+	return distance_matrix_xs(\@packed,$distance,$self->threads,$validate);
+}
+
+=head2 tree
+
+ Title   : tree
+ Usage   : $newick = $distanceObj->tree('NJ','breakpoints',@geneOrders);
+ Function: Builds a Neighbor-Joining or UPGMA tree of the gene orders from their
+           distance matrix.  The matrix is passed to the XS library packed, as the
+           matrix method computes it, and the tree is built there.  Neighbor-Joining
+           skips most pairs of each round by bounding their Q values, so a tree of
+           thousands of gene orders takes seconds.  The Neighbor-Joining tree is
+           unrooted and is written with three nodes below its root.
+ Returns : The tree in Newick format, with the gene orders named by their names
+ Args    : 'NJ' or 'UPGMA', the name of a distance that the matrix method computes,
+           and a list of GeneOrder objects.
+
+=cut
+
+sub tree {
+	my ($self,$method,$distance,@orders) = @_;
+	
+	$self->throw("tree method '$method' not recognized") unless grep($_ eq $method, qw(NJ UPGMA));
+	$self->throw("distance '$distance' can not be computed as a matrix") 
+		unless grep($_ eq $distance, qw(adjacencies breakpoints inversions DCJ));
+	$self->throw("no gene orders to build a tree of") unless @orders;
+	
+	return distance_tree_xs($self->_matrix($distance,@orders), $method, [ map($_->name, @orders) ]);
+}
+
+=head2 validate
+
+ Title   : validate
+ Usage   : $valid = $distanceObj->validate($geneOrder);
+ Function: Checks once that a gene order has no duplicate genes. The result is
+           kept on the gene order until it is filtered or renamed, and inversion
+           and DCJ distances between valid gene orders skip their own checks.
+ Returns : 1 if the gene order is valid, 0 if not
+ Args    : A Bio::GeneOrder object
+
+=cut
+
+sub validate {
+	my ($self,$order) = @_;
+	
+	my $valid = $order->_packed('valid');
+	
+	unless(defined $valid){
+		$valid = validate_xs($self->pack_order($order)) == 0 ? 1 : 0;
+		$order->_packed('valid',$valid);
+	}
+	
+	return $valid;
+}
+
+=head2 signature
+
+ Title   : signature
+ Usage   : $signature = $distanceObj->signature($geneOrder);
+ Function: Returns the adjacencies of the gene order's unfiltered genes in a
+           canonical form that does not depend on the strand a chromosome is
+           read from or, if it is circular, the gene it starts at. Gene orders
+           that repeat no gene are 0 breakpoints apart exactly when their
+           signatures are equal, so identical gene orders can be grouped by
+           hashing their signatures instead of comparing every pair. The result
+           is kept on the gene order until it is filtered or renamed.
+ Returns : A packed string
+ Args    : A Bio::GeneOrder object
+
+=cut
+
+sub signature {
+	my ($self,$order) = @_;
+	
+	my $signature = $order->_packed('signature');
+	return $signature if defined $signature;
+	
+	return $order->_packed('signature',signature_xs($self->pack_order($order)));
+}
+
+=head2 threads
+
+ Title   : threads
+ Usage   : $distanceObj->threads(4);
+ Function: Get/set the number of threads used to compute distance matrices.
+           A value of 0 uses one thread per available core.
+ Returns : Scalar value [default 1]
+
+=cut
+
+sub threads {
+	my ($self,$value) = @_;
+	
+	if( defined $value){
+		$self->throw("threads must be a non-negative integer") 
+			unless $value =~ /^\d+$/;
+		$self->{'threads'} = $value;
+	}
+	
+	return defined $self->{'threads'} ? $self->{'threads'} : 1;
+}
+
+=head2 reserve
+
+ Title   : reserve
+ Usage   : $distanceObj->reserve($num_genes);
+ Function: Sizes the workspace used for inversion distances so that gene orders
+           of up to $num_genes genes are compared without allocating memory.
+           The workspace only grows, so larger gene orders are still handled.
+ Returns : Nothing
+
+=cut
+
+sub reserve {
+	my ($self,$num_genes) = @_;
+	
+	reserve_xs($num_genes) if $num_genes;
+	
+	return;
+}
+
+=head2 incremental
+
+ Title   : incremental
+ Usage   : $distanceObj->incremental(0);
+ Function: Get/set whether breakpoint and adjacency distances are kept current
+           across gene filters. The first matrix of either distance over a list
+           of gene orders is computed in full. Once a gene filter changes, the
+           next matrix over the same list indexes the adjacencies of all of their
+           genes, filtered or not, so matrices that no gene filter follows cost
+           nothing more. Filtering or restoring genes afterwards only revisits the
+           adjacencies around those genes, so later matrices and pairwise
+           breakpoints over these gene orders are read off in constant time per
+           pair. Editing a gene order indexes them again after the next filter.
+           Gene orders that repeat a gene are always computed in full.
+ Returns : Scalar value [default 1]
+
+=cut
+
+sub incremental {
+	my ($self,$value) = @_;
+	
+	if( defined $value){
+		$self->{'incremental'} = $value ? 1 : 0;
+		unless($value){
+			incremental_clear_xs();
+			delete $self->{'incdist'};
+		}
+	}
+	
+	return defined $self->{'incremental'} ? $self->{'incremental'} : 1;
+}
+
+=head2 _incremental
+
+ Title   : _incremental
+ Usage   : my $index = $distanceObj->_incremental($build,@geneOrders);
+ Function: Brings the incremental distances up to date with the gene filter
+           and returns the position of each gene order among them. If $build
+           is true, gene orders that are not all indexed, or were edited since,
+           are remembered, and indexed by a later call once a gene filter has
+           changed.
+ Returns : A hash reference from gene order to position, or undef if the
+           distances between these gene orders can not be read incrementally
+ Args    : Whether to index the gene orders, and a list of GeneOrder objects
+           sharing one gene key
+
+=cut
+
+sub _incremental {
+	my ($self,$build,@orders) = @_;
+	
+	return unless @orders && $self->incremental;
+	
+	my $key = $orders[0]->_key;
+	return if grep($_->_key != $key, @orders);
+	
+	my $inc = $self->{'incdist'};
+	
+	unless( defined $inc && $inc->{'key'} == $key && $inc->{'revision'} == $Bio::GeneOrder::REVISION
+			&& !grep(!exists $inc->{'index'}{"$_"}, @orders) ){
+		return unless $build;
+		
+		my $i = 0;
+		$self->{'incdist'} = { 'key'        => $key,
+							   'revision'   => $Bio::GeneOrder::REVISION,
+							   'generation' => $Bio::GeneOrder::GENERATION,
+							   'orders'     => [ @orders ],
+							   'index'      => { map(("$_" => $i++), @orders) } };
+		return;
+	}
+	
+	#the gene orders are indexed by the first matrix after a gene filter changes
+	unless( exists $inc->{'valid'} ){
+		return unless $build && $inc->{'generation'} != $Bio::GeneOrder::GENERATION;
+		
+		my @packed;
+		foreach my $order (@{ $inc->{'orders'} }){
+			push @packed, _pack_genome( map([$_->is_circular, $_->pi('all')], $order->pi) );
+		}
+		
+		$inc->{'valid'} = incremental_build_xs(\@packed,_filtered_genes($key),$self->threads);
+		$inc->{'generation'} = $Bio::GeneOrder::GENERATION;
+		delete $inc->{'orders'};
+	}
+	return unless $inc->{'valid'};
+	
+	if($inc->{'generation'} != $Bio::GeneOrder::GENERATION){
+		incremental_sync_xs(_filtered_genes($key));
+		$inc->{'generation'} = $Bio::GeneOrder::GENERATION;
+	}
+	
+	return $inc->{'index'};
+}
+
+=head2 _filtered_genes
+
+ Title   : _filtered_genes
+ Usage   : my $packed = _filtered_genes($key);
+ Function: Packs the numbers of the genes a gene key filters as longs
+ Returns : A packed string
+
+=cut
+
+sub _filtered_genes {
+	my $key = shift;
+	
+	return pack("l*", grep(defined, map($key->{'index'}->{$_}, grep($key->{'filt'}->{$_}, keys %{$key->{'filt'}}))));
+}
+
+=head2 _save_orders
+
+ Title   : _save_orders
+ Usage   : _save_orders($file,$key,@orders);
+ Function: Saves gene orders numbered from one gene key to a file in columns:
+           the gene names, types and filters of the key, the name, source,
+           classification and filter of each gene order, and the genes of
+           every chromosome in one buffer, as described in libd/setfile.h.
+ Returns : 1 for success, 0 for failure
+ Args    : A filename, the key and the gene orders
+
+=cut
+
+sub _save_orders {
+	my ($file,$key,@orders) = @_;
+	
+	my $max = 0;
+	map( $max = $_ > $max ? $_ : $max, keys %{ $key->{'name'} });
+	my @names = map( defined $key->{'name'}->{$_} ? $key->{'name'}->{$_} : '', 1..$max);
+	my @permutations = map( $_->pi, @orders);
+	
+	return setfile_save_xs($file, {
+		'names'                 => \@names,
+		'types'                 => [ map( $key->{'type'}->{$_}, @names) ],
+		'gene_filtered'         => pack("C*", map( $key->{'filt'}->{$_} ? 1 : 0, @names)),
+		'order_names'           => [ map( $_->name, @orders) ],
+		'order_sources'         => [ map( $_->source, @orders) ],
+		'order_classifications' => [ map( join("\n", @{ $_->{'classification'} || [] }), @orders) ],
+		'order_flags'           => pack("C*", map( $_->filtered ? 1 : 0, @orders)),
+		'order_chromosomes'     => pack("L*", map( scalar @{ $_->{'pi'} }, @orders)),
+		'chromosome_sources'    => [ map( $_->source, @permutations) ],
+		'permutations'          => [ map( $_->{'pi'}, @permutations) ],
+	}) ? 1 : 0;
+}
+
+=head2 _load_orders
+
+ Title   : _load_orders
+ Usage   : my ($key,@orders) = _load_orders($file);
+ Function: Loads gene orders saved by _save_orders. The file is mapped and the
+           permutations packed straight from its gene buffer, and the objects
+           are blessed as they were saved, as Storable did, without numbering
+           their genes again. The distance workspace is sized for the largest.
+ Returns : The gene key and the gene orders, or an empty list if the file is
+           not a saved set. Throws if it is damaged.
+ Args    : A filename
+
+=cut
+
+sub _load_orders {
+	my $file = shift;
+	
+	my $handle = setfile_open_xs($file) or return ();
+	
+	my @names = setfile_strings_xs($handle,'names');
+	my @types = setfile_strings_xs($handle,'types');
+	my @filt = unpack("C*", setfile_column_xs($handle,'gene_filtered'));
+	
+	my $key = { 'index' => {}, 'name' => {}, 'type' => {}, 'filt' => {} };
+	for(my $g=1;$g<=@names;$g++){
+		my $name = $names[$g-1];
+		next unless length $name;
+		
+		$key->{'index'}->{$name} = $g;
+		$key->{'name'}->{$g} = $name;
+		$key->{'type'}->{$name} = $types[$g-1] if length $types[$g-1];
+		$key->{'filt'}->{$name} = $filt[$g-1];
+	}
+	
+	my @order_names = setfile_strings_xs($handle,'order_names');
+	my @order_sources = setfile_strings_xs($handle,'order_sources');
+	my @classifications = setfile_strings_xs($handle,'order_classifications');
+	my @flags = unpack("C*", setfile_column_xs($handle,'order_flags'));
+	my @chromosomes = unpack("L*", setfile_column_xs($handle,'order_chromosomes'));
+	my @sources = setfile_strings_xs($handle,'chromosome_sources');
+	my @circular = unpack("C*", setfile_column_xs($handle,'chromosome_circular'));
+	my @offsets = unpack("L*", setfile_column_xs($handle,'chromosome_genes'));
+	my @packed = setfile_permutations_xs($handle);
+	setfile_close_xs($handle);
+	
+	my @permutations;
+	for(my $c=0;$c<@packed;$c++){
+		my $permutation = bless { 'pi' => $packed[$c], 'key' => $key }, 'Bio::GeneOrder::permutation';
+		$permutation->{'source'} = $sources[$c] if length $sources[$c];
+		$permutation->_revise;
+		push @permutations, $permutation;
+	}
+	
+	my (@orders,$max_genes);
+	$max_genes = 0;
+	for(my $i=0;$i<@order_names;$i++){
+		my $order = bless { 'name' => $order_names[$i], 'key' => $key }, 'Bio::GeneOrder';
+		
+		$order->{'pi'} = [ @permutations[ $chromosomes[$i] .. $chromosomes[$i+1] - 1 ] ];
+		$order->{'source'} = $order_sources[$i] if length $order_sources[$i];
+		$order->{'classification'} = [ split /\n/, $classifications[$i] ] if length $classifications[$i];
+		$order->{'circular'} = $chromosomes[$i+1] - $chromosomes[$i] == 1 && $circular[ $chromosomes[$i] ] ? 1 : -1;
+		$order->{'filtered'} = $flags[$i] & 1;
+		$order->{'distance'} = Bio::GeneOrder::Distance->new();
+		
+		#the file notes which gene orders repeat no gene, and is refused as
+		#damaged on opening if one it notes does
+		$order->_packed('valid',1) if $flags[$i] & 2;
+		
+		push @orders, $order;
+		
+		my $no_genes = $offsets[ $chromosomes[$i+1] ] - $offsets[ $chromosomes[$i] ];
+		$max_genes = $no_genes if $no_genes > $max_genes;
+	}
+	
+	#size the distance workspace for the largest gene order, as Set::push does
+	Bio::GeneOrder::Distance->new()->reserve($max_genes);
+	
+	return ($key,@orders);
+}
+
+=head2 cache_file
+
+ Title   : cache_file
+ Usage   : $distanceObj->cache_file('orders.cache');
+ Function: Get/set a file in which computed distances are kept between sessions.
+           Entries are keyed by the content of the packed permutations and the
+           metric, so they stay valid for any gene orders with the same content,
+           and the file may be shared by several processes at once. Distance
+           matrices only compute the pairs that are not in the file yet.
+           Passing an empty string closes the file. A file that holds anything
+           but a distance cache is never overwritten; opening one throws.
+ Returns : The name of the cache file, or undef if none is open
+ Args    : A filename
+
+=cut
+
+sub cache_file {
+	my ($self,$file) = @_;
+	
+	if( defined $file){
+		cache_close_xs();
+		delete $self->{'cache_file'};
+		
+		if(length $file){
+			local $! = 0;
+			$self->throw("Could not open distance cache '$file': ".($! ? $! : "not a distance cache")) 
+				unless cache_open_xs($file);
+			$self->{'cache_file'} = $file;
+		}
+	}
+	
+	return $self->{'cache_file'};
+}
+
+=head2 stats
+
+ Title   : stats
+ Usage   : $stats = $distanceObj->stats;
+           printf "%d DCJ calls\n", $stats->{'timers'}{'DCJ'}{'calls'};
+ Function: Returns what the distance library has counted since it was loaded,
+           or since the last reset, summed over every thread. Each timer of
+           'timers' (adjacencies, breakpoints, inversions, DCJ, hurdles,
+           incremental and marshal) holds the calls made, the genes they
+           processed and the nanoseconds they took; a matrix cell counts as one
+           call. The time of single pairs is measured on one call in 16 and
+           estimated for the others, as reading the clock would cost as much
+           as a small pair. 'cache' counts the lookups of the distances kept in memory and
+           'cache_file' those of the cache file, each with its hits, misses and
+           hit_ratio (undef before any lookup).
+           A build made with perl Makefile.PL DEFINE=-DDIST_NO_STATS compiles
+           the counters out, and then 'enabled' is false and every count is 0.
+ Returns : Hash reference
+ Args    : 'reset' to set every count back to 0 once they have been read
+
+=cut
+
+sub stats {
+	my ($self,$reset) = @_;
+	
+	my ($enabled,$hits,$misses,@timers) = stats_xs();
+	my %stats = ( 'enabled'    => $enabled,
+				  'cache'      => _hit_ratio(@CACHE_STATS{'hits','misses'}),
+				  'cache_file' => _hit_ratio($hits,$misses),
+				  'timers'     => {} );
+	
+	while(@timers){
+		my ($name,$calls,$genes,$ns) = splice(@timers,0,4);
+		$stats{'timers'}{$name} = { 'calls' => $calls, 'genes' => $genes, 'ns' => $ns };
+	}
+	
+	if( defined $reset ){
+		$self->throw("stats takes 'reset' or nothing, not '$reset'") 
+			unless $reset eq 'reset';
+		stats_reset_xs();
+		%CACHE_STATS = ( 'hits' => 0, 'misses' => 0 );
+	}
+	
+	return \%stats;
+}
+
+=head2 _hit_ratio
+
+ Title   : _hit_ratio
+ Usage   : my $cache = _hit_ratio($hits,$misses);
+ Function: Describes the lookups of a cache for stats
+ Returns : Hash reference
+
+=cut
+
+sub _hit_ratio {
+	my ($hits,$misses) = @_;
+	
+	return { 'hits' => $hits, 'misses' => $misses,
+			 'hit_ratio' => $hits + $misses ? $hits / ($hits + $misses) : undef };
+}
+
 =head2 _cache
 
  Title   : _cache
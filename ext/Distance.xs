@@ -9,78 +9,1131 @@ extern "C" {
 #endif
 
 #include "distances.h"
+#include "invdist.h"
+#include "parallel.h"
+#include "distcache.h"
+#include "incdist.h"
+#include "goreader.h"
+#include "setfile.h"
+#include "nbrindex.h"
+#include "vptree.h"
+#include "disttree.h"
+#include "diststats.h"
 
-Genome * structify(AV * pi) {
-	int len;
-	int i;
-	SV ** elem;
-	Genome * pi_perm;
-	Genome perm;
+// The cache file shared by every distance object in this process
+static distcache_t distcache;
+
+// The gene orders whose distances are kept current across gene filters
+static incdist_t incdist;
+
+// A packed gene order is one string laid out like a GenomeDesc: a long of flags,
+// the number of chromosomes, their offsets as longs, one byte per chromosome for
+// its circular flag padded to a long, then the genes of every chromosome back to
+// back, as shorts or, when the order is wide, as longs.
+#define PACKED_WIDE		2
+
+typedef struct packed_header_struct
+{
+	int flags;
+	int num_chromosomes;
+	int offsets[1];				/* num_chromosomes + 1 of them */
+} packed_header_t;
+
+static packed_header_t * packed_header(SV * pi) {
+	STRLEN size;
+	char * packed = SvPV(pi,size);
+	packed_header_t * header = (packed_header_t *)packed;
+	
+	if(size < 3 * sizeof(int) || size < (3 + (STRLEN)header->num_chromosomes) * sizeof(int))
+		croak("Bio::GeneOrder::Distance: malformed packed gene order");
+	
+	return header;
+}
+
+// Whether a packed gene order holds 32 bit gene identifiers
+bool packed_wide(SV * pi) {
+	return packed_header(pi)->flags & PACKED_WIDE;
+}
+
+// The number of genes held as 16 bit identifiers in a packed gene order
+int packed_narrow_genes(SV * pi) {
+	packed_header_t * header = packed_header(pi);
+	
+	return header->flags & PACKED_WIDE ? 0 : header->offsets[header->num_chromosomes];
+}
+
+// Describe a packed gene order as a GenomeDesc pointing into the string itself.
+// Orders packed at the width of T are used in place, so no genes are copied.
+// Narrow orders described as 32 bit genomes are widened into the widened
+// buffer, which the caller reserves with packed_narrow_genes so it never moves.
+template <typename T>
+void structify(SV * pi, GenomeDescT<T> * genome, std::vector<T> & widened) {
+	packed_header_t * header = packed_header(pi);
+	int num = header->num_chromosomes;
+	unsigned char * circular = (unsigned char *)&header->offsets[num + 1];
+	char * genes = (char *)circular + ((num + sizeof(int) - 1) / sizeof(int)) * sizeof(int);
+	int num_genes = header->offsets[num];
+	
+	genome->offsets = header->offsets;
+	genome->circular = circular;
+	genome->num_chromosomes = num;
+	
+	if((header->flags & PACKED_WIDE) || sizeof(T) == sizeof(intArray)){
+		genome->genes = (T *)genes;
+	}else{
+		genome->genes = widened.data() + widened.size();
+		widened.insert(widened.end(),(intArray *)genes,(intArray *)genes + num_genes);
+	}
+}
+
+// The GenomeDesc of one packed gene order
+template <typename T>
+struct genome_view_T
+{
+	GenomeDescT<T> genome;
+	std::vector<T> widened;
+	
+	genome_view_T(SV * pi){
+		if(sizeof(T) > sizeof(intArray))
+			widened.reserve(packed_narrow_genes(pi));
+		structify(pi,&genome,widened);
+	}
+};
+
+// Describe the first genomes.size() packed orders, counted as one marshalling call
+template <typename T>
+void structify_orders(AV * orders, std::vector< GenomeDescT<T> > & genomes, std::vector<T> & widened) {
+	unsigned long long start = STATS_NOW();
+	unsigned long long genes = 0;
+	int n = genomes.size();
+	
+	for(int i=0;i<n;i++){
+		structify(*av_fetch(orders,i,0),&genomes[i],widened);
+		genes += genomes[i].num_genes();
+	}
+	STATS_COUNT(STAT_MARSHAL,1,genes,STATS_NOW() - start);
+}
+
+int metric_code(const char * metric) {
+	if(strEQ(metric,"adjacencies"))
+		return DIST_ADJACENCIES;
+	if(strEQ(metric,"breakpoints"))
+		return DIST_BREAKPOINTS;
+	if(strEQ(metric,"inversions"))
+		return DIST_INVERSIONS;
+	if(strEQ(metric,"DCJ"))
+		return DIST_DCJ;
+	return 0;
+}
+
+// Look a distance between two genomes up in the cache file, or compute and store it
+template <typename T>
+int cached_distance(int metric, const GenomeDescT<T> & pi, const GenomeDescT<T> & id, bool validate) {
+	int d;
+	distkey_t key = 0;
+	
+	if(distcache.is_open()){
+		key = distance_key(metric,genome_hash(pi),genome_hash(id));
+		if(distcache.get(key,pi.num_genes(),id.num_genes(),&d))
+			return d;
+	}
+	
+	switch(metric){
+		case DIST_BREAKPOINTS:
+			d = _breakpoints(pi,id);
+			break;
+		case DIST_INVERSIONS:
+			d = _inversions(pi,id,validate);
+			break;
+		case DIST_DCJ:
+			d = _DCJ(pi,id,validate);
+			break;
+		default:
+			d = ERR_NOTIMPL;
+	}
 	
-	len = av_len(pi) +1;
-	pi_perm = new Genome[len];
+	// Errors are not cached so that a later kernel may still answer them
+	if(key && d >= 0)
+		distcache.put(key,pi.num_genes(),id.num_genes(),d);
+	
+	return d;
+}
+
+// Compare two packed gene orders at the narrowest width that holds both
+int packed_distance(int metric, SV * pi, SV * id, bool validate) {
+	if(packed_wide(pi) || packed_wide(id)){
+		genome_view_T<intArray32> pi_genome(pi);
+		genome_view_T<intArray32> id_genome(id);
 		
-	for(i=0;i<len;i++){
-		elem = av_fetch(pi,i,0);
-		perm.pi = (intArray *)SvPV_nolen( *elem );
-		perm.len = SvCUR( *elem ) / sizeof(intArray) -1;
-		perm.circular = perm.pi[0];
-		perm.pi++;
+		return cached_distance(metric,pi_genome.genome,id_genome.genome,validate);
+	}
+	
+	genome_view_T<intArray> pi_genome(pi);
+	genome_view_T<intArray> id_genome(id);
+	
+	return cached_distance(metric,pi_genome.genome,id_genome.genome,validate);
+}
+
+// The shared adjacencies of two packed gene orders, as 32 bit identifiers
+template <typename T>
+std::vector<intArray32> packed_adjacencies(SV * pi, SV * id) {
+	genome_view_T<T> pi_genome(pi);
+	genome_view_T<T> id_genome(id);
+	
+	std::vector<T> shared = _adjacencies(pi_genome.genome,id_genome.genome);
+	
+	return std::vector<intArray32>(shared.begin(),shared.end());
+}
+
+// The median of three packed gene orders, at the width of the widest
+template <typename T>
+int packed_median(SV * const orders[3], int metric, double seconds, median_t & median) {
+	genome_view_T<T> a(orders[0]);
+	genome_view_T<T> b(orders[1]);
+	genome_view_T<T> c(orders[2]);
+	const GenomeDescT<T> * const genomes[3] = { &a.genome, &b.genome, &c.genome };
+	
+	return _median(genomes,metric,seconds,median);
+}
+
+// Fill the n*n matrix, consulting and updating the cache file if one is open
+template <typename T>
+void packed_matrix(AV * orders, int metric, int * matrix, int threads, bool validate) {
+	int n = av_len(orders) +1;
+	int num_narrow = 0;
+	
+	if(sizeof(T) > sizeof(intArray)){
+		for(int i=0;i<n;i++)
+			num_narrow += packed_narrow_genes(*av_fetch(orders,i,0));
+	}
+	
+	std::vector< GenomeDescT<T> > genomes(n);
+	std::vector<T> widened;
+	widened.reserve(num_narrow);
+	
+	structify_orders(orders,genomes,widened);
+	
+	std::fill(matrix,matrix + (size_t)n * n,DIST_UNKNOWN);
+	
+	// Fill in what the cache file already knows, so only new pairs are computed
+	std::vector<distkey_t> hash;
+	std::vector<char> missing;
+	if(distcache.is_open()){
+		hash.resize(n);
+		missing.assign((size_t)n * n,0);
+		for(int i=0;i<n;i++)
+			hash[i] = genome_hash(genomes[i]);
 		
-		pi_perm[i] = perm;
+		distcache.lock(false);
+		for(int i=0;i<n;i++){
+			for(int j=i;j<n;j++){
+				int d;
+				if(distcache.find(distance_key(metric,hash[j],hash[i]),genomes[j].num_genes(),genomes[i].num_genes(),&d))
+					matrix[(size_t)i * n + j] = matrix[(size_t)j * n + i] = d;
+				else
+					missing[(size_t)i * n + j] = 1;
+			}
+		}
+		distcache.unlock();
 	}
 	
-	return pi_perm;
+	_distance_matrix_parallel(genomes,metric,matrix,threads,validate);
+	
+	if(distcache.is_open()){
+		distcache.lock(true);
+		for(int i=0;i<n;i++){
+			for(int j=i;j<n;j++){
+				if(missing[(size_t)i * n + j] && matrix[(size_t)i * n + j] >= 0)
+					distcache.store(distance_key(metric,hash[j],hash[i]),genomes[j].num_genes(),genomes[i].num_genes(),
+									matrix[(size_t)i * n + j]);
+			}
+		}
+		distcache.unlock();
+	}
+}
+
+// Flags for the genes listed in a packed string of longs, indexed by gene
+std::vector<char> gene_flags(SV * list) {
+	STRLEN size;
+	int * genes = (int *)SvPV(list,size);
+	int n = size / sizeof(int);
+	std::vector<char> flags;
+	
+	for(int k=0;k<n;k++){
+		if(genes[k] <= 0)
+			continue;
+		if(genes[k] >= (int)flags.size())
+			flags.resize(genes[k] + 1,0);
+		flags[genes[k]] = 1;
+	}
+	return flags;
+}
+
+// Pack genes as Bio::GeneOrder::permutation packs them: a short of flags (1 if
+// circular, 2 if wide) and the genes as shorts, or, if any gene number does not
+// fit a short, a short of padding and the genes as longs
+SV * pack_permutation(const int * genes, int n, bool circular) {
+	int flags = circular ? 1 : 0;
+	SV * packed;
+	
+	for(int k=0;k<n;k++){
+		if(genes[k] > 32767 || genes[k] < -32767)
+			flags |= 2;
+	}
+	
+	if(flags & 2){
+		packed = newSV(2 * sizeof(short) + n * sizeof(int) + 1);
+		short * header = (short *)SvPVX(packed);
+		header[0] = flags;
+		header[1] = 0;
+		memcpy(header + 2,genes,n * sizeof(int));
+		SvCUR_set(packed,2 * sizeof(short) + n * sizeof(int));
+	}else{
+		packed = newSV((1 + n) * sizeof(short) + 1);
+		short * p = (short *)SvPVX(packed);
+		p[0] = flags;
+		for(int k=0;k<n;k++)
+			p[1 + k] = genes[k];
+		SvCUR_set(packed,(1 + n) * sizeof(short));
+	}
+	SvPOK_on(packed);
+	
+	return packed;
+}
+
+// Whether packed holds a permutation packed by Bio::GeneOrder::permutation::_pack
+static bool packed_permutation(SV * packed) {
+	STRLEN size;
+	const char * pi = SvPV(packed,size);
+	
+	return size >= sizeof(short) && (!(*(const short *)pi & 2) || size >= 2 * sizeof(short));
+}
+
+// Read the genes of a permutation packed by Bio::GeneOrder::permutation::_pack,
+// returning its flags. Callers holding C++ objects check it with
+// packed_permutation first, so it does not croak.
+static int unpack_permutation(SV * packed, std::vector<int> & genes) {
+	STRLEN size;
+	char * pi = SvPV(packed,size);
+	
+	if(!packed_permutation(packed))
+		croak("malformed packed permutation");
+	
+	int flags = *(short *)pi;
+	if(flags & 2){
+		int * p = (int *)(pi + 2 * sizeof(short));
+		genes.assign(p,p + (size - 2 * sizeof(short)) / sizeof(int));
+	}else{
+		short * p = (short *)(pi + sizeof(short));
+		genes.assign(p,p + (size - sizeof(short)) / sizeof(short));
+	}
+	return flags;
+}
+
+// The sections of a saved set by the names Bio::GeneOrder::Distance gives them
+static const char * setfile_sections[SETFILE_SECTIONS] = {
+	"names", "types", "gene_filtered", "order_names", "order_sources",
+	"order_classifications", "order_flags", "order_chromosomes",
+	"chromosome_sources", "chromosome_genes", "chromosome_circular", "genes"
+};
+
+static int setfile_section(const char * name) {
+	for(int s=0;s<SETFILE_SECTIONS;s++){
+		if(!strcmp(name,setfile_sections[s]))
+			return s;
+	}
+	croak("no section %s in a saved set",name);
+	return -1;
+}
+
+static SV * setfile_entry(HV * columns, const char * name) {
+	SV ** entry = hv_fetch(columns,name,strlen(name),0);
+	
+	if(!entry)
+		croak("setfile_save_xs: no %s column",name);
+	return *entry;
+}
+
+static AV * setfile_array(HV * columns, const char * name) {
+	SV * entry = setfile_entry(columns,name);
+	
+	if(!SvROK(entry) || SvTYPE(SvRV(entry)) != SVt_PVAV)
+		croak("setfile_save_xs: the %s column is not an array",name);
+	return (AV *)SvRV(entry);
+}
+
+static size_t setfile_length(AV * av) {
+	return av_len(av) + 1;
+}
+
+static void setfile_strings(AV * av, std::vector<std::string> & strings) {
+	int n = av_len(av) + 1;
+	
+	strings.resize(n);
+	for(int i=0;i<n;i++){
+		SV ** item = av_fetch(av,i,0);
+		STRLEN length = 0;
+		const char * p = item && SvOK(*item) ? SvPV(*item,length) : "";
+		strings[i].assign(p,length);
+	}
+}
+
+template <typename T>
+static void setfile_bytes(SV * entry, std::vector<T> & column) {
+	STRLEN size;
+	const char * p = SvPV(entry,size);
+	
+	column.assign((const T *)p,(const T *)p + size / sizeof(T));
+}
+
+// Distances between the packed gene orders of an array, and from a query to
+// them, for vptree. The gene orders hold no duplicates and, for DCJ, the same
+// genes, so they are not validated again. A failed distance is recorded in error,
+// with the gene orders it failed on, and returned so vptree stops; the caller
+// croaks once the tree is out of scope.
+#define PACKED_MISSING	INT_MIN
+
+struct packed_distances_t
+{
+	AV * orders;
+	int metric;
+	int error;					/* the failed distance, PACKED_MISSING or 0 */
+	int error_i;				/* the gene orders it failed on, -1 for the query */
+	int error_j;
+	
+	SV * order(int i) {
+		SV ** packed = av_fetch(orders,i,0);
+		return packed ? *packed : NULL;
+	}
+	int fail(int d, int i, int j) {
+		error = d;
+		error_i = i;
+		error_j = j;
+		return d;
+	}
+	int operator()(int i, int j) {
+		SV * pi = order(i);
+		SV * id = order(j);
+		if(!pi || !id)
+			return fail(PACKED_MISSING,i,pi ? j : i);
+		
+		int d = packed_distance(metric,pi,id,false);
+		return d < 0 ? fail(d,i,j) : d;
+	}
+};
+
+struct packed_query_t
+{
+	packed_distances_t * index;
+	SV * query;
+	int num_distances;
+	
+	int operator()(int i) {
+		SV * id = index->order(i);
+		if(!id)
+			return index->fail(PACKED_MISSING,i,i);
+		
+		int d = packed_distance(index->metric,query,id,false);
+		num_distances++;
+		return d < 0 ? index->fail(d,-1,i) : d;
+	}
+};
+
+// Croak with the error a vptree build or query stopped on
+static void packed_distances_croak(const char * function, const packed_distances_t & distances) {
+	if(distances.error == PACKED_MISSING)
+		croak("%s: no gene order %d in the index",function,distances.error_j);
+	if(distances.error_i < 0)
+		croak("%s: the gene order can not be compared with gene order %d (%d)",function,distances.error_j,distances.error);
+	croak("%s: gene orders %d and %d can not be compared (%d)",function,distances.error_i,distances.error_j,distances.error);
 }
 
 MODULE = Bio::GeneOrder::Distance		PACKAGE = Bio::GeneOrder::Distance
 
 PROTOTYPES: ENABLE
 
-intArray *
+intArray32 *
 adjacencies_xs(pi,id)
-	AV * pi
-	AV * id
+	SV * pi
+	SV * id
 	CODE:
-		Genome * pi_genome = structify(pi);
-		Genome * id_genome = structify(id);
-		
-		std::vector<intArray> shared = _adjacencies(pi_genome,id_genome);
-		
-		delete pi_genome;
-		delete id_genome;
+		std::vector<intArray32> shared = packed_wide(pi) || packed_wide(id)
+			? packed_adjacencies<intArray32>(pi,id) : packed_adjacencies<intArray>(pi,id);
 
 		int size_RETVAL = shared.size();
-		RETVAL = &shared[0];
+		RETVAL = shared.data();
 	OUTPUT:
 		RETVAL
 
 int
 breakpoints_xs(pi,id)
-	AV * pi
-	AV * id
+	SV * pi
+	SV * id
 	CODE:
-		Genome * pi_genome = structify(pi);
-		Genome * id_genome = structify(id);
+		RETVAL = packed_distance(DIST_BREAKPOINTS,pi,id,false);
+	OUTPUT:
+		RETVAL
 		
-		RETVAL = _breakpoints(pi_genome,id_genome);
+int
+inversions_xs(pi,id,validate=1)
+	SV * pi
+	SV * id
+	int validate
+	CODE:
+		RETVAL = packed_distance(DIST_INVERSIONS,pi,id,validate);
+	OUTPUT:
+		RETVAL
+
+int
+DCJ_xs(pi,id,validate=1)
+	SV * pi
+	SV * id
+	int validate
+	CODE:
+		RETVAL = packed_distance(DIST_DCJ,pi,id,validate);
+	OUTPUT:
+		RETVAL
+
+void
+inversion_scenario_xs(pi,id)
+	SV * pi
+	SV * id
+	PPCODE:
+		int d;
+		{
+			std::vector<inversion_t> scenario;
+			if(packed_wide(pi) || packed_wide(id)){
+				genome_view_T<intArray32> pi_genome(pi);
+				genome_view_T<intArray32> id_genome(id);
+				d = _inversion_scenario<intArray32>(pi_genome.genome,id_genome.genome,scenario);
+			}else{
+				genome_view_T<intArray> pi_genome(pi);
+				genome_view_T<intArray> id_genome(id);
+				d = _inversion_scenario<intArray>(pi_genome.genome,id_genome.genome,scenario);
+			}
+			
+			// The first and last position of each inversion, in the order they apply
+			if(d >= 0){
+				EXTEND(SP,2 * scenario.size());
+				for(size_t i=0;i<scenario.size();i++){
+					PUSHs(sv_2mortal(newSViv(scenario[i].first)));
+					PUSHs(sv_2mortal(newSViv(scenario[i].last)));
+				}
+			}
+		}
+		// Croak once the scenario is destroyed, as croak does not unwind C++ scopes
+		if(d < 0)
+			croak("inversion_scenario_xs: the gene orders have no inversion scenario (%d)",d);
+
+void
+median_xs(metric,a,b,c,seconds=0)
+	char * metric
+	SV * a
+	SV * b
+	SV * c
+	double seconds
+	PPCODE:
+		SV * const orders[3] = { a, b, c };
+		int score;
+		{
+			median_t median;
+			if(packed_wide(a) || packed_wide(b) || packed_wide(c))
+				score = packed_median<intArray32>(orders,metric_code(metric),seconds,median);
+			else
+				score = packed_median<intArray>(orders,metric_code(metric),seconds,median);
+			
+			// The score, its lower bound, whether it is optimal and the genomes scored,
+			// then the circular flag, length and genes of each chromosome
+			if(score >= 0){
+				EXTEND(SP,4 + 2 * median.circular.size() + median.genes.size());
+				PUSHs(sv_2mortal(newSViv(score)));
+				PUSHs(sv_2mortal(newSViv(median.lower_bound)));
+				PUSHs(sv_2mortal(newSViv(median.optimal)));
+				PUSHs(sv_2mortal(newSViv(median.evaluated)));
+				for(size_t i=0;i<median.circular.size();i++){
+					PUSHs(sv_2mortal(newSViv(median.circular[i])));
+					PUSHs(sv_2mortal(newSViv(median.offsets[i+1] - median.offsets[i])));
+					for(int g=median.offsets[i];g<median.offsets[i+1];g++)
+						PUSHs(sv_2mortal(newSViv(median.genes[g])));
+				}
+			}
+		}
+		// Croak once the median is destroyed, as croak does not unwind C++ scopes
+		if(score < 0)
+			croak("median_xs: no %s median of the gene orders (%d)",metric,score);
+
+int
+validate_xs(pi)
+	SV * pi
+	CODE:
+		if(packed_wide(pi)){
+			genome_view_T<intArray32> genome(pi);
+			RETVAL = _validate<intArray32>(genome.genome,NULL);
+		}else{
+			genome_view_T<intArray> genome(pi);
+			RETVAL = _validate<intArray>(genome.genome,NULL);
+		}
+	OUTPUT:
+		RETVAL
+
+SV *
+signature_xs(pi)
+	SV * pi
+	CODE:
+		std::vector<unsigned long long> signature;
+		if(packed_wide(pi)){
+			genome_view_T<intArray32> genome(pi);
+			_adjacency_signature<intArray32>(genome.genome,signature);
+		}else{
+			genome_view_T<intArray> genome(pi);
+			_adjacency_signature<intArray>(genome.genome,signature);
+		}
+		RETVAL = newSVpvn((const char *)signature.data(),signature.size() * sizeof(unsigned long long));
+	OUTPUT:
+		RETVAL
+
+SV *
+neighbors_build_xs(matrix,n)
+	SV * matrix
+	int n
+	CODE:
+		STRLEN size;
+		const int * distances = (const int *)SvPV(matrix,size);
+		
+		if(n < 0 || size < (size_t)n * n * sizeof(int))
+			croak("neighbors_build_xs: the matrix has fewer than %d rows",n);
+		
+		RETVAL = newSV((size_t)n * n * sizeof(int) + 1);
+		nbrindex_sort(distances,n,(int *)SvPVX(RETVAL));
+		SvCUR_set(RETVAL,(size_t)n * n * sizeof(int));
+		SvPOK_on(RETVAL);
+	OUTPUT:
+		RETVAL
+
+int
+neighbors_count_xs(matrix,sorted,n,i,d,above,excluded)
+	SV * matrix
+	SV * sorted
+	int n
+	int i
+	int d
+	int above
+	SV * excluded
+	CODE:
+		STRLEN size, sorted_size, excluded_size;
+		const int * distances = (const int *)SvPV(matrix,size);
+		const int * rows = (const int *)SvPV(sorted,sorted_size);
+		const int * skip = (const int *)SvPV(excluded,excluded_size);
+		
+		if(size < (size_t)n * n * sizeof(int) || sorted_size < size || i < 0 || i >= n)
+			croak("neighbors_count_xs: no row %d in the index",i);
+		
+		RETVAL = nbrindex_count(distances,rows,n,i,d,above,skip,excluded_size / sizeof(int));
+	OUTPUT:
+		RETVAL
+
+SV *
+distance_tree_xs(matrix,method,names)
+	SV * matrix
+	char * method
+	AV * names
+	CODE:
+		STRLEN size;
+		const int * distances = (const int *)SvPV(matrix,size);
+		int n = av_len(names) + 1;
+		bool nj = strEQ(method,"NJ");
+		
+		// Every input is checked before the tree exists, as croak does not unwind
+		// C++ scopes
+		if(!nj && !strEQ(method,"UPGMA"))
+			croak("distance_tree_xs: unsupported method '%s'",method);
+		if(size != (size_t)n * n * sizeof(int))
+			croak("distance_tree_xs: the matrix does not have %d rows",n);
+		for(int i=0;i<n;i++){
+			if(!av_fetch(names,i,0))
+				croak("distance_tree_xs: gene order %d has no name",i + 1);
+			for(int j=0;j<n;j++){
+				if(distances[(size_t)i * n + j] < 0)
+					croak("distance_tree_xs: no distance between gene orders %d and %d",i + 1,j + 1);
+			}
+		}
+		
+		{
+			std::vector<std::string> labels(n);
+			disttree_t tree;
+			
+			for(int i=0;i<n;i++){
+				STRLEN length;
+				const char * name = SvPV(*av_fetch(names,i,0),length);
+				labels[i].assign(name,length);
+			}
+			
+			if(nj)
+				disttree_nj(distances,n,tree);
+			else
+				disttree_upgma(distances,n,tree);
+			
+			std::string newick = disttree_newick(tree,labels);
+			RETVAL = newSVpvn(newick.data(),newick.size());
+		}
+	OUTPUT:
+		RETVAL
+
+SV *
+vptree_build_xs(orders,metric)
+	AV * orders
+	char * metric
+	CODE:
+		packed_distances_t distances = { orders, metric_code(metric), 0, 0, 0 };
+		
+		if(distances.metric != DIST_BREAKPOINTS && distances.metric != DIST_DCJ)
+			croak("vptree_build_xs: %s is not a metric the index supports",metric);
 		
-		delete pi_genome;
-		delete id_genome;
+		{
+			std::vector<vpnode_t> nodes;
+			
+			RETVAL = vptree_build(av_len(orders) + 1,distances,nodes) < 0 ? NULL
+				: newSVpvn((const char *)nodes.data(),nodes.size() * sizeof(vpnode_t));
+		}
+		if(!RETVAL)
+			packed_distances_croak("vptree_build_xs",distances);
 	OUTPUT:
 		RETVAL
+
+void
+vptree_nearest_xs(orders,tree,metric,query,k,skip)
+	AV * orders
+	SV * tree
+	char * metric
+	SV * query
+	int k
+	SV * skip
+	PPCODE:
+		STRLEN size, skip_size;
+		const vpnode_t * nodes = (const vpnode_t *)SvPV(tree,size);
+		const unsigned char * skipped = (const unsigned char *)SvPV(skip,skip_size);
+		int n = av_len(orders) + 1;
+		packed_distances_t distances = { orders, metric_code(metric), 0, 0, 0 };
+		packed_query_t distance = { &distances, query, 0 };
+		
+		if(size != n * sizeof(vpnode_t) || (skip_size && skip_size != (STRLEN)n))
+			croak("vptree_nearest_xs: the index does not match its %d gene orders",n);
+		
+		{
+			std::vector< std::pair<int,int> > nearest;
+			
+			if(vptree_nearest(nodes,n,k,distance,skip_size ? skipped : NULL,nearest) == 0){
+				// The item and distance of each of the nearest, then the number of distances computed
+				EXTEND(SP,2 * nearest.size() + 1);
+				for(size_t r=0;r<nearest.size();r++){
+					PUSHs(sv_2mortal(newSViv(nearest[r].second)));
+					PUSHs(sv_2mortal(newSViv(nearest[r].first)));
+				}
+				PUSHs(sv_2mortal(newSViv(distance.num_distances)));
+			}
+		}
+		if(distances.error)
+			packed_distances_croak("vptree_nearest_xs",distances);
+
+int
+cache_open_xs(path)
+	char * path
+	CODE:
+		RETVAL = distcache.open(path);
+	OUTPUT:
+		RETVAL
+
+void
+cache_close_xs()
+	CODE:
+		distcache.close();
+
+void
+stats_xs()
+	PPCODE:
+		unsigned long long values[STAT_VALUES];
+		diststats_read(values);
+		
+		// Whether counting is compiled in, the cache hits and misses, then the
+		// name, calls, genes and nanoseconds of each timer
+		EXTEND(SP,3 + STAT_TIMERS * 4);
+		PUSHs(sv_2mortal(newSViv(diststats_enabled())));
+		PUSHs(sv_2mortal(newSVuv((UV)values[STAT_CACHE_HITS])));
+		PUSHs(sv_2mortal(newSVuv((UV)values[STAT_CACHE_MISSES])));
+		for(int t=0;t<STAT_TIMERS;t++){
+			PUSHs(sv_2mortal(newSVpv(diststats_names[t],0)));
+			PUSHs(sv_2mortal(newSVuv((UV)values[t * STAT_PER_TIMER + STAT_CALLS])));
+			PUSHs(sv_2mortal(newSVuv((UV)values[t * STAT_PER_TIMER + STAT_GENES])));
+			PUSHs(sv_2mortal(newSVuv((UV)values[t * STAT_PER_TIMER + STAT_NS])));
+		}
+
+void
+stats_reset_xs()
+	CODE:
+		diststats_reset();
+
+void
+reserve_xs(num_genes)
+	int num_genes
+	CODE:
+		distmem_pool(num_genes);
+
+SV *
+distance_matrix_xs(orders,metric,threads=1,validate=1)
+	AV * orders
+	char * metric
+	int threads
+	int validate
+	CODE:
+		int code = metric_code(metric);
+		if(!code)
+			croak("distance_matrix_xs: unsupported metric '%s'",metric);
+		
+		int n = av_len(orders) +1;
+		bool wide = false;
+		
+		for(int i=0;i<n;i++){
+			SV ** elem = av_fetch(orders,i,0);
+			if(!elem || !SvPOK(*elem))
+				croak("distance_matrix_xs: orders must be packed gene orders");
+			if(packed_wide(*elem))
+				wide = true;
+		}
+		
+		// The matrix is returned as one packed buffer of n*n native ints
+		RETVAL = newSV((size_t)n * n * sizeof(int) + 1);
+		SvPOK_on(RETVAL);
+		SvCUR_set(RETVAL, (size_t)n * n * sizeof(int));
+		
+		// One wide order makes the whole matrix use 32 bit identifiers
+		if(wide)
+			packed_matrix<intArray32>(orders,code,(int *)SvPVX(RETVAL),threads,validate);
+		else
+			packed_matrix<intArray>(orders,code,(int *)SvPVX(RETVAL),threads,validate);
+	OUTPUT:
+		RETVAL
+
+int
+incremental_build_xs(orders,hidden,threads=1)
+	AV * orders
+	SV * hidden
+	int threads
+	CODE:
+		int n = av_len(orders) +1;
+		int num_narrow = 0;
+		
+		for(int i=0;i<n;i++){
+			SV ** elem = av_fetch(orders,i,0);
+			if(!elem || !SvPOK(*elem))
+				croak("incremental_build_xs: orders must be packed gene orders");
+			num_narrow += packed_narrow_genes(*elem);
+		}
+		
+		std::vector<GenomeDesc32> genomes(n);
+		std::vector<intArray32> widened;
+		widened.reserve(num_narrow);
+		
+		structify_orders(orders,genomes,widened);
 		
+		RETVAL = incdist.build(genomes,gene_flags(hidden),threads);
+	OUTPUT:
+		RETVAL
+
+int
+incremental_sync_xs(hidden)
+	SV * hidden
+	CODE:
+		RETVAL = incdist.sync(gene_flags(hidden));
+	OUTPUT:
+		RETVAL
+
 int
-inversions_xs(pi,id)
-	AV * pi
-	AV * id
+incremental_distance_xs(metric,i,j)
+	char * metric
+	int i
+	int j
+	CODE:
+		int code = metric_code(metric);
+		if(code != DIST_ADJACENCIES && code != DIST_BREAKPOINTS)
+			croak("incremental_distance_xs: unsupported metric '%s'",metric);
+		if(i < 0 || j < 0 || i >= incdist.num_genomes || j >= incdist.num_genomes)
+			croak("incremental_distance_xs: no gene order %d",i < 0 || i >= incdist.num_genomes ? i : j);
+		
+		RETVAL = incdist.distance(code,i,j);
+	OUTPUT:
+		RETVAL
+
+SV *
+incremental_matrix_xs(metric,indices)
+	char * metric
+	SV * indices
+	CODE:
+		int code = metric_code(metric);
+		if(code != DIST_ADJACENCIES && code != DIST_BREAKPOINTS)
+			croak("incremental_matrix_xs: unsupported metric '%s'",metric);
+		
+		STRLEN size;
+		int * index = (int *)SvPV(indices,size);
+		int n = size / sizeof(int);
+		
+		for(int i=0;i<n;i++){
+			if(index[i] < 0 || index[i] >= incdist.num_genomes)
+				croak("incremental_matrix_xs: no gene order %d",index[i]);
+		}
+		
+		RETVAL = newSV((size_t)n * n * sizeof(int) + 1);
+		SvPOK_on(RETVAL);
+		SvCUR_set(RETVAL, (size_t)n * n * sizeof(int));
+		
+		int * matrix = (int *)SvPVX(RETVAL);
+		unsigned long long start = STATS_NOW();
+		for(int i=0;i<n;i++){
+			for(int j=0;j<n;j++)
+				matrix[(size_t)i * n + j] = incdist.distance(code,index[i],index[j]);
+		}
+		// The cells are looked up rather than computed, so they count no genes
+		STATS_COUNT(code == DIST_ADJACENCIES ? STAT_ADJACENCIES : STAT_BREAKPOINTS,(unsigned long long)n * n,0,STATS_NOW() - start);
+	OUTPUT:
+		RETVAL
+
+void
+incremental_clear_xs()
+	CODE:
+		incdist.clear();
+
+IV
+fasta_open_xs(path)
+	char * path
+	CODE:
+		goreader_t * reader = new goreader_t;
+		if(!reader->open(path)){
+			delete reader;
+			reader = NULL;
+		}
+		RETVAL = PTR2IV(reader);
+	OUTPUT:
+		RETVAL
+
+void
+fasta_next_xs(handle)
+	IV handle
+	PPCODE:
+		goreader_t * reader = INT2PTR(goreader_t *,handle);
+		int read = reader->next();
+		
+		if(read < 0)
+			croak("line %d: gene order found before the '>' line naming it",reader->line);
+		
+		// The name of the gene order followed by each of its chromosomes
+		if(read > 0){
+			EXTEND(SP,reader->num_chromosomes() + 1);
+			PUSHs(sv_2mortal(newSVpvn(reader->name,reader->name_length)));
+			for(int c=0;c<reader->num_chromosomes();c++){
+				int begin = reader->offsets[c];
+				PUSHs(sv_2mortal(pack_permutation(&reader->genes[begin],reader->offsets[c+1] - begin,reader->circular[c])));
+			}
+		}
+
+void
+fasta_names_xs(handle,first)
+	IV handle
+	int first
+	PPCODE:
+		goreader_t * reader = INT2PTR(goreader_t *,handle);
+		int n = reader->names.size();
+		
+		// The names of genes first .. n, in the order they were numbered
+		if(first < 1)
+			first = 1;
+		if(first <= n)
+			EXTEND(SP,n - first + 1);
+		for(int g=first;g<=n;g++)
+			PUSHs(sv_2mortal(newSVpvn(reader->names[g-1].data(),reader->names[g-1].size())));
+
+void
+fasta_close_xs(handle)
+	IV handle
+	CODE:
+		delete INT2PTR(goreader_t *,handle);
+
+SV *
+renumber_xs(packed,table)
+	SV * packed
+	SV * table
+	CODE:
+		STRLEN table_size;
+		int * to = (int *)SvPV(table,table_size);
+		int num_to = table_size / sizeof(int);
+		int missing = -1;
+		
+		if(!packed_permutation(packed))
+			croak("renumber_xs: malformed packed permutation");
+		
+		RETVAL = NULL;
+		{
+			std::vector<int> genes;
+			int flags = unpack_permutation(packed,genes);
+			
+			for(size_t k=0;k<genes.size() && missing < 0;k++){
+				int g = abs(genes[k]);
+				if(g >= num_to || to[g] <= 0)
+					missing = g;
+				else
+					genes[k] = genes[k] < 0 ? -to[g] : to[g];
+			}
+			
+			if(missing < 0)
+				RETVAL = pack_permutation(genes.data(),genes.size(),flags & 1);
+		}
+		// Croak once the genes are destroyed, as croak does not unwind C++ scopes
+		if(missing >= 0)
+			croak("renumber_xs: gene %d has no new number",missing);
+	OUTPUT:
+		RETVAL
+
+bool
+setfile_save_xs(path,columns)
+	char * path
+	HV * columns
+	CODE:
+		AV * names = setfile_array(columns,"names");
+		AV * types = setfile_array(columns,"types");
+		AV * order_names = setfile_array(columns,"order_names");
+		AV * order_sources = setfile_array(columns,"order_sources");
+		AV * order_classifications = setfile_array(columns,"order_classifications");
+		AV * chromosome_sources = setfile_array(columns,"chromosome_sources");
+		AV * permutations = setfile_array(columns,"permutations");
+		SV * gene_filtered = setfile_entry(columns,"gene_filtered");
+		SV * order_flags = setfile_entry(columns,"order_flags");
+		SV * order_chromosomes = setfile_entry(columns,"order_chromosomes");
+		
+		size_t num_names = setfile_length(names);
+		size_t num_orders = setfile_length(order_names);
+		size_t num_chromosomes = setfile_length(chromosome_sources);
+		STRLEN filtered_size, flags_size, counts_size;
+		
+		SvPV(gene_filtered,filtered_size);
+		SvPV(order_flags,flags_size);
+		const char * counts = SvPV(order_chromosomes,counts_size);
+		
+		// Every column is checked before the C++ columns exist, as croak does not
+		// unwind C++ scopes
+		if(setfile_length(types) != num_names || filtered_size != num_names ||
+			setfile_length(order_sources) != num_orders || setfile_length(order_classifications) != num_orders ||
+			flags_size != num_orders || counts_size != num_orders * sizeof(unsigned int))
+			croak("setfile_save_xs: columns of different lengths");
+		if(setfile_length(permutations) != num_chromosomes)
+			croak("setfile_save_xs: expected %lu permutations",(unsigned long)num_chromosomes);
+		
+		// The number of chromosomes of each gene order, and a packed permutation for each
+		unsigned long long total = 0;
+		for(size_t i=0;i<num_orders;i++){
+			unsigned int count;
+			memcpy(&count,counts + i * sizeof(unsigned int),sizeof(unsigned int));
+			total += count;
+		}
+		if(total != num_chromosomes)
+			croak("setfile_save_xs: expected %llu permutations",total);
+		for(size_t c=0;c<num_chromosomes;c++){
+			SV ** packed = av_fetch(permutations,c,0);
+			if(!packed || !packed_permutation(*packed))
+				croak("setfile_save_xs: permutation %lu is malformed",(unsigned long)c);
+		}
+		
+		{
+			setfile_columns_t set;
+			std::vector<unsigned int> chromosomes;
+			std::vector<int> genes;
+			
+			setfile_strings(names,set.names);
+			setfile_strings(types,set.types);
+			setfile_bytes(gene_filtered,set.gene_filtered);
+			setfile_strings(order_names,set.order_names);
+			setfile_strings(order_sources,set.order_sources);
+			setfile_strings(order_classifications,set.order_classifications);
+			setfile_bytes(order_flags,set.order_flags);
+			setfile_strings(chromosome_sources,set.chromosome_sources);
+			
+			setfile_bytes(order_chromosomes,chromosomes);
+			set.order_chromosomes.assign(1,0);
+			for(size_t i=0;i<num_orders;i++)
+				set.order_chromosomes.push_back(set.order_chromosomes.back() + chromosomes[i]);
+			
+			set.chromosome_genes.assign(1,0);
+			for(size_t c=0;c<num_chromosomes;c++){
+				int flags = unpack_permutation(*av_fetch(permutations,c,0),genes);
+				set.genes.insert(set.genes.end(),genes.begin(),genes.end());
+				set.chromosome_genes.push_back(set.genes.size());
+				set.chromosome_circular.push_back(flags & 1);
+			}
+			
+			RETVAL = setfile_write(path,set);
+		}
+	OUTPUT:
+		RETVAL
+
+IV
+setfile_open_xs(path)
+	char * path
 	CODE:
-		Genome * pi_genome = structify(pi);
-		Genome * id_genome = structify(id);
+		setfile_t * set = new setfile_t;
+		int opened = set->open(path);
 		
-		RETVAL = _inversions(pi_genome,id_genome);
+		if(opened <= 0){
+			delete set;
+			set = NULL;
+		}
+		if(opened < 0)
+			croak("%s is a damaged saved set, or one saved by another version or on another machine",path);
+		RETVAL = PTR2IV(set);
+	OUTPUT:
+		RETVAL
+
+void
+setfile_strings_xs(handle,section)
+	IV handle
+	char * section
+	PPCODE:
+		setfile_t * set = INT2PTR(setfile_t *,handle);
+		int s = setfile_section(section);
+		unsigned int n = set->num_strings(s);
 		
-		delete pi_genome;
-		delete id_genome;
+		EXTEND(SP,n);
+		for(unsigned int i=0;i<n;i++){
+			size_t length;
+			const char * p = set->string(s,i,&length);
+			PUSHs(sv_2mortal(newSVpvn(p,length)));
+		}
+
+SV *
+setfile_column_xs(handle,section)
+	IV handle
+	char * section
+	CODE:
+		setfile_t * set = INT2PTR(setfile_t *,handle);
+		int s = setfile_section(section);
+		
+		RETVAL = newSVpvn((const char *)set->section(s),set->header->length[s]);
 	OUTPUT:
-		RETVAL
\ No newline at end of file
+		RETVAL
+
+void
+setfile_permutations_xs(handle)
+	IV handle
+	PPCODE:
+		setfile_t * set = INT2PTR(setfile_t *,handle);
+		const unsigned int * offsets = (const unsigned int *)set->section(SETFILE_CHROMOSOME_GENES);
+		const unsigned char * circular = (const unsigned char *)set->section(SETFILE_CHROMOSOME_CIRCULAR);
+		const int * genes = (const int *)set->section(SETFILE_GENES);
+		unsigned int n = set->header->num_chromosomes;
+		
+		// Every chromosome of every gene order, packed as a permutation
+		EXTEND(SP,n);
+		for(unsigned int c=0;c<n;c++)
+			PUSHs(sv_2mortal(pack_permutation(genes + offsets[c],offsets[c+1] - offsets[c],circular[c])));
+
+void
+setfile_close_xs(handle)
+	IV handle
+	CODE:
+		delete INT2PTR(setfile_t *,handle);
@@ -0,0 +1,130 @@
+#include "adjindex.h"
+
+template <typename T>
+void adjindex_T<T>::insert(key_t key){
+	unsigned int slot = adjacency_slot(key,bits);
+
+	while(table[slot]){
+		if(table[slot] == key){
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	table[slot] = key;
+}
+
+template <typename T>
+bool adjindex_T<T>::build_direct(const GenomeDescT<T> & id){
+	typedef gene_traits<T> traits;
+	int c,k;
+	const T * p = id.genes;
+	size_t size = PARTNER_SIZE;
+	
+	// A 32 bit genome gets a table as long as its own extremities, as long as
+	// its largest gene keeps that table moderate
+	if(sizeof(T) > sizeof(intArray)){
+		int n = id.num_genes();
+		int max_gene = 0;
+		
+		for(k=0;k<n;k++){
+			int g = p[k] < 0 ? -p[k] : p[k];
+			if(g > max_gene){
+				max_gene = g;
+			}
+		}
+		if(max_gene > traits::max_direct_gene){
+			return false;
+		}
+		size = 2 * max_gene + 2;
+	}
+	if(partner.size() < size){
+		partner.resize(size,0);
+	}
+	
+	// Stamps live in the top bits of an entry; when they run out start afresh
+	unsigned int max_stamp = ~0u >> (32 - traits::stamp_shift);
+	if(++stamp > max_stamp || stamp == 0){
+		std::fill(partner.begin(),partner.end(),0);
+		stamp = 1;
+	}
+	
+	partner_t tag = (partner_t)stamp << traits::stamp_shift;
+	partner_t * q = partner.data();
+	num_adjacencies = 0;
+	
+	for(c=0;c<id.num_chromosomes;c++){
+		int begin = id.offsets[c];
+		int end = id.offsets[c+1];
+		
+		for(k=begin;k<=end-1;k++){
+			int a,b;
+			
+			if(k < end-1){
+				a = p[k];
+				b = p[k+1];
+			}else if(id.circular[c]){
+				// A circular chromosome also has the boundary between its ends
+				a = p[end-1];
+				b = p[begin];
+			}else{
+				break;
+			}
+			
+			unsigned int e = right_extremity(a);
+			unsigned int f = left_extremity(b);
+			
+			if(((q[e] >> traits::stamp_shift) == stamp && q[e] != (tag | f)) ||
+			   ((q[f] >> traits::stamp_shift) == stamp && q[f] != (tag | e))){
+				return false;
+			}
+			q[e] = tag | f;
+			q[f] = tag | e;
+			num_adjacencies++;
+		}
+	}
+	
+	return true;
+}
+
+template <typename T>
+void adjindex_T<T>::build(const GenomeDescT<T> & id){
+	int c,k;
+	int size = id.num_genes();
+	
+	direct = adjmatch_enabled() && build_direct(id);
+	if(direct){
+		return;
+	}
+
+	// Keep the load factor at or below one half
+	bits = 2;
+	while((1 << bits) < 2 * size){
+		bits++;
+	}
+	mask = (1u << bits) - 1;
+
+	table.assign(1 << bits, 0);
+	num_adjacencies = 0;
+
+	const T * p = id.genes;
+
+	for(c=0;c<id.num_chromosomes;c++){
+		int begin = id.offsets[c];
+		int end = id.offsets[c+1];
+
+		for(k=begin;k<end-1;k++){
+			insert(adjacency_key<T>(p[k],p[k+1]));
+			num_adjacencies++;
+		}
+
+		// A circular chromosome also has the boundary between its ends
+		if(id.circular[c] && end > begin){
+			insert(adjacency_key<T>(p[end-1],p[begin]));
+			num_adjacencies++;
+		}
+	}
+}
+
+template struct adjindex_T<intArray>;
+template struct adjindex_T<intArray32>;
@@ -0,0 +1,105 @@
+#ifndef ADJINDEX_H
+#define ADJINDEX_H
+
+#include <vector>
+#include "structs.h"
+#include "adjmatch.h"
+
+// A signed adjacency (a,b) is the same boundary as (-b,-a) read from the other strand.
+// Both readings are packed into keys twice the width of a gene identifier and the
+// smaller one is used as the canonical key.
+template <typename T>
+inline typename gene_traits<T>::key adjacency_key(int a, int b){
+	typedef typename gene_traits<T>::ugene ugene;
+	typedef typename gene_traits<T>::key key;
+	
+	key k1 = ((key)(ugene)a << (8 * sizeof(ugene))) | (ugene)b;
+	key k2 = ((key)(ugene)(-b) << (8 * sizeof(ugene))) | (ugene)(-a);
+
+	return k1 < k2 ? k1 : k2;
+}
+
+// Fibonacci hashing of a key into a table of 1 << bits slots
+inline unsigned int adjacency_slot(unsigned int key, int bits){
+	return (key * 2654435761u) >> (32 - bits);
+}
+inline unsigned int adjacency_slot(unsigned long long key, int bits){
+	return (key * 11400714819323198485ULL) >> (64 - bits);
+}
+
+// Open addressing hash set of the canonical adjacencies of one genome.
+// Building the index is linear in the number of genes and each lookup is O(1),
+// so comparing two genomes no longer needs a scan of every pair of boundaries.
+// Genomes skip the hashing and index their adjacencies directly by gene
+// extremity instead (see adjmatch.h), unless a repeated gene gives an extremity
+// two partners or, for 32 bit genomes, a gene is above max_direct_gene. A hashed
+// lookup of a 32 bit genome costs over ten times a direct one, so the hash is
+// only the fallback. The storage is kept between builds so one index can be reused.
+template <typename T>
+struct adjindex_T
+{
+	typedef typename gene_traits<T>::key key_t;
+	typedef typename gene_traits<T>::partner partner_t;
+	
+	std::vector<key_t> table;			/* canonical keys, 0 marks an empty slot */
+	std::vector<partner_t> partner;		/* or the partner of every extremity */
+	unsigned int stamp;					/* of the entries of partner from this build */
+	bool direct;						/* whether partner is used instead of table */
+	unsigned int mask;
+	int bits;
+	int num_adjacencies;				/* adjacencies indexed, counting repeats */
+
+	adjindex_T(){
+		stamp = 0;
+		direct = false;
+		mask = 0;
+		bits = 0;
+		num_adjacencies = 0;
+	}
+
+	void build(const GenomeDescT<T> & id);
+
+	bool contains(int a, int b) const {
+		if(direct){
+			return contains_direct(a,b);
+		}
+		return contains_hashed(a,b);
+	}
+
+	// contains, for an index known to be direct. The table of a 32 bit genome
+	// ends at its own largest gene, so a larger gene is in no adjacency of it:
+	// it is looked up in entry 0, which no extremity uses, without a branch.
+	bool contains_direct(int a, int b) const {
+		unsigned int e = right_extremity(a);
+
+		e = e < partner.size() ? e : 0;
+		return partner[e] == ((partner_t)stamp << gene_traits<T>::stamp_shift | (unsigned int)left_extremity(b));
+	}
+
+	// contains, for an index known not to be direct
+	bool contains_hashed(int a, int b) const {
+		key_t key = adjacency_key<T>(a,b);
+		unsigned int slot = adjacency_slot(key,bits);
+
+		while(table[slot]){
+			if(table[slot] == key){
+				return true;
+			}
+			slot = (slot + 1) & mask;
+		}
+
+		return false;
+	}
+
+	void insert(key_t key);
+
+	// Fill partner with the adjacencies of id, or return false if an extremity
+	// has two different partners or a gene is too large to index directly
+	bool build_direct(const GenomeDescT<T> & id);
+
+};
+
+typedef adjindex_T<intArray> adjindex_t;
+typedef adjindex_T<intArray32> adjindex32_t;
+
+#endif
@@ -0,0 +1,192 @@
+#include <string.h>
+#include "adjmatch.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ADJMATCH_X86
+#include <immintrin.h>
+#endif
+
+typedef int (*count_fn)(const GenomeDesc &, const unsigned int *, unsigned int, int *);
+
+typedef struct adjmatch_struct
+{
+	const char * isa;
+	count_fn count;				/* NULL to use the hash index */
+} adjmatch_t;
+
+// The adjacencies from gene k onwards that the vector loop left over, and the
+// boundary between the ends of a circular chromosome
+static inline int count_tail(const intArray * p, int k, int begin, int end, bool circular,
+							 const unsigned int * partner, unsigned int tag){
+	int b = 0;
+
+	for(;k<end-1;k++){
+		b += partner[right_extremity(p[k])] == (tag | left_extremity(p[k+1]));
+	}
+	if(circular && end > begin){
+		b += partner[right_extremity(p[end-1])] == (tag | left_extremity(p[begin]));
+	}
+	return b;
+}
+
+static inline int num_bounds_of(const GenomeDesc & pi){
+	int c;
+	int bounds = 0;
+
+	for(c=0;c<pi.num_chromosomes;c++){
+		int len = pi.offsets[c+1] - pi.offsets[c];
+
+		if(len > 0){
+			bounds += len - 1 + (pi.circular[c] ? 1 : 0);
+		}
+	}
+	return bounds;
+}
+
+static int count_scalar(const GenomeDesc & pi, const unsigned int * partner, unsigned int stamp, int * num_bounds){
+	int c;
+	int b = 0;
+
+	for(c=0;c<pi.num_chromosomes;c++){
+		b += count_tail(pi.genes,pi.offsets[c],pi.offsets[c],pi.offsets[c+1],pi.circular[c],partner,stamp << 16);
+	}
+	*num_bounds = num_bounds_of(pi);
+	return b;
+}
+
+#ifdef ADJMATCH_X86
+
+// The extremities of lanes of genes x are computed from their absolute values:
+// right_extremity(x) = 2|x| - (x < 0) and left_extremity(x) = 2|x| - (x > 0),
+// where the comparisons give -1 for true.
+
+__attribute__((target("avx2")))
+static int count_avx2(const GenomeDesc & pi, const unsigned int * partner, unsigned int stamp, int * num_bounds){
+	int c,k;
+	int b = 0;
+	const intArray * p = pi.genes;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i tag = _mm256_set1_epi32(stamp << 16);
+	__m256i hits = zero;
+
+	for(c=0;c<pi.num_chromosomes;c++){
+		int begin = pi.offsets[c];
+		int end = pi.offsets[c+1];
+
+		for(k=begin;k+8<end;k+=8){
+			__m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(p + k)));
+			__m256i y = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(p + k + 1)));
+			__m256i right = _mm256_add_epi32(_mm256_slli_epi32(_mm256_abs_epi32(x),1),_mm256_cmpgt_epi32(zero,x));
+			__m256i left = _mm256_add_epi32(_mm256_slli_epi32(_mm256_abs_epi32(y),1),_mm256_cmpgt_epi32(y,zero));
+			__m256i found = _mm256_i32gather_epi32((const int *)partner,right,4);
+
+			hits = _mm256_sub_epi32(hits,_mm256_cmpeq_epi32(found,_mm256_or_si256(tag,left)));
+		}
+		b += count_tail(p,k,begin,end,pi.circular[c],partner,stamp << 16);
+	}
+
+	__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(hits),_mm256_extracti128_si256(hits,1));
+	sum = _mm_add_epi32(sum,_mm_shuffle_epi32(sum,0x4e));
+	sum = _mm_add_epi32(sum,_mm_shuffle_epi32(sum,0xb1));
+
+	*num_bounds = num_bounds_of(pi);
+	return b + _mm_cvtsi128_si32(sum);
+}
+
+// SSE4.1 has no gather, so the four lookups of a vector are loaded one by one
+__attribute__((target("sse4.1")))
+static int count_sse41(const GenomeDesc & pi, const unsigned int * partner, unsigned int stamp, int * num_bounds){
+	int c,k;
+	int b = 0;
+	const intArray * p = pi.genes;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i tag = _mm_set1_epi32(stamp << 16);
+	__m128i hits = zero;
+
+	for(c=0;c<pi.num_chromosomes;c++){
+		int begin = pi.offsets[c];
+		int end = pi.offsets[c+1];
+
+		for(k=begin;k+4<end;k+=4){
+			__m128i x = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)(p + k)));
+			__m128i y = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)(p + k + 1)));
+			__m128i right = _mm_add_epi32(_mm_slli_epi32(_mm_abs_epi32(x),1),_mm_cmpgt_epi32(zero,x));
+			__m128i left = _mm_add_epi32(_mm_slli_epi32(_mm_abs_epi32(y),1),_mm_cmpgt_epi32(y,zero));
+			__m128i found = _mm_set_epi32(partner[_mm_extract_epi32(right,3)],partner[_mm_extract_epi32(right,2)],
+										  partner[_mm_extract_epi32(right,1)],partner[_mm_cvtsi128_si32(right)]);
+
+			hits = _mm_sub_epi32(hits,_mm_cmpeq_epi32(found,_mm_or_si128(tag,left)));
+		}
+		b += count_tail(p,k,begin,end,pi.circular[c],partner,stamp << 16);
+	}
+
+	hits = _mm_add_epi32(hits,_mm_shuffle_epi32(hits,0x4e));
+	hits = _mm_add_epi32(hits,_mm_shuffle_epi32(hits,0xb1));
+
+	*num_bounds = num_bounds_of(pi);
+	return b + _mm_cvtsi128_si32(hits);
+}
+
+#endif
+
+static const adjmatch_t implementations[] = {
+#ifdef ADJMATCH_X86
+	{ "avx2", count_avx2 },
+	{ "sse4.1", count_sse41 },
+#endif
+	{ "scalar", count_scalar },
+	{ "none", NULL }
+};
+
+static bool supported(const adjmatch_t & impl){
+#ifdef ADJMATCH_X86
+	if(!strcmp(impl.isa,"avx2")){
+		return __builtin_cpu_supports("avx2");
+	}
+	if(!strcmp(impl.isa,"sse4.1")){
+		return __builtin_cpu_supports("sse4.1");
+	}
+#endif
+	return true;
+}
+
+// The best implementation the processor supports, picked on first use
+static const adjmatch_t * best(){
+	size_t i;
+
+	for(i=0;i<sizeof(implementations)/sizeof(adjmatch_t);i++){
+		if(supported(implementations[i])){
+			return &implementations[i];
+		}
+	}
+	return NULL;
+}
+
+static const adjmatch_t *& current(){
+	static const adjmatch_t * impl = best();
+	return impl;
+}
+
+int count_partners(const GenomeDesc & pi, const unsigned int * partner, unsigned int stamp, int * num_bounds){
+	return current()->count(pi,partner,stamp,num_bounds);
+}
+
+bool adjmatch_enabled(){
+	return current()->count != NULL;
+}
+
+const char * adjmatch_isa(){
+	return current()->isa;
+}
+
+bool adjmatch_select(const char * isa){
+	size_t i;
+
+	for(i=0;i<sizeof(implementations)/sizeof(adjmatch_t);i++){
+		if(!strcmp(implementations[i].isa,isa) && supported(implementations[i])){
+			current() = &implementations[i];
+			return true;
+		}
+	}
+	return false;
+}
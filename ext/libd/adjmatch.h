@@ -0,0 +1,46 @@
+#ifndef ADJMATCH_H
+#define ADJMATCH_H
+
+#include "structs.h"
+
+// Every gene g has a tail extremity 2g-1 and a head extremity 2g. Reading left to
+// right, +g shows its tail then its head and -g its head then its tail, so the
+// adjacency (a,b) joins the right extremity of a to the left extremity of b.
+// They are computed from |g| without a branch, as the signs of a gene order
+// are too irregular to predict: 2|g| - (g < 0) and 2|g| - (g > 0).
+inline int right_extremity(int g){
+	int sign = g >> 31;
+
+	return 2 * ((g ^ sign) - sign) + sign;
+}
+inline int left_extremity(int g){
+	int sign = g >> 31;
+
+	return 2 * ((g ^ sign) - sign) - (g > 0);
+}
+
+// A genome can index its adjacencies directly by extremity. partner[e] holds
+// (stamp << 16) | f for each adjacency joining extremities e and f, in both
+// directions, so an adjacency (a,b) read from either strand is shared when
+// partner[right_extremity(a)] == (stamp << 16 | left_extremity(b)). Entries from
+// earlier stamps never match, so the table does not need clearing between genomes.
+// 32 bit genomes keep the stamp in the top half of 64 bit entries instead.
+#define PARTNER_SIZE		(2 * 32768 + 2)
+
+// Count the adjacencies of pi found in a partner table, and set num_bounds to the
+// number of adjacencies of pi. The lookups run over the gene buffer a vector of
+// adjacencies at a time, with an implementation chosen at run time from what the
+// processor supports: AVX2, SSE4.1 or plain C.
+int count_partners(const GenomeDesc & pi, const unsigned int * partner, unsigned int stamp, int * num_bounds);
+
+// Whether genomes use a partner table rather than the hash index
+bool adjmatch_enabled();
+
+// The name of the implementation in use
+const char * adjmatch_isa();
+
+// Use the named implementation ("avx2", "sse4.1", "scalar") or, with "none", the
+// hash index. Returns false if the processor does not support it.
+bool adjmatch_select(const char * isa);
+
+#endif
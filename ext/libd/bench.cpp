@@ -0,0 +1,1425 @@
+// Micro-benchmarks for the distance library
+//
+//	make bench && ./bench
+//
+// ./bench suite runs only the regression suite, whose genomes come from the
+// seeded generator of synthetic.h, so its figures can be compared across runs.
+
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <new>
+#include <thread>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "distances.h"
+#include "invdist.h"
+#include "parallel.h"
+#include "adjmatch.h"
+#include "disttree.h"
+#include "invsort.h"
+#include "median.h"
+#include "synthetic.h"
+
+// Count every heap allocation made through operator new
+static long allocations;
+
+void * operator new(size_t size){
+	allocations++;
+	void * p = malloc(size);
+	if(!p){
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void * operator new[](size_t size){
+	return operator new(size);
+}
+void operator delete(void * p) noexcept{
+	free(p);
+}
+void operator delete[](void * p) noexcept{
+	free(p);
+}
+void operator delete(void * p, size_t) noexcept{
+	operator delete(p);
+}
+void operator delete[](void * p, size_t) noexcept{
+	operator delete[](p);
+}
+
+// Keep the optimizer from hoisting a call with unchanged arguments out of a timing loop
+#define CLOBBER() asm volatile("" : : : "memory")
+
+// Results are accumulated here so that the timed calls are not dead code
+static volatile int sink;
+
+// The boundary scan that _breakpoints used before the adjacency index,
+// kept here as the baseline the indexed version is measured against.
+static int __attribute__((noinline)) breakpoints_scan(const GenomeDesc & pi, const GenomeDesc & id){
+	int k,l,bA,bB,b;
+	bA = bB = b = 0;
+
+	for(k=0;k<pi.num_genes()-1;k++){
+		int find = 0;
+		bA++;
+
+		int pi1 = pi.genes[k];
+		int pi2 = pi.genes[k+1];
+
+		bB = 0;
+		for(l=0;l<id.num_genes()-1;l++){
+			int id1 = id.genes[l];
+			int id2 = id.genes[l+1];
+			bB++;
+
+			if( (pi1 == id1 && pi2 == id2) || (-pi1 == id2 && -pi2 == id1) ){
+				find++;
+			}
+		}
+
+		if(find){
+			b++;
+		}
+	}
+
+	return bA > bB ? bA - b : bB - b;
+}
+
+// The sort based checks that _inversions and _DCJ used before _validate
+static int __attribute__((noinline)) validate_sort(const GenomeDesc & pi, const GenomeDesc & id){
+	std::vector<intArray> genesA(pi.genes,pi.genes + pi.num_genes());
+	std::vector<intArray> genesB(id.genes,id.genes + id.num_genes());
+	size_t i;
+
+	for(i=0;i<genesA.size();i++){
+		genesA[i] = abs(genesA[i]);
+	}
+	for(i=0;i<genesB.size();i++){
+		genesB[i] = abs(genesB[i]);
+	}
+	std::sort(genesA.begin(),genesA.end());
+	std::sort(genesB.begin(),genesB.end());
+
+	for(i=0;i+1<genesA.size();i++){
+		if(genesA[i] == genesA[i+1]){
+			return ERR_DUPLICATES;
+		}
+	}
+	for(i=0;i+1<genesB.size();i++){
+		if(genesB[i] == genesB[i+1]){
+			return ERR_DUPLICATES;
+		}
+	}
+	return genesA == genesB ? 0 : ERR_CONTENT;
+}
+
+// Describe n genes as a genome of one linear chromosome, keeping its offsets in offsets[2]
+static const unsigned char linear[1] = { 0 };
+
+static GenomeDesc describe(intArray * p, int n, int * offsets){
+	GenomeDesc g;
+
+	offsets[0] = 0;
+	offsets[1] = n;
+	g.genes = p;
+	g.offsets = offsets;
+	g.circular = linear;
+	g.num_chromosomes = 1;
+	return g;
+}
+
+// A hardware counter of this thread through perf_event_open, or -1 where the
+// counters are unavailable, e.g. without permission or outside Linux
+static int counter_open(unsigned int type, unsigned long long config){
+#ifdef __linux__
+	struct perf_event_attr attr;
+
+	memset(&attr,0,sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return syscall(SYS_perf_event_open,&attr,0,-1,-1,0);
+#else
+	return -1;
+#endif
+}
+
+static long long counter_read(int fd){
+	long long count = 0;
+
+	if(fd < 0 || read(fd,&count,sizeof(count)) != sizeof(count)){
+		return -1;
+	}
+	return count;
+}
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// A random signed permutation of 1..n
+static void random_order(intArray * p, int n){
+	int i;
+
+	for(i=0;i<n;i++){
+		p[i] = i+1;
+	}
+	for(i=n-1;i>0;i--){
+		int j = rand() % (i+1);
+		intArray t = p[i];
+		p[i] = p[j];
+		p[j] = t;
+	}
+	for(i=0;i<n;i++){
+		if(rand() % 2){
+			p[i] = -p[i];
+		}
+	}
+}
+
+static void random_order32(intArray32 * p, int n){
+	int i;
+
+	for(i=0;i<n;i++){
+		p[i] = i+1;
+	}
+	for(i=n-1;i>0;i--){
+		int j = rand() % (i+1);
+		intArray32 t = p[i];
+		p[i] = p[j];
+		p[j] = t;
+	}
+	for(i=0;i<n;i++){
+		if(rand() % 2){
+			p[i] = -p[i];
+		}
+	}
+}
+
+// Apply k random inversions so the pair shares some adjacencies
+static void invert(intArray * p, int n, int k){
+	while(k--){
+		int i = rand() % n;
+		int j = rand() % n;
+		if(i > j){
+			int t = i; i = j; j = t;
+		}
+		for(;i<j;i++,j--){
+			intArray t = p[i];
+			p[i] = -p[j];
+			p[j] = -t;
+		}
+		if(i == j){
+			p[i] = -p[i];
+		}
+	}
+}
+
+static void bench_breakpoints(int n){
+	intArray * a = new intArray[n];
+	intArray * b = new intArray[n];
+	int offsets_a[2], offsets_b[2];
+	int i, reps;
+	int check = 0;
+	double t, t_scan, t_index;
+
+	random_order(a,n);
+	for(i=0;i<n;i++){
+		b[i] = a[i];
+	}
+	invert(b,n,n/10 + 1);
+
+	GenomeDesc ga = describe(a,n,offsets_a);
+	GenomeDesc gb = describe(b,n,offsets_b);
+
+	if(breakpoints_scan(ga,gb) != _breakpoints(ga,gb)){
+		printf("breakpoints mismatch at n=%d: %d != %d\n",n,breakpoints_scan(ga,gb),_breakpoints(ga,gb));
+	}
+
+	// Aim for a comparable amount of work at every size
+	reps = 20000000 / (n * n) + 1;
+
+	t = now();
+	for(i=0;i<reps;i++){
+		CLOBBER();
+		check += breakpoints_scan(ga,gb);
+	}
+	t_scan = (now() - t) / reps;
+
+	reps = 2000000 / n + 1;
+
+	t = now();
+	for(i=0;i<reps;i++){
+		CLOBBER();
+		check += _breakpoints(ga,gb);
+	}
+	t_index = (now() - t) / reps;
+
+	printf("%-8d%14.0f%14.0f%10.1fx\n",n,t_scan * 1e9,t_index * 1e9,t_scan / t_index);
+	sink += check;
+
+	delete[] a;
+	delete[] b;
+}
+
+// Breakpoints of short genomes with the hash index and each vector kernel
+static void bench_adjmatch(int n, int pairs){
+	static const char * isas[] = { "none", "scalar", "sse4.1", "avx2" };
+	const char * saved = adjmatch_isa();
+	intArray * a = new intArray[n];
+	intArray * b = new intArray[n];
+	int offsets_a[2], offsets_b[2];
+	int i, k, expected = 0;
+	double t;
+
+	random_order(a,n);
+	for(i=0;i<n;i++){
+		b[i] = a[i];
+	}
+	invert(b,n,n/10 + 1);
+
+	GenomeDesc ga = describe(a,n,offsets_a);
+	GenomeDesc gb = describe(b,n,offsets_b);
+
+	printf("%-8d%8d",n,pairs);
+	for(k=0;k<4;k++){
+		if(!adjmatch_select(isas[k])){
+			printf("%10s","-");
+			continue;
+		}
+
+		int check = _breakpoints(ga,gb);
+		if(k == 0){
+			expected = check;
+		}else if(check != expected){
+			printf("  MISMATCH %s %d != %d",isas[k],check,expected);
+		}
+
+		t = now();
+		for(i=0;i<pairs;i++){
+			CLOBBER();
+			check += _breakpoints(ga,gb);
+		}
+		printf("%10.0f",(now() - t) / pairs * 1e9);
+		sink += check;
+	}
+	printf("\n");
+
+	adjmatch_select(saved);
+
+	delete[] a;
+	delete[] b;
+}
+
+static void bench_inversions(int n, int pairs){
+	intArray * a = new intArray[n];
+	intArray * b = new intArray[n];
+	Genome ga, gb;
+	int i;
+	int check = 0;
+	long before, allocs_new, allocs_pool;
+	double t, t_new, t_pool;
+
+	random_order(a,n);
+	for(i=0;i<n;i++){
+		b[i] = a[i];
+	}
+	invert(b,n,n/10 + 1);
+
+	ga.pi = a; ga.len = n; ga.circular = false;
+	gb.pi = b; gb.len = n; gb.circular = false;
+
+	// A fresh workspace for every pair, as invdist_noncircular used to do
+	before = allocations;
+	t = now();
+	for(i=0;i<pairs;i++){
+		distmem_t * distmem = new distmem_t(2 * n + 2);
+		check += invdist_noncircular(&ga,&gb,0,distmem);
+		delete distmem;
+	}
+	t_new = (now() - t) / pairs;
+	allocs_new = allocations - before;
+
+	// The thread's pooled workspace
+	before = allocations;
+	t = now();
+	for(i=0;i<pairs;i++){
+		check += invdist_noncircular(&ga,&gb,0);
+	}
+	t_pool = (now() - t) / pairs;
+	allocs_pool = allocations - before;
+
+	printf("%-8d%8d%12ld%12ld%12.0f%12.0f\n",n,pairs,allocs_new,allocs_pool,t_new * 1e9,t_pool * 1e9);
+	sink += check;
+
+	delete[] a;
+	delete[] b;
+}
+
+// Circular chromosomes, cut at a common gene before and after the dedicated kernel
+// The inversion distance with 16 and 32 bit breakpoint graph vertices, counting
+// the level 1 data cache and last level cache misses of each call
+static void bench_layout(int n, int pairs){
+	intArray32 * a = new intArray32[n];
+	intArray32 * b = new intArray32[n];
+	Genome32 ga, gb;
+	int i, w;
+	int check = 0;
+	double t;
+
+	random_order32(a,n);
+	random_order32(b,n);
+
+	ga.pi = a; ga.len = n; ga.circular = false;
+	gb.pi = b; gb.len = n; gb.circular = false;
+
+#ifdef __linux__
+	int l1 = counter_open(PERF_TYPE_HW_CACHE,PERF_COUNT_HW_CACHE_L1D |
+						  (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	int llc = counter_open(PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES);
+#else
+	int l1 = -1, llc = -1;
+#endif
+
+	distmem_t * distmem = distmem_pool(n);
+
+	printf("%-8d%8d",n,pairs);
+	for(w=1;w>=0;w--){
+		distmem->wide = w;
+		check += invdist_noncircular(&ga,&gb,0);
+
+		long long l1_before = counter_read(l1);
+		long long llc_before = counter_read(llc);
+		t = now();
+		for(i=0;i<pairs;i++){
+			CLOBBER();
+			check += invdist_noncircular(&ga,&gb,0);
+		}
+		t = (now() - t) / pairs;
+		long long l1_misses = counter_read(l1) - l1_before;
+		long long llc_misses = counter_read(llc) - llc_before;
+
+		printf("%10.0f",t * 1e9);
+		if(l1 >= 0){
+			printf("%10lld",l1_misses / pairs);
+		}else{
+			printf("%10s","-");
+		}
+		if(llc >= 0){
+			printf("%10lld",llc_misses / pairs);
+		}else{
+			printf("%10s","-");
+		}
+	}
+	printf("\n");
+	distmem->wide = false;
+	sink += check;
+
+	if(l1 >= 0){
+		close(l1);
+	}
+	if(llc >= 0){
+		close(llc);
+	}
+	delete[] a;
+	delete[] b;
+}
+
+static void bench_circular(int n, int pairs){
+	intArray * a = new intArray[n];
+	intArray * b = new intArray[n];
+	Genome ga, gb;
+	int i;
+	int check = 0;
+	double t, t_offset, t_circular;
+
+	random_order(a,n);
+	for(i=0;i<n;i++){
+		b[i] = a[(i + n/3) % n];
+	}
+	invert(b,n,n/10 + 1);
+
+	ga.pi = a; ga.len = n; ga.circular = true;
+	gb.pi = b; gb.len = n; gb.circular = true;
+
+	if(invdist_noncircular(&ga,&gb,calculate_offset(&ga,&gb)) != invdist_circular(&ga,&gb)){
+		printf("circular mismatch at n=%d\n",n);
+	}
+
+	t = now();
+	for(i=0;i<pairs;i++){
+		CLOBBER();
+		check += invdist_noncircular(&ga,&gb,calculate_offset(&ga,&gb));
+	}
+	t_offset = (now() - t) / pairs;
+
+	t = now();
+	for(i=0;i<pairs;i++){
+		CLOBBER();
+		check += invdist_circular(&ga,&gb);
+	}
+	t_circular = (now() - t) / pairs;
+
+	printf("%-8d%8d%12.0f%12.0f\n",n,pairs,t_offset * 1e9,t_circular * 1e9);
+	sink += check;
+
+	delete[] a;
+	delete[] b;
+}
+
+static void bench_dcj(int n, int pairs){
+	intArray * a = new intArray[n];
+	intArray * b = new intArray[n];
+	int offsets_a[2], offsets_b[2];
+	int i;
+	int check = 0;
+	double t, t_inv, t_dcj;
+
+	random_order(a,n);
+	for(i=0;i<n;i++){
+		b[i] = a[i];
+	}
+	invert(b,n,n/10 + 1);
+
+	GenomeDesc ga = describe(a,n,offsets_a);
+	GenomeDesc gb = describe(b,n,offsets_b);
+
+	t = now();
+	for(i=0;i<pairs;i++){
+		CLOBBER();
+		check += _inversions(ga,gb);
+	}
+	t_inv = (now() - t) / pairs;
+
+	t = now();
+	for(i=0;i<pairs;i++){
+		CLOBBER();
+		check += _DCJ(ga,gb);
+	}
+	t_dcj = (now() - t) / pairs;
+
+	printf("%-8d%8d%12.0f%12.0f\n",n,pairs,t_inv * 1e9,t_dcj * 1e9);
+	sink += check;
+
+	delete[] a;
+	delete[] b;
+}
+
+static void bench_validate(int n, int pairs){
+	intArray * a = new intArray[n];
+	intArray * b = new intArray[n];
+	int offsets_a[2], offsets_b[2];
+	int i;
+	int check = 0;
+	long before, allocs_sort, allocs_marks;
+	double t, t_sort, t_marks;
+
+	random_order(a,n);
+	random_order(b,n);
+
+	GenomeDesc ga = describe(a,n,offsets_a);
+	GenomeDesc gb = describe(b,n,offsets_b);
+
+	before = allocations;
+	t = now();
+	for(i=0;i<pairs;i++){
+		CLOBBER();
+		check += validate_sort(ga,gb);
+	}
+	t_sort = (now() - t) / pairs;
+	allocs_sort = allocations - before;
+
+	// Warm the thread's mark array before counting
+	check += _validate(ga,&gb);
+
+	before = allocations;
+	t = now();
+	for(i=0;i<pairs;i++){
+		CLOBBER();
+		check += _validate(ga,&gb);
+	}
+	t_marks = (now() - t) / pairs;
+	allocs_marks = allocations - before;
+
+	printf("%-8d%8d%12ld%12ld%12.0f%12.0f\n",n,pairs,allocs_sort,allocs_marks,t_sort * 1e9,t_marks * 1e9);
+	sink += check;
+
+	delete[] a;
+	delete[] b;
+}
+
+// A set of related genomes whose lengths vary tenfold, so the pairs are unevenly expensive
+static void bench_matrix(int num_genomes, int metric, const char * name){
+	std::vector<GenomeDesc> genomes(num_genomes);
+	std::vector<int> offsets(2 * num_genomes);
+	int i,j,t;
+	int n = num_genomes;
+	double start, t_serial;
+
+	for(i=0;i<n;i++){
+		int len = 40 + (i % 10) * 40;
+		intArray * p = new intArray[len];
+		random_order(p,len);
+		genomes[i] = describe(p,len,&offsets[2 * i]);
+	}
+
+	int * serial = new int[n * n];
+	int * parallel = new int[n * n];
+
+	std::fill(serial,serial + n * n,DIST_UNKNOWN);
+	start = now();
+	_distance_matrix(genomes,metric,serial);
+	t_serial = now() - start;
+	printf("%-12s%8d%8d%10.3f%10s\n",name,n,1,t_serial,"");
+
+	for(t=2;t<=8;t*=2){
+		std::fill(parallel,parallel + n * n,DIST_UNKNOWN);
+		start = now();
+		_distance_matrix_parallel(genomes,metric,parallel,t);
+		double t_parallel = now() - start;
+
+		bool same = true;
+		for(j=0;j<n*n;j++){
+			if(serial[j] != parallel[j]){
+				same = false;
+			}
+		}
+		printf("%-12s%8d%8d%10.3f%9.1fx%s\n",name,n,t,t_parallel,t_serial / t_parallel,same ? "" : "  MISMATCH");
+	}
+
+	for(i=0;i<n;i++){
+		delete[] genomes[i].genes;
+	}
+	delete[] serial;
+	delete[] parallel;
+}
+
+// The matrix tile before the metric was hoisted out of its cells: the metric is
+// switched on for every cell, and each cell calls the kernel of the public entry
+// point
+template <typename T>
+static void matrix_dispatch(std::vector< GenomeDescT<T> > & genomes, int metric, int * matrix, adjindex_T<T> & index){
+	int n = genomes.size();
+	int i,j,d,bA,bB;
+
+	for(i=0;i<n;i++){
+		bool indexed = false;
+
+		for(j=i;j<n;j++){
+			if(matrix[i*n+j] != DIST_UNKNOWN){
+				continue;
+			}
+			if(!indexed && (metric == DIST_ADJACENCIES || metric == DIST_BREAKPOINTS)){
+				index.build(genomes[i]);
+				indexed = true;
+			}
+			switch(metric){
+				case DIST_ADJACENCIES:
+					d = _shared_adjacencies(genomes[j],index,&bA);
+					break;
+				case DIST_BREAKPOINTS:
+					d = _shared_adjacencies(genomes[j],index,&bA);
+					bB = index.num_adjacencies;
+					d = bA > bB ? bA - d : bB - d;
+					break;
+				case DIST_INVERSIONS:
+					d = _inversions(genomes[j],genomes[i],true);
+					break;
+				case DIST_DCJ:
+					d = _DCJ(genomes[j],genomes[i],true);
+					break;
+				default:
+					d = ERR_NOTIMPL;
+			}
+			matrix[i*n+j] = matrix[j*n+i] = d;
+		}
+	}
+}
+
+// Matrices of genomes of one chromosome that evolved along a random tree, by the
+// per cell dispatch above and by the tile with the metric hoisted out of its cells
+static const unsigned char circular_flag[1] = { 1 };
+
+template <typename T>
+static void bench_hoisted(const char * metric_name, int metric, int num_genomes, int genes, bool circular){
+	std::vector< GenomeDescT<T> > genomes(num_genomes);
+	std::vector<int> offsets(2 * num_genomes);
+	int i,k,rep,reps;
+	int n = num_genomes;
+	double start, t_dispatch, t_hoisted;
+	adjindex_T<T> index;
+
+	for(i=0;i<n;i++){
+		T * p = new T[genes];
+
+		if(i == 0){
+			for(k=0;k<genes;k++){
+				p[k] = (k + 1) * (rand() % 2 ? 1 : -1);
+			}
+		}else{
+			memcpy(p,genomes[rand() % i].genes,genes * sizeof(T));
+			for(rep=0;rep<2;rep++){
+				int a = rand() % genes, b = rand() % genes;
+				if(a > b){
+					std::swap(a,b);
+				}
+				std::reverse(p + a,p + b + 1);
+				for(k=a;k<=b;k++){
+					p[k] = -p[k];
+				}
+			}
+		}
+		offsets[2 * i] = 0;
+		offsets[2 * i + 1] = genes;
+		genomes[i].genes = p;
+		genomes[i].offsets = &offsets[2 * i];
+		genomes[i].circular = circular ? circular_flag : linear;
+		genomes[i].num_chromosomes = 1;
+	}
+
+	std::vector<int> dispatched(n * n), hoisted(n * n);
+	reps = metric == DIST_INVERSIONS || metric == DIST_DCJ ? 1 : 5;
+
+	start = now();
+	for(rep=0;rep<reps;rep++){
+		std::fill(dispatched.begin(),dispatched.end(),DIST_UNKNOWN);
+		matrix_dispatch(genomes,metric,dispatched.data(),index);
+	}
+	t_dispatch = (now() - start) / reps;
+
+	start = now();
+	for(rep=0;rep<reps;rep++){
+		std::fill(hoisted.begin(),hoisted.end(),DIST_UNKNOWN);
+		_distance_matrix(genomes,metric,hoisted.data());
+	}
+	t_hoisted = (now() - start) / reps;
+
+	double cells = n * (n + 1) / 2.0;
+	printf("%-12s%-9s%6d%8d%8d%12.1f%12.1f%9.2fx%s\n",metric_name,circular ? "circular" : "linear",
+		   (int)(8 * sizeof(T)),n,genes,t_dispatch / cells * 1e9,t_hoisted / cells * 1e9,t_dispatch / t_hoisted,
+		   dispatched == hoisted ? "" : "  MISMATCH");
+
+	for(i=0;i<n;i++){
+		delete[] genomes[i].genes;
+	}
+}
+
+// Neighbour joining by a full scan of Q before every join, keeping the slots,
+// sums and tie breaking of disttree_nj so that both build the same tree
+static void nj_scan(const int * matrix, int n, disttree_t & tree){
+	std::vector<double> d((size_t)n * n,0.0), sum(n,0.0);
+	std::vector<int> node(n), born(n);
+	std::vector<char> alive(n,1);
+	int a,b,k,r = n,next = n;
+
+	tree.num_leaves = n;
+	tree.parent.assign(n,-1);
+	tree.length.assign(n,0.0);
+	for(a=0;a<n;a++){
+		node[a] = born[a] = a;
+		for(b=0;b<a;b++){
+			d[a*n+b] = d[b*n+a] = matrix[a*n+b];
+			sum[a] += matrix[a*n+b];
+			sum[b] += matrix[a*n+b];
+		}
+	}
+
+	while(r > 3){
+		double best = HUGE_VAL;
+		int i = -1, j = -1;
+
+		for(a=0;a<n;a++){
+			for(b=0;b<n;b++){
+				if(!alive[a] || !alive[b] || born[b] >= born[a]){
+					continue;
+				}
+
+				double q = (r - 2) * d[a*n+b] - sum[a] - sum[b];
+				int lo = std::min(node[a],node[b]), hi = std::max(node[a],node[b]);
+
+				if(q < best || (q == best && (lo < std::min(node[i],node[j]) ||
+											  (lo == std::min(node[i],node[j]) && hi < std::max(node[i],node[j]))))){
+					best = q;
+					i = a;
+					j = b;
+				}
+			}
+		}
+
+		double dij = d[i*n+j];
+		double length = 0.5 * dij + (sum[i] - sum[j]) / (2.0 * (r - 2));
+		int u = tree.parent.size();
+
+		tree.parent.push_back(-1);
+		tree.length.push_back(0.0);
+		tree.parent[node[i]] = tree.parent[node[j]] = u;
+		tree.length[node[i]] = length;
+		tree.length[node[j]] = dij - length;
+
+		alive[j] = 0;
+		sum[i] = 0.0;
+		for(k=0;k<n;k++){
+			if(alive[k] && k != i){
+				double duk = 0.5 * (d[i*n+k] + d[j*n+k] - dij);
+
+				sum[k] += duk - d[i*n+k] - d[j*n+k];
+				sum[i] += duk;
+				d[i*n+k] = d[k*n+i] = duk;
+			}
+		}
+		node[i] = u;
+		born[i] = next++;
+		r--;
+	}
+
+	int last[3], num_last = 0;
+	for(a=0;a<n;a++){
+		if(alive[a]){
+			last[num_last++] = a;
+		}
+	}
+	int root = tree.parent.size();
+	tree.parent.push_back(-1);
+	tree.length.push_back(0.0);
+	for(k=0;k<3;k++){
+		a = last[k];
+		b = last[(k + 1) % 3];
+		int c = last[(k + 2) % 3];
+
+		tree.parent[node[a]] = root;
+		tree.length[node[a]] = 0.5 * (d[a*n+b] + d[a*n+c] - d[b*n+c]);
+	}
+}
+
+// UPGMA by a full scan of the matrix before every join
+static void upgma_scan(const int * matrix, int n, disttree_t & tree){
+	std::vector<double> d(matrix,matrix + (size_t)n * n), height(n,0.0);
+	std::vector<int> node(n), size(n,1);
+	std::vector<char> alive(n,1);
+	int a,b,k,r = n;
+
+	tree.num_leaves = n;
+	tree.parent.assign(n,-1);
+	tree.length.assign(n,0.0);
+	for(a=0;a<n;a++){
+		node[a] = a;
+	}
+
+	while(r > 1){
+		double best = HUGE_VAL;
+		int i = -1, j = -1;
+
+		for(a=0;a<n;a++){
+			for(b=0;b<a;b++){
+				if(alive[a] && alive[b] && d[a*n+b] < best){
+					best = d[a*n+b];
+					i = b;
+					j = a;
+				}
+			}
+		}
+
+		int u = tree.parent.size();
+		tree.parent.push_back(-1);
+		tree.length.push_back(0.0);
+		tree.parent[node[i]] = tree.parent[node[j]] = u;
+		tree.length[node[i]] = 0.5 * best - height[i];
+		tree.length[node[j]] = 0.5 * best - height[j];
+
+		for(k=0;k<n;k++){
+			if(alive[k] && k != i && k != j){
+				d[i*n+k] = d[k*n+i] = (size[i] * d[i*n+k] + size[j] * d[j*n+k]) / (size[i] + size[j]);
+			}
+		}
+		size[i] += size[j];
+		height[i] = 0.5 * best;
+		node[i] = u;
+		alive[j] = 0;
+		r--;
+	}
+}
+
+// Whether every join of an UPGMA tree is at the least average distance between
+// the clusters left when it is made. Tied distances allow more than one UPGMA
+// tree, and every one of them passes: the joins are replayed by height, those
+// at the same height below their parents, and the distances updated as UPGMA does.
+static bool upgma_valid(const int * matrix, int n, const disttree_t & tree){
+	int num_nodes = tree.parent.size();
+	std::vector<double> d(matrix,matrix + (size_t)n * n), height(num_nodes,0.0);
+	std::vector<int> cluster(num_nodes), size(n,1), first(num_nodes,-1), second(num_nodes,-1);
+	std::vector< std::pair<long long,int> > joins;
+	std::vector<char> alive(n,1);
+	int a,b,k,v;
+
+	for(v=0;v<num_nodes;v++){
+		cluster[v] = v;
+		int u = tree.parent[v];
+		if(u < 0){
+			continue;
+		}
+		height[u] = height[v] + tree.length[v];
+		if(first[u] < 0){
+			first[u] = v;
+		}else{
+			second[u] = v;
+		}
+	}
+	// Heights rounded, so that a join and its parent at the same height sort by node
+	for(v=n;v<num_nodes;v++){
+		joins.push_back(std::make_pair(llround(height[v] * 1e6),v));
+	}
+	std::sort(joins.begin(),joins.end());
+
+	for(size_t t=0;t<joins.size();t++){
+		int u = joins[t].second;
+		int i = std::min(cluster[first[u]],cluster[second[u]]);
+		int j = std::max(cluster[first[u]],cluster[second[u]]);
+		double least = HUGE_VAL;
+
+		for(a=0;a<n;a++){
+			for(b=0;b<a;b++){
+				if(alive[a] && alive[b] && d[a*n+b] < least){
+					least = d[a*n+b];
+				}
+			}
+		}
+		if(fabs(d[i*n+j] - least) > 1e-9 || fabs(2 * height[u] - least) > 1e-9){
+			return false;
+		}
+
+		for(k=0;k<n;k++){
+			if(alive[k] && k != i && k != j){
+				d[i*n+k] = d[k*n+i] = (size[i] * d[i*n+k] + size[j] * d[j*n+k]) / (size[i] + size[j]);
+			}
+		}
+		size[i] += size[j];
+		alive[j] = 0;
+		cluster[u] = i;
+	}
+	return true;
+}
+
+// Trees of genomes that evolved along a random tree by a few inversions at a time
+static void bench_tree(int num_genomes, int genes){
+	std::vector<GenomeDesc> genomes(num_genomes);
+	std::vector<int> offsets(2 * num_genomes);
+	std::vector<std::string> names(num_genomes);
+	int i;
+	int n = num_genomes;
+	double start, t_nj, t_upgma, t_nj_scan = 0.0, t_upgma_scan = 0.0;
+	disttree_t tree, scanned;
+	bool same_nj = true, same_upgma = true;
+	bool scan = n <= 1000;
+
+	for(i=0;i<n;i++){
+		intArray * p = new intArray[genes];
+
+		if(i == 0){
+			random_order(p,genes);
+		}else{
+			memcpy(p,genomes[rand() % i].genes,genes * sizeof(intArray));
+			invert(p,genes,2);
+		}
+		genomes[i] = describe(p,genes,&offsets[2 * i]);
+
+		char name[16];
+		snprintf(name,sizeof(name),"g%d",i);
+		names[i] = name;
+	}
+
+	int * matrix = new int[n * n];
+	std::fill(matrix,matrix + n * n,DIST_UNKNOWN);
+	_distance_matrix_parallel(genomes,DIST_BREAKPOINTS,matrix,4);
+
+	start = now();
+	disttree_nj(matrix,n,tree);
+	t_nj = now() - start;
+	std::string newick = disttree_newick(tree,names);
+	if(scan){
+		start = now();
+		nj_scan(matrix,n,scanned);
+		t_nj_scan = now() - start;
+		same_nj = newick == disttree_newick(scanned,names);
+	}
+
+	start = now();
+	disttree_upgma(matrix,n,tree);
+	t_upgma = now() - start;
+	if(scan){
+		start = now();
+		upgma_scan(matrix,n,scanned);
+		t_upgma_scan = now() - start;
+		same_upgma = upgma_valid(matrix,n,tree) && upgma_valid(matrix,n,scanned);
+	}
+
+	if(scan){
+		printf("%-8d%12.3f%12.3f%12.3f%12.3f%s\n",n,t_nj_scan,t_nj,t_upgma_scan,t_upgma,
+			   same_nj && same_upgma ? "" : "  MISMATCH");
+	}else{
+		printf("%-8d%12s%12.3f%12s%12.3f\n",n,"-",t_nj,"-",t_upgma);
+	}
+
+	for(i=0;i<n;i++){
+		delete[] genomes[i].genes;
+	}
+	delete[] matrix;
+}
+
+static void scan_invert(std::vector<int> & p, int first, int last){
+	int x;
+
+	std::reverse(p.begin() + first,p.begin() + last + 1);
+	for(x=first;x<=last;x++){
+		p[x] = -p[x];
+	}
+}
+
+// The oriented pairs of the framed permutation p, whose genes k and k+1 are on
+// opposite strands. Leaves the position of each gene in pos.
+static int scan_oriented(const std::vector<int> & p, std::vector<int> & pos){
+	int n = p.size() - 2;
+	int k;
+	int oriented = 0;
+
+	for(k=0;k<=n+1;k++){
+		pos[abs(p[k])] = k;
+	}
+	for(k=0;k<=n;k++){
+		oriented += (p[pos[k]] >= 0) != (p[pos[k+1]] >= 0);
+	}
+	return oriented;
+}
+
+// Bergeron's rule the direct way: each step tries every oriented inversion on a
+// copy of the permutation and keeps the one that leaves the most oriented pairs.
+// There is no hurdle clearing, so it stops at the first permutation without
+// oriented pairs. Returns the number of inversions taken.
+static int scenario_scan(const intArray32 * a, int n){
+	std::vector<int> p(n + 2), pos(n + 2), q, qpos(n + 2);
+	int k,x,y;
+	int steps = 0;
+
+	p[0] = 0;
+	p[n+1] = n + 1;
+	for(x=1;x<=n;x++){
+		p[x] = a[x-1];
+	}
+
+	for(;;){
+		int best = -1, best_first = 0, best_last = 0;
+
+		scan_oriented(p,pos);
+		for(k=0;k<=n;k++){
+			x = pos[k];
+			y = pos[k+1];
+			if((p[x] >= 0) == (p[y] >= 0)){
+				continue;
+			}
+
+			int from = p[x] >= 0 ? x : x - 1;
+			int to = p[y] >= 0 ? y - 1 : y;
+			int first = std::min(from,to) + 1;
+			int last = std::max(from,to);
+
+			q = p;
+			scan_invert(q,first,last);
+
+			int score = scan_oriented(q,qpos);
+
+			if(score > best){
+				best = score;
+				best_first = first;
+				best_last = last;
+			}
+		}
+		if(best < 0){
+			break;
+		}
+		scan_invert(p,best_first,best_last);
+		steps++;
+	}
+
+	return steps;
+}
+
+// Inversion scenarios from a genome to the identity, which it is a number of
+// inversions away from, or a random genome if inversions is negative
+static void bench_scenario(int genes, int inversions){
+	synthetic_t random(genes);
+	std::vector<intArray32> a(genes), b(genes);
+	std::vector<inversion_t> scenario;
+	int k,rounds;
+	double start, t_scan = 0.0, t_sort;
+	int steps = 0;
+	bool scan = genes <= 400;
+
+	for(k=0;k<genes;k++){
+		b[k] = k + 1;
+	}
+	if(inversions < 0){
+		synthetic_permutation(random,a.data(),genes);
+	}else{
+		synthetic_events_t events = { inversions, 0, 0 };
+
+		a = b;
+		synthetic_evolve(random,a.data(),genes,events);
+	}
+
+	Genome32 g1 = { a.data(), false, genes };
+	Genome32 g2 = { b.data(), false, genes };
+	int distance = invdist_noncircular(&g1,&g2,0);
+
+	if(scan){
+		start = now();
+		for(rounds=0;rounds == 0 || now() - start < 0.05;rounds++){
+			steps = scenario_scan(a.data(),genes);
+		}
+		t_scan = (now() - start) / rounds;
+	}
+
+	start = now();
+	for(rounds=0;rounds == 0 || now() - start < 0.05;rounds++){
+		invsort(&g1,&g2,scenario);
+	}
+	t_sort = (now() - start) / rounds;
+
+	bool ok = (int)scenario.size() == distance;
+	if(scan){
+		printf("%-8d%10d%12.3f%12.3f%10.1f%s\n",genes,distance,t_scan * 1e3,t_sort * 1e3,t_scan / t_sort,
+			   ok ? (steps == distance ? "" : "  scan stuck on a hurdle") : "  MISMATCH");
+	}else{
+		printf("%-8d%10d%12s%12.3f%10s%s\n",genes,distance,"-",t_sort * 1e3,"-",ok ? "" : "  MISMATCH");
+	}
+}
+
+// Medians of synthetic triples: three genomes that each took the given number of
+// inversions from a random ancestor, as the leaves around an ancestral node do.
+// The exact inversion median is only run where it can finish, and stops after
+// MEDIAN_SECONDS.
+#define MEDIAN_TRIPLES	8
+#define MEDIAN_SECONDS	10.0
+
+static void bench_median(int genes, int inversions, bool exact){
+	synthetic_t random(genes * 31 + inversions);
+	std::vector<intArray32> ancestor(genes), leaves[3];
+	int offsets[2] = { 0, genes };
+	int t,i;
+	int inv_optimal = 0, inv_gap = 0, dcj_bound = 0, dcj_gap = 0;
+	double start, t_inv = 0.0, t_dcj = 0.0;
+
+	for(t=0;t<MEDIAN_TRIPLES;t++){
+		Genome32 g[3];
+		GenomeDesc32 d[3];
+		median_t median;
+
+		synthetic_permutation(random,ancestor.data(),genes);
+		for(i=0;i<3;i++){
+			synthetic_events_t events = { inversions, 0, 0 };
+
+			leaves[i] = ancestor;
+			synthetic_evolve(random,leaves[i].data(),genes,events);
+			g[i].pi = leaves[i].data();
+			g[i].circular = false;
+			g[i].len = genes;
+			d[i].genes = leaves[i].data();
+			d[i].offsets = offsets;
+			d[i].circular = linear;
+			d[i].num_chromosomes = 1;
+		}
+		Genome32 * const chromosomes[3] = { &g[0], &g[1], &g[2] };
+		const GenomeDesc32 * const genomes[3] = { &d[0], &d[1], &d[2] };
+
+		if(exact){
+			start = now();
+			inversion_median(chromosomes,MEDIAN_SECONDS,median);
+			t_inv += now() - start;
+			inv_optimal += median.optimal;
+			inv_gap += median.score - median.lower_bound;
+		}
+
+		start = now();
+		dcj_median(genomes,median);
+		t_dcj += now() - start;
+		dcj_bound += median.optimal;
+		dcj_gap += median.score - median.lower_bound;
+	}
+
+	if(exact){
+		printf("%-8d%8d%12.3f%10d%10.2f",genes,inversions,t_inv * 1e3 / MEDIAN_TRIPLES,inv_optimal,
+			   (double)inv_gap / MEDIAN_TRIPLES);
+	}else{
+		printf("%-8d%8d%12s%10s%10s",genes,inversions,"-","-","-");
+	}
+	printf("%12.3f%10d%10.2f\n",t_dcj * 1e3 / MEDIAN_TRIPLES,dcj_bound,(double)dcj_gap / MEDIAN_TRIPLES);
+}
+
+// A pool of pairs of genomes for the regression suite. Genome b of each pair is
+// genome a changed by the given events, so the pairs are as far apart as
+// related genomes rather than random ones.
+#define SUITE_PAIRS		64
+#define SUITE_SECONDS	0.05
+
+typedef struct suite_pairs_struct
+{
+	std::vector<intArray> genes;
+	std::vector<int> offsets;
+	std::vector<GenomeDesc> a, b;
+} suite_pairs_t;
+
+static void suite_make(suite_pairs_t & pairs, synthetic_t & random, int n, const synthetic_events_t & events){
+	int k;
+
+	pairs.genes.assign(2 * SUITE_PAIRS * n,0);
+	pairs.offsets.assign(4 * SUITE_PAIRS,0);
+	pairs.a.resize(SUITE_PAIRS);
+	pairs.b.resize(SUITE_PAIRS);
+	for(k=0;k<SUITE_PAIRS;k++){
+		intArray * a = &pairs.genes[2 * k * n];
+		intArray * b = a + n;
+
+		synthetic_permutation(random,a,n);
+		std::copy(a,a + n,b);
+		int m = synthetic_evolve(random,b,n,events);
+
+		pairs.a[k] = describe(a,n,&pairs.offsets[4 * k]);
+		pairs.b[k] = describe(b,m,&pairs.offsets[4 * k + 2]);
+	}
+}
+
+static void suite_report(const char * kernel, int genes, long pairs, double seconds){
+	printf("%-14s%8d%10ld%12.1f%14.0f\n",kernel,genes,pairs,seconds / pairs * 1e9,pairs / seconds);
+}
+
+// Time a kernel over the pool, doubling the rounds until the timing is long enough
+template <typename F>
+static void suite_time(const char * kernel, int genes, suite_pairs_t & pairs, F kernel_of){
+	long rounds, r;
+	int k;
+	double t, elapsed;
+	int check = 0;
+
+	for(rounds=1;;rounds*=2){
+		t = now();
+		for(r=0;r<rounds;r++){
+			for(k=0;k<SUITE_PAIRS;k++){
+				CLOBBER();
+				check += kernel_of(pairs.a[k],pairs.b[k]);
+			}
+		}
+		elapsed = now() - t;
+		if(elapsed >= SUITE_SECONDS){
+			break;
+		}
+	}
+
+	sink += check;
+	suite_report(kernel,genes,rounds * SUITE_PAIRS,elapsed);
+}
+
+static int suite_breakpoints(const GenomeDesc & a, const GenomeDesc & b){
+	return _breakpoints(a,b);
+}
+
+static int suite_adjacencies(const GenomeDesc & a, const GenomeDesc & b){
+	return _adjacencies(a,b).size();
+}
+
+static int suite_invdist(const GenomeDesc & a, const GenomeDesc & b){
+	Genome ga = a.chromosome(0);
+	Genome gb = b.chromosome(0);
+
+	return invdist_noncircular(&ga,&gb,0);
+}
+
+static int suite_dcj(const GenomeDesc & a, const GenomeDesc & b){
+	return _DCJ(a,b,false);
+}
+
+// Matrices of genomes that each descend from one ancestor by the given events,
+// computed serially when threads is 1 and otherwise by the parallel path. The
+// suite runs the parallel path on at least two threads, so it is timed even on
+// one processor, where it shows the cost of the threads.
+static void suite_matrix(synthetic_t & random, int num_genomes, int n, const synthetic_events_t & events, int threads){
+	std::vector<intArray> ancestor(n), genes((size_t)num_genomes * n);
+	std::vector<int> offsets(2 * num_genomes), matrix((size_t)num_genomes * num_genomes);
+	std::vector<GenomeDesc> genomes(num_genomes);
+	long rounds, r;
+	double t, elapsed;
+	int i;
+	char kernel[32];
+
+	synthetic_permutation(random,ancestor.data(),n);
+	for(i=0;i<num_genomes;i++){
+		intArray * p = &genes[(size_t)i * n];
+
+		std::copy(ancestor.begin(),ancestor.end(),p);
+		genomes[i] = describe(p,synthetic_evolve(random,p,n,events),&offsets[2 * i]);
+	}
+
+	for(rounds=1;;rounds*=2){
+		t = now();
+		for(r=0;r<rounds;r++){
+			std::fill(matrix.begin(),matrix.end(),DIST_UNKNOWN);
+			if(threads == 1){
+				_distance_matrix(genomes,DIST_BREAKPOINTS,matrix.data());
+			}else{
+				_distance_matrix_parallel(genomes,DIST_BREAKPOINTS,matrix.data(),threads);
+			}
+		}
+		elapsed = now() - t;
+		if(elapsed >= SUITE_SECONDS){
+			break;
+		}
+	}
+
+	if(threads == 1){
+		snprintf(kernel,sizeof(kernel),"matrix");
+	}else{
+		snprintf(kernel,sizeof(kernel),"matrix x%d",threads);
+	}
+	suite_report(kernel,n,rounds * num_genomes * (num_genomes + 1) / 2,elapsed);
+}
+
+// The regression suite: every kernel at every size, on the same genomes each run
+static void bench_suite(){
+	static const int sizes[] = { 16, 37, 100, 400, 1000, 4000 };
+	int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+	int threads = std::max(2u,std::thread::hardware_concurrency());
+	int s;
+
+	printf("regression suite (seed 1, ns per pair and pairs per second)\n");
+	printf("%-14s%8s%10s%12s%14s\n","kernel","genes","pairs","ns/pair","pairs/s");
+
+	for(s=0;s<num_sizes;s++){
+		int n = sizes[s];
+		synthetic_t random(1);
+		suite_pairs_t pairs;
+
+		// About one rearrangement for every ten genes, a third of them
+		// transpositions, with a loss for every fifty genes where content may differ
+		synthetic_events_t events = { n / 15 + 1, n / 30 + 1, n / 50 };
+		synthetic_events_t same_content = { n / 15 + 1, n / 30 + 1, 0 };
+
+		suite_make(pairs,random,n,events);
+		suite_time("breakpoints",n,pairs,suite_breakpoints);
+		suite_time("adjacencies",n,pairs,suite_adjacencies);
+
+		suite_make(pairs,random,n,same_content);
+		suite_time("invdist",n,pairs,suite_invdist);
+		suite_time("DCJ",n,pairs,suite_dcj);
+
+		suite_matrix(random,n <= 400 ? 300 : 100,n,events,1);
+		suite_matrix(random,n <= 400 ? 300 : 100,n,events,threads);
+	}
+}
+
+int main(int argc, char ** argv){
+	srand(1);
+
+	if(argc > 1 && !strcmp(argv[1],"suite")){
+		bench_suite();
+		return 0;
+	}
+
+	printf("breakpoints (ns per call)\n");
+	printf("%-8s%14s%14s%11s\n","genes","scan","index","speedup");
+	bench_breakpoints(40);
+	bench_breakpoints(400);
+	bench_breakpoints(4000);
+
+	printf("\nbreakpoints of short genomes (ns per call, %s by default)\n",adjmatch_isa());
+	printf("%-8s%8s%10s%10s%10s%10s\n","genes","pairs","index","scalar","sse4.1","avx2");
+	bench_adjmatch(16,200000);
+	bench_adjmatch(37,200000);
+	bench_adjmatch(70,100000);
+	bench_adjmatch(128,50000);
+	bench_adjmatch(256,20000);
+	bench_adjmatch(512,10000);
+
+	printf("\ninversions (allocations per run, ns per call)\n");
+	printf("%-8s%8s%12s%12s%12s%12s\n","genes","pairs","allocs new","allocs pool","new","pool");
+	bench_inversions(40,100000);
+	bench_inversions(400,10000);
+	bench_inversions(4000,1000);
+
+	printf("\nbreakpoint graph vertices (ns and cache misses per call, \"-\" without perf counters)\n");
+	printf("%-8s%8s%10s%10s%10s%10s%10s%10s\n","genes","pairs","32 bit","L1","LLC","16 bit","L1","LLC");
+	bench_layout(400,10000);
+	bench_layout(4000,1000);
+	bench_layout(16000,200);
+	bench_layout(32000,100);
+
+	printf("\ncircular inversions (ns per call)\n");
+	printf("%-8s%8s%12s%12s\n","genes","pairs","offset","circular");
+	bench_circular(37,100000);
+	bench_circular(70,100000);
+	bench_circular(400,10000);
+	bench_circular(4000,1000);
+
+	printf("\nvalidation (allocations per run, ns per call)\n");
+	printf("%-8s%8s%12s%12s%12s%12s\n","genes","pairs","sort allocs","mark allocs","sort","marks");
+	bench_validate(40,100000);
+	bench_validate(400,10000);
+	bench_validate(4000,1000);
+
+	printf("\nDCJ (ns per call)\n");
+	printf("%-8s%8s%12s%12s\n","genes","pairs","inversions","DCJ");
+	bench_dcj(40,100000);
+	bench_dcj(400,10000);
+	bench_dcj(4000,1000);
+
+	printf("\nmatrix (seconds per matrix)\n");
+	printf("%-12s%8s%8s%10s%10s\n","metric","genomes","threads","time","speedup");
+	bench_matrix(1000,DIST_BREAKPOINTS,"breakpoints");
+
+	printf("\nmatrix tiles with the metric hoisted out of the cells (ns per cell, serial)\n");
+	printf("%-12s%-9s%6s%8s%8s%12s%12s%10s\n","metric","topology","bits","genomes","genes","per cell","hoisted","speedup");
+	bench_hoisted<intArray>("breakpoints",DIST_BREAKPOINTS,1000,37,true);
+	bench_hoisted<intArray32>("breakpoints",DIST_BREAKPOINTS,1000,37,true);
+	bench_hoisted<intArray32>("breakpoints",DIST_BREAKPOINTS,1000,37,false);
+	bench_hoisted<intArray32>("breakpoints",DIST_BREAKPOINTS,300,400,false);
+	bench_hoisted<intArray>("inversions",DIST_INVERSIONS,500,37,true);
+	bench_hoisted<intArray>("inversions",DIST_INVERSIONS,500,37,false);
+	bench_hoisted<intArray>("DCJ",DIST_DCJ,500,37,true);
+
+	printf("\ntrees of 37 gene genomes by breakpoints (seconds per tree, \"-\" not run)\n");
+	printf("%-8s%12s%12s%12s%12s\n","genomes","NJ scan","NJ","UPGMA scan","UPGMA");
+	bench_tree(250,37);
+	bench_tree(1000,37);
+	bench_tree(4000,37);
+
+	printf("\ninversion scenarios (ms per scenario, \"-\" not run)\n");
+	printf("%-8s%10s%12s%12s%10s\n","genes","distance","scan","bit rows","speedup");
+	bench_scenario(37,6);
+	bench_scenario(37,-1);
+	bench_scenario(100,15);
+	bench_scenario(100,-1);
+	bench_scenario(400,60);
+	bench_scenario(400,-1);
+	bench_scenario(1000,-1);
+	bench_scenario(4000,-1);
+
+	printf("\nmedians of %d triples (ms per median, medians optimal or at the bound, mean score above the bound)\n",MEDIAN_TRIPLES);
+	printf("%-8s%8s%12s%10s%10s%12s%10s%10s\n","genes","events","inversions","optimal","gap","DCJ","at bound","gap");
+	bench_median(37,2,true);
+	bench_median(37,4,true);
+	bench_median(37,6,true);
+	bench_median(37,10,true);
+	bench_median(100,3,true);
+	bench_median(100,10,true);
+	bench_median(400,20,false);
+	bench_median(1000,50,false);
+	bench_median(4000,200,false);
+
+	printf("\n");
+	bench_suite();
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+#include <vector>
+#include "dcj.h"
+
+// Every gene g has a tail extremity 2g-1 and a head extremity 2g.
+// Reading a chromosome left to right, +g shows its tail then its head
+// and -g shows its head then its tail.
+#define TAIL(g)		(2 * (g) - 1)
+#define HEAD(g)		(2 * (g))
+#define LEFT(g)		((g) > 0 ? TAIL(g) : HEAD(-(g)))
+#define RIGHT(g)	((g) > 0 ? HEAD(g) : TAIL(-(g)))
+
+// Fill partner[] so that every extremity points to the extremity it is adjacent to,
+// or to 0 if it is a telomere at the end of a linear chromosome
+template <typename T>
+static void adjacencies(const GenomeDescT<T> & g, int * partner){
+
+	int c,k;
+	const T * p = g.genes;
+	
+	for(c=0;c<g.num_chromosomes;c++){
+		int begin = g.offsets[c];
+		int end = g.offsets[c+1];
+		
+		if(end == begin){
+			continue;
+		}
+		
+		for(k=begin;k<end-1;k++){
+			partner[RIGHT(p[k])] = LEFT(p[k+1]);
+			partner[LEFT(p[k+1])] = RIGHT(p[k]);
+		}
+		
+		if(g.circular[c]){
+			partner[RIGHT(p[end-1])] = LEFT(p[begin]);
+			partner[LEFT(p[begin])] = RIGHT(p[end-1]);
+		}else{
+			partner[LEFT(p[begin])] = 0;
+			partner[RIGHT(p[end-1])] = 0;
+		}
+	}
+}
+
+// Walk a component of the adjacency graph starting from extremity e on the given side.
+// Vertices alternate between adjacencies of g1 and g2 and are joined through the
+// extremities they share. Returns the side (0 or 1) whose telomere ends the path,
+// or -1 if the walk came back to e and the component is a cycle.
+static int walk(int e, int side, int ** partner, char * visited){
+
+	int start = e;
+	
+	while(1){
+		visited[e] = 1;
+		
+		int next = partner[side][e];
+		if(next == 0){
+			return side;
+		}
+		
+		visited[next] = 1;
+		side = 1 - side;
+		e = next;
+		
+		if(e == start){
+			return -1;
+		}
+	}
+}
+
+// The DCJ distance of Bergeron, Mixtacki and Stoye (2006):
+//	d = N - (C + I/2)
+// where N is the number of genes, C the number of cycles and I the number of odd
+// paths in the adjacency graph.  Both genomes may have any mix of linear and circular
+// chromosomes, and must have the same genes numbered 1..N.
+template <typename T>
+int dcj_distance(const GenomeDescT<T> & g1, const GenomeDescT<T> & g2){
+
+	static thread_local std::vector<int> partner1;
+	static thread_local std::vector<int> partner2;
+	static thread_local std::vector<char> visited;
+	
+	int k,e;
+	int num_genes = g1.num_genes();
+	int max_gene = 0;
+	int cycles = 0;
+	int odd_paths = 0;
+	
+	for(k=0;k<num_genes;k++){
+		int g = abs(g1.genes[k]);
+		if(g > max_gene){
+			max_gene = g;
+		}
+	}
+	
+	int size = 2 * max_gene + 1;
+	partner1.assign(size,0);
+	partner2.assign(size,0);
+	visited.assign(size,0);
+	
+	adjacencies(g1,&partner1[0]);
+	adjacencies(g2,&partner2[0]);
+	
+	int * partner[2] = { &partner1[0], &partner2[0] };
+	
+	// Paths start at telomeres. A path from a telomere of g1 to a telomere of g2 is odd
+	for(e=1;e<size;e++){
+		if(!visited[e] && partner1[e] == 0){
+			if(walk(e,1,partner,&visited[0]) == 1){
+				odd_paths++;
+			}
+		}
+	}
+	
+	// Paths between two telomeres of g2
+	for(e=1;e<size;e++){
+		if(!visited[e] && partner2[e] == 0){
+			walk(e,0,partner,&visited[0]);
+		}
+	}
+	
+	// Whatever has not been visited lies on a cycle
+	for(e=1;e<size;e++){
+		if(!visited[e]){
+			walk(e,1,partner,&visited[0]);
+			cycles++;
+		}
+	}
+	
+	return num_genes - (cycles + odd_paths / 2);
+}
+
+template int dcj_distance(const GenomeDesc &, const GenomeDesc &);
+template int dcj_distance(const GenomeDesc32 &, const GenomeDesc32 &);
@@ -0,0 +1,9 @@
+#ifndef DCJ_H
+#define DCJ_H
+
+#include "structs.h"
+
+template <typename T>
+int dcj_distance(const GenomeDescT<T> & g1, const GenomeDescT<T> & g2);
+
+#endif
@@ -1,169 +1,120 @@
 #include "distances.h"
 #include "invdist.h"
+#include "dcj.h"
+#include "adjmatch.h"
+#include "diststats.h"
 
-std::vector<intArray> _adjacencies(Genome * pi, Genome * id){
+template <typename T>
+std::vector<T> _adjacencies(const GenomeDescT<T> & pi, const GenomeDescT<T> & id){
 
-	int num_pi;
-	int num_id;
-	int i,j,k,l;
+	STATS_TIME(STAT_ADJACENCIES,pi.num_genes() + id.num_genes());
+	int c,k;
 	
-	num_pi = sizeof(pi)/sizeof(Genome *);
-	num_id = sizeof(id)/sizeof(Genome *);
+	std::vector<T> shared_bounds;
 	
-	std::vector<intArray> shared_bounds;
+	// Index every boundary in the identity genome once, in the thread's own index
+	static thread_local adjindex_T<T> index;
+	index.build(id);
 	
-	// For each permutation in the identity genome
-	for(i=0;i<num_id;i++){
+	const T * p = pi.genes;
+	
+	// Go through each chromosome of the comparison genome
+	for(c=0;c<pi.num_chromosomes;c++){
+		int begin = pi.offsets[c];
+		int end = pi.offsets[c+1];
 		
-		// Go through each permutation in the comparison genome
-		for(j=0;j<num_pi;j++){
-			int find;
-			
-			// And go through each gene boundary in the comparison permutation
-			for(k=0;k<pi[j].len-1;k++){
-				find = 0;
-				
-				// These are the genes in the boundary
-				int pi1 = pi[j].pi[k];
-				int pi2 = pi[j].pi[k+1];
-				
-				// Check if each boundary is in the identiy permutation
-				for(l=0;l<id[i].len-1;l++){
-					int id1 = id[i].pi[l];
-					int id2 = id[i].pi[l+1];
-					
-					if( (pi1 == id1 && pi2 == id2) || (-pi1 == id2 && -pi2 == id1) ){
-						find++;
-					}
-				}
-				
-				if(find){
-					shared_bounds.push_back(pi1);
-					shared_bounds.push_back(pi2);
-				}
+		// And look up each gene boundary in the comparison chromosome
+		for(k=begin;k<end-1;k++){
+			if(index.contains(p[k],p[k+1])){
+				shared_bounds.push_back(p[k]);
+				shared_bounds.push_back(p[k+1]);
 			}
+		}
 
-			// If the comparison permutation is circular then check the ends
-			if(pi[j].circular){
-				find = 0;
-				
-				// These are the genes in the boundary
-				int pi1 = pi[j].pi[pi[j].len-1];
-				int pi2 = pi[j].pi[0];
-				
-				// Check if the end boundary is in the identity permutation
-				for(l=0;l<id[i].len-1;l++){
-					int id1 = id[i].pi[l];
-					int id2 = id[i].pi[l+1];
-					
-					if( (pi1 == id1 && pi2 == id2) || (-pi1 == id2 && -pi2 == id1) ){
-						find++;
-					}
-				}
-				
-				// Check the ends of the identity if it is ciruclar
-				if(id[i].circular){
-					int id1 = id[i].pi[id[i].len-1];
-					int id2 = id[i].pi[0];
-					
-					if( (pi1 == id1 && pi2 == id2) || (-pi1 == id2 && -pi2 == id1) ){
-						find++;
-					}
-				}
-				
-				if(find){
-					shared_bounds.push_back(pi1);
-					shared_bounds.push_back(pi2);
-				}
+		// If the comparison chromosome is circular then check the ends
+		if(pi.circular[c] && end > begin){
+			if(index.contains(p[end-1],p[begin])){
+				shared_bounds.push_back(p[end-1]);
+				shared_bounds.push_back(p[begin]);
 			}
-			
 		}
 	}
 
 	return shared_bounds;
 }
 
-int _breakpoints(Genome * pi, Genome * id){
+// The scalar lookups of _shared_adjacencies, in a direct or a hash index
+template <bool DIRECT, typename T>
+static inline int shared_lookup(const GenomeDescT<T> & pi, const adjindex_T<T> & index, int * num_bounds){
 
-	int num_pi;
-	int num_id;
-	int i,j,k,l,bA,bB,bID,b;
-	bA = bB = b = bID = 0;
+	int c,k,b;
+	int bounds = 0;
+	b = 0;
 	
-	num_pi = sizeof(pi)/sizeof(Genome *);
-	num_id = sizeof(id)/sizeof(Genome *);
+	const T * p = pi.genes;
 	
-	// For each permutation in the identity genome
-	for(i=0;i<num_id;i++){
-		bID += bB;
+	// One pass over the gene buffer, looking up each boundary within a chromosome
+	for(c=0;c<pi.num_chromosomes;c++){
+		int begin = pi.offsets[c];
+		int end = pi.offsets[c+1];
 		
-		// Go through each permutation in the comparison genome
-		for(j=0;j<num_pi;j++){
-			int find;
-			
-			// And go through each gene boundary in the comparison permutation
-			for(k=0;k<pi[j].len-1;k++){
-				find = 0;
-				bA++;
-				
-				// These are the genes in the boundary
-				int pi1 = pi[j].pi[k];
-				int pi2 = pi[j].pi[k+1];
-				
-				// Check if each boundary is in the identiy permutation
-				bB = 0;
-				for(l=0;l<id[i].len-1;l++){
-					int id1 = id[i].pi[l];
-					int id2 = id[i].pi[l+1];
-					bB++;
-					
-					if( (pi1 == id1 && pi2 == id2) || (-pi1 == id2 && -pi2 == id1) ){
-						find++;
-					}
-				}
-				
-				if(find){
-					b++;
-				}
-			}
+		for(k=begin;k<end-1;k++){
+			b += DIRECT ? index.contains_direct(p[k],p[k+1]) : index.contains_hashed(p[k],p[k+1]);
+		}
+		bounds += end > begin ? end - begin - 1 : 0;
 
-			// If the comparison permutation is circular then check the ends
-			if(pi[j].circular){
-				find = 0;
-				bA++;
-				bB++;
-				
-				// These are the genes in the boundary
-				int pi1 = pi[j].pi[pi[j].len-1];
-				int pi2 = pi[j].pi[0];
-				
-				// Check if the end boundary is in the identity permutation
-				for(l=0;l<id[i].len-1;l++){
-					int id1 = id[i].pi[l];
-					int id2 = id[i].pi[l+1];
-					
-					if( (pi1 == id1 && pi2 == id2) || (-pi1 == id2 && -pi2 == id1) ){
-						find++;
-					}
-				}
-				
-				// Check the ends of the identity if it is ciruclar
-				if(id[i].circular){
-					int id1 = id[i].pi[id[i].len-1];
-					int id2 = id[i].pi[0];
-					
-					if( (pi1 == id1 && pi2 == id2) || (-pi1 == id2 && -pi2 == id1) ){
-						find++;
-					}
-				}
-				
-				if(find){
-					b++;
-				}
-			}
-			
+		// If the comparison chromosome is circular then check the ends
+		if(pi.circular[c] && end > begin){
+			bounds++;
+			b += DIRECT ? index.contains_direct(p[end-1],p[begin]) : index.contains_hashed(p[end-1],p[begin]);
+		}
+	}
+	
+	*num_bounds = bounds;
+	return b;
+}
+
+// The vector kernels of adjmatch.h count 16 bit genomes against a direct index;
+// 32 bit genomes look a direct index up one adjacency at a time.
+template <typename T>
+struct shared_T
+{
+	static int count(const GenomeDescT<T> & pi, const adjindex_T<T> & index, int * num_bounds){
+		if(index.direct){
+			return shared_lookup<true>(pi,index,num_bounds);
+		}
+		return shared_lookup<false>(pi,index,num_bounds);
+	}
+};
+
+template <>
+struct shared_T<intArray>
+{
+	static int count(const GenomeDesc & pi, const adjindex_t & index, int * num_bounds){
+		if(index.direct){
+			return count_partners(pi,index.partner.data(),index.stamp,num_bounds);
 		}
+		return shared_lookup<false>(pi,index,num_bounds);
 	}
+};
+
+template <typename T>
+int _shared_adjacencies(const GenomeDescT<T> & pi, const adjindex_T<T> & index, int * num_bounds){
+	return shared_T<T>::count(pi,index,num_bounds);
+}
+
+template <typename T>
+int _breakpoints(const GenomeDescT<T> & pi, const GenomeDescT<T> & id){
+
+	STATS_TIME(STAT_BREAKPOINTS,pi.num_genes() + id.num_genes());
+	int bA,bB,b;
+	
+	// Index every boundary in the identity genome once, in the thread's own index
+	static thread_local adjindex_T<T> index;
+	index.build(id);
+	bB = index.num_adjacencies;
+	
+	b = _shared_adjacencies(pi,index,&bA);
 	
 	// The number of breakpoints is the difference between the number of adjacencies
 	// and the size of the largest genome;
@@ -172,147 +123,370 @@ int _breakpoints(Genome * pi, Genome * id){
 	return b;
 }
 
-int _inversions(Genome * pi, Genome * id){
+// The DCJ distance, uncounted, for the kernels that count their own calls
+template <typename T>
+static inline int dcj(const GenomeDescT<T> & pi, const GenomeDescT<T> & id, bool validate){
 
-	int i;
-	int inversions;
+	int err = validate ? _validate(pi,&id) : _validate_lengths(pi,id);
 	
-	int num_pi = sizeof(pi)/sizeof(Genome *);
-	int num_id = sizeof(id)/sizeof(Genome *);
+	if(err){
+		return err;
+	}
 	
-	if(duplicates(pi) || duplicates(id)){
-		return ERR_DUPLICATES;
-	}else if(unequal_content(pi,id)){
-		return ERR_CONTENT;
-	}else{
+	return dcj_distance(pi,id);
+}
+
+// The inversion distance, uncounted. Single chromosomes go to the inversion
+// kernels, circular when either is, and genomes of several chromosomes to DCJ
+// when one is circular.
+template <typename T>
+static inline int inversions(const GenomeDescT<T> & pi, const GenomeDescT<T> & id, bool validate){
+
+	int c;
 	
-		if(num_pi == num_id == 1){
-		
-			if(pi[0].circular){
-			
-				inversions = invdist_circular(id,pi) + 1 - id[0].circular;
-			
-			}else if(id[0].circular){
-			
-				inversions = invdist_circular(pi,id) + 1;
-				
-			}else{
-			
-				inversions = invdist_noncircular(pi,id,0);
-			}
-			
-		}else{
+	int err = validate ? _validate(pi,&id) : _validate_lengths(pi,id);
+	
+	if(err){
+		return err;
+	}
+	
+	if(pi.num_chromosomes == 1 && id.num_chromosomes == 1){
+		GenomeT<T> g1 = pi.chromosome(0);
+		GenomeT<T> g2 = id.chromosome(0);
 		
-			for(i=0;i<num_pi || i<num_id;i++){
-				if(pi[i].circular || id[i].circular){
-					return _DCJ(pi,id);
-				}
-			}
-			
-			//inversions = mcdist_noncircular(pi,id);
-			
-		}	
+		if(g1.circular){
+			return invdist_circular(&g2,&g1);
+		}
+		if(g2.circular){
+			return invdist_circular(&g1,&g2);
+		}
+		return invdist_noncircular(&g1,&g2,0);
+	}
+	
+	for(c=0;c<pi.num_chromosomes;c++){
+		if(pi.circular[c]){
+			return dcj(pi,id,false);
+		}
+	}
+	for(c=0;c<id.num_chromosomes;c++){
+		if(id.circular[c]){
+			return dcj(pi,id,false);
+		}
 	}
 	
-	return inversions;
+	//inversions = mcdist_noncircular(pi,id);
+	return ERR_MULTICHR;
 }
 
+template <typename T>
+int _inversions(const GenomeDescT<T> & pi, const GenomeDescT<T> & id, bool validate){
 
-int _DCJ(Genome * pi, Genome * id){
-
-	int i;
-	int dcj;
+	STATS_TIME(STAT_INVERSIONS,pi.num_genes() + id.num_genes());
 	
-	int num_pi = sizeof(pi)/sizeof(Genome *);
-	int num_id = sizeof(id)/sizeof(Genome *);
+	return inversions(pi,id,validate);
+}
+
+
+template <typename T>
+int _DCJ(const GenomeDescT<T> & pi, const GenomeDescT<T> & id, bool validate){
+
+	STATS_TIME(STAT_DCJ,pi.num_genes() + id.num_genes());
 	
-	if(duplicates(pi) || duplicates(id)){
-		return ERR_DUPLICATES;
-	}else if(unequal_content(pi,id)){
-		return ERR_CONTENT;
-	}else{
+	return dcj(pi,id,validate);
+}
+
+template <typename T>
+int _inversion_scenario(const GenomeDescT<T> & pi, const GenomeDescT<T> & id, std::vector<inversion_t> & scenario){
+
+	STATS_TIME(STAT_INVERSIONS,pi.num_genes() + id.num_genes());
+	int err = _validate(pi,&id);
 	
-		return ERR_NOTIMPL;
+	scenario.clear();
+	if(err){
+		return err;
+	}
+	if(pi.num_chromosomes != 1 || id.num_chromosomes != 1){
+		return ERR_MULTICHR;
 	}
 	
+	GenomeT<T> g1 = pi.chromosome(0);
+	GenomeT<T> g2 = id.chromosome(0);
 	
-	return dcj;
+	return invsort(&g1,&g2,scenario);
 }
 
-bool duplicates(Genome * pi){
-	int num_pi;
-	int i,j;
+template <typename T>
+int _median(const GenomeDescT<T> * const g[3], int metric, double seconds, median_t & median){
+
+	int err = _validate(*g[0],g[1]);
 	
-	num_pi = sizeof(pi)/sizeof(Genome *);
+	if(!err){
+		err = _validate(*g[0],g[2]);
+	}
+	if(err){
+		return err;
+	}
+	
+	if(metric == DIST_DCJ){
+		return dcj_median(g,median);
+	}
+	if(metric != DIST_INVERSIONS){
+		return ERR_NOTIMPL;
+	}
+	if(g[0]->num_chromosomes != 1 || g[1]->num_chromosomes != 1 || g[2]->num_chromosomes != 1){
+		return ERR_MULTICHR;
+	}
+	
+	GenomeT<T> c[3] = { g[0]->chromosome(0), g[1]->chromosome(0), g[2]->chromosome(0) };
+	GenomeT<T> * const chromosomes[3] = { &c[0], &c[1], &c[2] };
 	
-	std::vector<intArray> genes;
+	return inversion_median(chromosomes,seconds,median);
+}
+
+// The timer that counts the cells of a metric
+static inline int stat_timer(int metric){
+	switch(metric){
+		case DIST_ADJACENCIES:
+			return STAT_ADJACENCIES;
+		case DIST_BREAKPOINTS:
+			return STAT_BREAKPOINTS;
+		case DIST_INVERSIONS:
+			return STAT_INVERSIONS;
+		default:
+			return STAT_DCJ;
+	}
+}
+
+// What every row of a tile shares
+template <typename T>
+struct tile_T
+{
+	GenomeDescT<T> * genomes;
+	int n;
+	int * matrix;
+	adjindex_T<T> * index;
+	bool validate;
+};
+
+// The cells of row i from column i or col_begin on, with genome i as the
+// identity, so the adjacency index of genome i is built once and shared by the
+// row. Cells that already hold a distance, e.g. from the cache, are left alone.
+template <int METRIC, typename T>
+static void tile_row(const tile_T<T> & tile, int i, int col_begin, int col_end){
+
+	int n = tile.n;
+	int j,d,bA,bB;
+	int cells = 0;
+	bool indexed = false;
+	unsigned long long genes = 0;
+	unsigned long long start = STATS_NOW();
 	
-	// For each permutation in the genome
-	for(i=0;i<num_pi;i++){
+	for(j=(i > col_begin ? i : col_begin);j<col_end;j++){
+		if(tile.matrix[(size_t)i * n + j] != DIST_UNKNOWN){
+			continue;
+		}
+		cells++;
+		genes += tile.genomes[j].num_genes();
+		
+		if(METRIC == DIST_ADJACENCIES || METRIC == DIST_BREAKPOINTS){
+			if(!indexed){
+				tile.index->build(tile.genomes[i]);
+				indexed = true;
+			}
 			
-			// Go through each gene
-			for(j=0;j<pi[i].len;j++){
-				
-				genes.push_back(abs(pi[i].pi[j]));
-				
+			d = shared_T<T>::count(tile.genomes[j],*tile.index,&bA);
+			if(METRIC == DIST_BREAKPOINTS){
+				bB = tile.index->num_adjacencies;
+				d = bA > bB ? bA - d : bB - d;
 			}
+		}else if(METRIC == DIST_INVERSIONS){
+			d = inversions(tile.genomes[j],tile.genomes[i],tile.validate);
+		}else if(METRIC == DIST_DCJ){
+			d = dcj(tile.genomes[j],tile.genomes[i],tile.validate);
+		}else{
+			d = ERR_NOTIMPL;
+		}
+		
+		tile.matrix[(size_t)i * n + j] = tile.matrix[(size_t)j * n + i] = d;
+	}
+	
+	// One count per row keeps the clock out of the cells
+	if(cells && METRIC >= DIST_ADJACENCIES && METRIC <= DIST_DCJ){
+		genes += (unsigned long long)cells * tile.genomes[i].num_genes();
+		STATS_COUNT(stat_timer(METRIC),cells,genes,STATS_NOW() - start);
+	}
+}
+
+template <int METRIC, typename T>
+static void matrix_tile(const tile_T<T> & tile, int row_begin, int row_end, int col_begin, int col_end){
+
+	int i;
+	
+	// Each row compares the later genomes against genome i
+	for(i=row_begin;i<row_end;i++){
+		tile_row<METRIC>(tile,i,col_begin,col_end);
 	}
+}
+
+template <typename T>
+void _distance_matrix_tile(std::vector< GenomeDescT<T> > & genomes, int metric, int * matrix,
+						   int row_begin, int row_end, int col_begin, int col_end, adjindex_T<T> & index,
+						   bool validate){
+
+	tile_T<T> tile = { genomes.data(), (int)genomes.size(), matrix, &index, validate };
 	
-	std::sort( genes.begin(), genes.end() );
+	switch(metric){
+		case DIST_ADJACENCIES:
+			matrix_tile<DIST_ADJACENCIES>(tile,row_begin,row_end,col_begin,col_end);
+			break;
+		case DIST_BREAKPOINTS:
+			matrix_tile<DIST_BREAKPOINTS>(tile,row_begin,row_end,col_begin,col_end);
+			break;
+		case DIST_INVERSIONS:
+			matrix_tile<DIST_INVERSIONS>(tile,row_begin,row_end,col_begin,col_end);
+			break;
+		case DIST_DCJ:
+			matrix_tile<DIST_DCJ>(tile,row_begin,row_end,col_begin,col_end);
+			break;
+		default:
+			matrix_tile<0>(tile,row_begin,row_end,col_begin,col_end);
+	}
+}
+
+template <typename T>
+void _distance_matrix(std::vector< GenomeDescT<T> > & genomes, int metric, int * matrix, bool validate){
+
+	int n = genomes.size();
+	adjindex_T<T> index;
 	
-	for(i=0;i<genes.size()-1;i++){
-		if(genes[i] == genes[i+1]){
-			return 1;
+	_distance_matrix_tile(genomes,metric,matrix,0,n,0,n,index,validate);
+}
+
+static inline unsigned long long adjacency_pair(int a, int b){
+	unsigned long long e = right_extremity(a);
+	unsigned long long f = left_extremity(b);
+
+	return e < f ? e << 32 | f : f << 32 | e;
+}
+
+template <typename T>
+void _adjacency_signature(const GenomeDescT<T> & pi, std::vector<unsigned long long> & signature){
+
+	int c,k;
+	const T * p = pi.genes;
+
+	signature.clear();
+	for(c=0;c<pi.num_chromosomes;c++){
+		int begin = pi.offsets[c];
+		int end = pi.offsets[c+1];
+
+		for(k=begin;k<end-1;k++){
+			signature.push_back(adjacency_pair(p[k],p[k+1]));
+		}
+		// As in _shared_adjacencies, a circular chromosome joins its ends
+		if(pi.circular[c] && end > begin){
+			signature.push_back(adjacency_pair(p[end-1],p[begin]));
 		}
 	}
-	return 0;
+	std::sort(signature.begin(),signature.end());
 }
 
-bool unequal_content(Genome * pi, Genome * id){
-	int num_pi;
-	int num_id;
-	int i,j;
+// Stamps for the genes seen by the current validation. Every validation takes
+// two fresh stamps, one for each genome, so the array never has to be cleared.
+static thread_local std::vector<unsigned int> gene_marks;
+static thread_local unsigned int gene_epoch = 0;
+
+template <typename T>
+int _validate(const GenomeDescT<T> & pi, const GenomeDescT<T> * id){
+	int k,g;
+	int max_gene = 0;
+	int len_pi = pi.num_genes();
+	bool missing = false;
 	
-	num_pi = sizeof(pi)/sizeof(Genome *);
-	num_id = sizeof(id)/sizeof(Genome *);
+	const T * p = pi.genes;
 	
-	std::vector<intArray> genesA;
-	std::vector<intArray> genesB;
+	for(k=0;k<len_pi;k++){
+		g = abs(p[k]);
+		if(g > max_gene){
+			max_gene = g;
+		}
+	}
 	
-	// For each permutation in the genome
-	for(i=0;i<num_pi;i++){
-			
-			// Go through each gene
-			for(j=0;j<pi[i].len;j++){
-				
-				genesA.push_back(abs(pi[i].pi[j]));
-				
-			}
+	std::vector<unsigned int> & marks = gene_marks;
+	if((int)marks.size() <= max_gene){
+		marks.resize(max_gene + 1,0);
 	}
 	
-	// For each permutation in the genome
-	for(i=0;i<num_id;i++){
-			
-			// Go through each gene
-			for(j=0;j<id[i].len;j++){
-				
-				genesB.push_back(abs(id[i].pi[j]));
-				
-			}
+	if(gene_epoch >= UINT_MAX - 2){
+		std::fill(marks.begin(),marks.end(),0);
+		gene_epoch = 0;
 	}
+	unsigned int in_pi = ++gene_epoch;
+	unsigned int in_id = ++gene_epoch;
+	unsigned int * mark = marks.data();
 	
-	std::sort( genesA.begin(), genesA.end() );
-	std::sort( genesB.begin(), genesB.end() );
+	for(k=0;k<len_pi;k++){
+		g = abs(p[k]);
+		if(mark[g] == in_pi){
+			return ERR_DUPLICATES;
+		}
+		mark[g] = in_pi;
+	}
 	
-	if( genesA.size() != genesB.size() ){
-		return 1;
+	if(id == NULL){
+		return 0;
 	}
 	
-	for(i=0;i<genesA.size();i++){
-		if(genesA[i] != genesB[i]){
-			return 1;
+	// Every gene of the identity must have been seen once in pi. With no
+	// duplicates on either side, equal lengths then mean equal content.
+	int len_id = id->num_genes();
+	const T * q = id->genes;
+	
+	for(k=0;k<len_id;k++){
+		g = abs(q[k]);
+		if(g > max_gene || mark[g] != in_pi){
+			if(g <= max_gene && mark[g] == in_id){
+				return ERR_DUPLICATES;
+			}
+			missing = true;
+			continue;
 		}
+		mark[g] = in_id;
+	}
+	
+	if(missing || len_pi != len_id){
+		return ERR_CONTENT;
 	}
 	
 	return 0;
-}
\ No newline at end of file
+}
+
+template <typename T>
+int _validate_lengths(const GenomeDescT<T> & pi, const GenomeDescT<T> & id){
+	return pi.num_genes() != id.num_genes() ? ERR_CONTENT : 0;
+}
+
+template std::vector<intArray> _adjacencies(const GenomeDesc &, const GenomeDesc &);
+template std::vector<intArray32> _adjacencies(const GenomeDesc32 &, const GenomeDesc32 &);
+template int _breakpoints(const GenomeDesc &, const GenomeDesc &);
+template int _breakpoints(const GenomeDesc32 &, const GenomeDesc32 &);
+template int _inversions(const GenomeDesc &, const GenomeDesc &, bool);
+template int _inversions(const GenomeDesc32 &, const GenomeDesc32 &, bool);
+template int _DCJ(const GenomeDesc &, const GenomeDesc &, bool);
+template int _DCJ(const GenomeDesc32 &, const GenomeDesc32 &, bool);
+template int _inversion_scenario(const GenomeDesc &, const GenomeDesc &, std::vector<inversion_t> &);
+template int _inversion_scenario(const GenomeDesc32 &, const GenomeDesc32 &, std::vector<inversion_t> &);
+template int _median(const GenomeDesc * const [3], int, double, median_t &);
+template int _median(const GenomeDesc32 * const [3], int, double, median_t &);
+template void _distance_matrix_tile(std::vector<GenomeDesc> &, int, int *, int, int, int, int, adjindex_t &, bool);
+template void _distance_matrix_tile(std::vector<GenomeDesc32> &, int, int *, int, int, int, int, adjindex32_t &, bool);
+template void _distance_matrix(std::vector<GenomeDesc> &, int, int *, bool);
+template void _distance_matrix(std::vector<GenomeDesc32> &, int, int *, bool);
+template int _validate(const GenomeDesc &, const GenomeDesc *);
+template int _validate(const GenomeDesc32 &, const GenomeDesc32 *);
+template int _validate_lengths(const GenomeDesc &, const GenomeDesc &);
+template int _validate_lengths(const GenomeDesc32 &, const GenomeDesc32 &);
+template int _shared_adjacencies(const GenomeDesc &, const adjindex_t &, int *);
+template int _shared_adjacencies(const GenomeDesc32 &, const adjindex32_t &, int *);
+template void _adjacency_signature(const GenomeDesc &, std::vector<unsigned long long> &);
+template void _adjacency_signature(const GenomeDesc32 &, std::vector<unsigned long long> &);
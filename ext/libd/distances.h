@@ -5,17 +5,66 @@
 #include <vector>
 #include <algorithm>
 #include "structs.h"
+#include "adjindex.h"
+#include "invsort.h"
+#include "median.h"
 
-std::vector<intArray> _adjacencies(Genome * pi, Genome * id);
+// Every kernel takes whole genomes and is instantiated for 16 bit (GenomeDesc)
+// and 32 bit (GenomeDesc32) gene identifiers
 
-int _breakpoints(Genome * pi, Genome * id);
+template <typename T>
+std::vector<T> _adjacencies(const GenomeDescT<T> & pi, const GenomeDescT<T> & id);
 
-int _inversions(Genome * pi, Genome * id);
+template <typename T>
+int _shared_adjacencies(const GenomeDescT<T> & pi, const adjindex_T<T> & index, int * num_bounds);
 
-int _DCJ(Genome * pi, Genome * id);
+template <typename T>
+int _breakpoints(const GenomeDescT<T> & pi, const GenomeDescT<T> & id);
 
-bool duplicates(Genome * pi);
+// Passing validate = false skips the per gene checks of genomes that are already
+// known to be valid, leaving only the comparison of their lengths
+template <typename T>
+int _inversions(const GenomeDescT<T> & pi, const GenomeDescT<T> & id, bool validate = true);
 
-bool unequal_content(Genome * pi, Genome * id);
+template <typename T>
+int _DCJ(const GenomeDescT<T> & pi, const GenomeDescT<T> & id, bool validate = true);
+
+// The inversions that turn pi into id, fewest possible (see invsort.h). Both must
+// be single chromosomes, and both linear or both circular. Returns the inversion
+// distance, or ERR_DUPLICATES, ERR_CONTENT, ERR_CIRCULAR or ERR_MULTICHR.
+template <typename T>
+int _inversion_scenario(const GenomeDescT<T> & pi, const GenomeDescT<T> & id, std::vector<inversion_t> & scenario);
+
+// A median of the three genomes under DIST_INVERSIONS, exact within the time
+// limit, or DIST_DCJ, by a heuristic (see median.h). Returns its score, or
+// ERR_DUPLICATES, ERR_CONTENT, ERR_CIRCULAR, ERR_MULTICHR for inversion medians
+// of several chromosomes, or ERR_NOTIMPL for other metrics.
+template <typename T>
+int _median(const GenomeDescT<T> * const g[3], int metric, double seconds, median_t & median);
+
+// Fills the cells of the n*n matrix that hold DIST_UNKNOWN and keeps the rest.
+// The metric is dispatched on once per tile rather than for every cell.
+template <typename T>
+void _distance_matrix_tile(std::vector< GenomeDescT<T> > & genomes, int metric, int * matrix,
+						   int row_begin, int row_end, int col_begin, int col_end, adjindex_T<T> & index,
+						   bool validate = true);
+
+template <typename T>
+void _distance_matrix(std::vector< GenomeDescT<T> > & genomes, int metric, int * matrix, bool validate = true);
+
+// The adjacencies of pi as pairs of extremities (see adjmatch.h), the lower one in
+// the high 32 bits, sorted. Reading a chromosome from the other strand or, if it
+// is circular, from another gene gives the same pairs, so genomes that repeat no
+// gene have equal signatures exactly when they are 0 breakpoints apart.
+template <typename T>
+void _adjacency_signature(const GenomeDescT<T> & pi, std::vector<unsigned long long> & signature);
+
+// Returns ERR_DUPLICATES if either genome repeats a gene, ERR_CONTENT if their genes
+// differ and 0 otherwise, in linear time. Pass id = NULL to only check pi for duplicates.
+template <typename T>
+int _validate(const GenomeDescT<T> & pi, const GenomeDescT<T> * id);
+
+template <typename T>
+int _validate_lengths(const GenomeDescT<T> & pi, const GenomeDescT<T> & id);
 
 #endif
@@ -0,0 +1,333 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+#include "distcache.h"
+#include "diststats.h"
+
+#define FNV_OFFSET	14695981039346656037ULL
+#define FNV_PRIME	1099511628211ULL
+
+#define DISTCACHE_MAGIC		"GODCACHE"
+#define DISTCACHE_BITS		10
+
+static inline distkey_t fnv(distkey_t h, unsigned long long word, int bytes){
+	int i;
+	
+	for(i=0;i<bytes;i++){
+		h ^= (word >> (8 * i)) & 0xff;
+		h *= FNV_PRIME;
+	}
+	return h;
+}
+
+template <typename T>
+distkey_t genome_hash(const GenomeDescT<T> & g){
+
+	int c,k;
+	distkey_t h = FNV_OFFSET;
+	
+	h = fnv(h,g.num_chromosomes,4);
+	for(c=0;c<g.num_chromosomes;c++){
+		h = fnv(h,g.circular[c] ? 1 : 0,1);
+		h = fnv(h,g.offsets[c+1] - g.offsets[c],4);
+		for(k=g.offsets[c];k<g.offsets[c+1];k++){
+			h = fnv(h,(unsigned int)g.genes[k],4);
+		}
+	}
+	return h;
+}
+
+template distkey_t genome_hash(const GenomeDesc &);
+template distkey_t genome_hash(const GenomeDesc32 &);
+
+distkey_t distance_key(int metric, distkey_t pi, distkey_t id){
+
+	distkey_t h = FNV_OFFSET;
+	
+	h = fnv(h,metric,4);
+	h = fnv(h,pi,8);
+	h = fnv(h,id,8);
+	
+	return h ? h : 1;
+}
+
+static inline size_t table_bytes(unsigned int bits){
+	return sizeof(distcache_header_t) + ((size_t)1 << bits) * sizeof(distcache_entry_t);
+}
+
+distcache_struct::distcache_struct(){
+	fd = -1;
+	header = NULL;
+	table = NULL;
+	mapped = 0;
+}
+
+distcache_struct::~distcache_struct(){
+	close();
+}
+
+// Write an empty table to a file of no size
+static bool write_empty(int fd){
+
+	distcache_header_t head;
+	
+	memset(&head,0,sizeof(head));
+	memcpy(head.magic,DISTCACHE_MAGIC,8);
+	head.version = DISTCACHE_VERSION;
+	head.bits = DISTCACHE_BITS;
+	head.count = 0;
+	
+	return ftruncate(fd,table_bytes(head.bits)) == 0
+		&& pwrite(fd,&head,sizeof(head),0) == (ssize_t)sizeof(head);
+}
+
+// Open path and take the exclusive lock on the file it names once the lock is
+// granted: another process may have renamed a fresh cache over it meanwhile
+bool distcache_struct::lock_path(const char * path){
+
+	struct stat st, named;
+	
+	for(;;){
+		fd = ::open(path,O_RDWR | O_CREAT,0644);
+		if(fd < 0){
+			return false;
+		}
+		
+		flock(fd,LOCK_EX);
+		if(fstat(fd,&st) == 0 && stat(path,&named) == 0
+		   && st.st_dev == named.st_dev && st.st_ino == named.st_ino){
+			return true;
+		}
+		
+		flock(fd,LOCK_UN);
+		::close(fd);
+		fd = -1;
+	}
+}
+
+bool distcache_struct::open(const char * path){
+
+	struct stat st;
+	
+	close();
+	
+	if(!lock_path(path)){
+		return false;
+	}
+	
+	// A file that is not a cache is left untouched
+	distcache_header_t head;
+	bool empty = fstat(fd,&st) == 0 && st.st_size == 0;
+	bool read = !empty && (size_t)st.st_size >= sizeof(head)
+		&& pread(fd,&head,sizeof(head),0) == (ssize_t)sizeof(head);
+	bool ours = read && memcmp(head.magic,DISTCACHE_MAGIC,8) == 0;
+	
+	if(!ours && !empty){
+		flock(fd,LOCK_UN);
+		close();
+		return false;
+	}
+	
+	// A new file is sized in place, as nobody has mapped it yet. A cache of
+	// another version, or a damaged one, gets a fresh table in a file of its
+	// own renamed over it, so processes that still map it are not cut short.
+	bool ok = true;
+	if(empty){
+		ok = write_empty(fd);
+	}else if(head.version != DISTCACHE_VERSION || (size_t)st.st_size != table_bytes(head.bits)){
+		std::vector<char> fresh(path,path + strlen(path));
+		const char * suffix = ".XXXXXX";
+		fresh.insert(fresh.end(),suffix,suffix + strlen(suffix) + 1);
+		
+		int fresh_fd = mkstemp(fresh.data());
+		ok = fresh_fd >= 0;
+		if(ok){
+			// Locked before it is renamed, so processes opening it wait until it is ready
+			flock(fresh_fd,LOCK_EX);
+			ok = fchmod(fresh_fd,st.st_mode & 0777) == 0 && write_empty(fresh_fd)
+				&& rename(fresh.data(),path) == 0;
+			if(!ok){
+				unlink(fresh.data());
+			}
+			
+			flock(fd,LOCK_UN);
+			::close(fd);
+			fd = fresh_fd;
+		}
+	}
+	
+	ok = ok && map();
+	flock(fd,LOCK_UN);
+	
+	if(!ok){
+		close();
+	}
+	return ok;
+}
+
+void distcache_struct::close(){
+	unmap();
+	if(fd >= 0){
+		::close(fd);
+		fd = -1;
+	}
+}
+
+bool distcache_struct::map(){
+
+	struct stat st;
+	
+	if(fstat(fd,&st) != 0 || (size_t)st.st_size < sizeof(distcache_header_t)){
+		return false;
+	}
+	
+	void * p = mmap(NULL,st.st_size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+	if(p == MAP_FAILED){
+		return false;
+	}
+	
+	mapped = st.st_size;
+	header = (distcache_header_t *)p;
+	table = (distcache_entry_t *)(header + 1);
+	
+	return true;
+}
+
+void distcache_struct::unmap(){
+	if(header){
+		munmap(header,mapped);
+	}
+	header = NULL;
+	table = NULL;
+	mapped = 0;
+}
+
+void distcache_struct::lock(bool exclusive){
+
+	struct stat st;
+	
+	flock(fd,exclusive ? LOCK_EX : LOCK_SH);
+	
+	// Another process may have grown the table since we last looked
+	if(fstat(fd,&st) == 0 && (size_t)st.st_size != mapped){
+		unmap();
+		map();
+	}
+}
+
+void distcache_struct::unlock(){
+	flock(fd,LOCK_UN);
+}
+
+bool distcache_struct::find(distkey_t key, int pi_genes, int id_genes, int * value){
+
+	if(!header){
+		return false;
+	}
+	
+	unsigned int bits = header->bits;
+	size_t mask = ((size_t)1 << bits) - 1;
+	size_t slot = (key * 11400714819323198485ULL) >> (64 - bits);
+	
+	while(table[slot].key){
+		if(table[slot].key == key && table[slot].pi_genes == pi_genes && table[slot].id_genes == id_genes){
+			*value = table[slot].value;
+			STATS_CACHE(true);
+			return true;
+		}
+		slot = (slot + 1) & mask;
+	}
+	
+	STATS_CACHE(false);
+	return false;
+}
+
+void distcache_struct::store(distkey_t key, int pi_genes, int id_genes, int value){
+
+	if(!header){
+		return;
+	}
+	
+	// Keep the load factor at or below one half
+	if((header->count + 1) * 2 > ((unsigned long long)1 << header->bits)){
+		grow();
+		if(!header){
+			return;
+		}
+	}
+	
+	unsigned int bits = header->bits;
+	size_t mask = ((size_t)1 << bits) - 1;
+	size_t slot = (key * 11400714819323198485ULL) >> (64 - bits);
+	
+	while(table[slot].key){
+		if(table[slot].key == key && table[slot].pi_genes == pi_genes && table[slot].id_genes == id_genes){
+			table[slot].value = value;
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+	
+	table[slot].key = key;
+	table[slot].value = value;
+	table[slot].pi_genes = pi_genes;
+	table[slot].id_genes = id_genes;
+	header->count++;
+}
+
+// Double the table and rehash every entry. Called with the exclusive lock held.
+void distcache_struct::grow(){
+
+	size_t i;
+	std::vector<distcache_entry_t> entries;
+	unsigned int bits = header->bits;
+	
+	for(i=0;i<((size_t)1 << bits);i++){
+		if(table[i].key){
+			entries.push_back(table[i]);
+		}
+	}
+	
+	unmap();
+	if(ftruncate(fd,table_bytes(bits + 1)) != 0 || !map()){
+		unmap();
+		return;
+	}
+	
+	header->bits = bits + 1;
+	header->count = 0;
+	memset(table,0,((size_t)1 << header->bits) * sizeof(distcache_entry_t));
+	
+	for(i=0;i<entries.size();i++){
+		store(entries[i].key,entries[i].pi_genes,entries[i].id_genes,entries[i].value);
+	}
+}
+
+bool distcache_struct::get(distkey_t key, int pi_genes, int id_genes, int * value){
+
+	if(!is_open()){
+		return false;
+	}
+	
+	lock(false);
+	bool found = find(key,pi_genes,id_genes,value);
+	unlock();
+	
+	return found;
+}
+
+void distcache_struct::put(distkey_t key, int pi_genes, int id_genes, int value){
+
+	if(!is_open()){
+		return;
+	}
+	
+	lock(true);
+	store(key,pi_genes,id_genes,value);
+	unlock();
+}
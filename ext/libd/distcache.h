@@ -0,0 +1,83 @@
+#ifndef DISTCACHE_H
+#define DISTCACHE_H
+
+#include <stddef.h>
+#include "structs.h"
+
+// Bump whenever a kernel changes the value it returns for some pair of genomes,
+// so stale cache files are discarded instead of answering with the old values
+#define DISTCACHE_VERSION	4
+
+typedef unsigned long long distkey_t;
+
+// A hash of the content of a genome: the circular flag and the signed genes of
+// each chromosome. Equal permutations hash the same in every process, whatever
+// the width of their gene identifiers.
+template <typename T>
+distkey_t genome_hash(const GenomeDescT<T> & g);
+
+// The key of one distance between two genome hashes, in the order pi, id
+distkey_t distance_key(int metric, distkey_t pi, distkey_t id);
+
+// Entries also hold the gene counts of both genomes, so two pairs whose keys
+// collide are told apart instead of one answering with the other's distance
+typedef struct distcache_entry_struct
+{
+	distkey_t key;				/* 0 marks an empty slot */
+	int value;
+	int pi_genes;
+	int id_genes;
+	int unused;
+} distcache_entry_t;
+
+typedef struct distcache_header_struct
+{
+	char magic[8];
+	unsigned int version;
+	unsigned int bits;			/* the table has 1 << bits slots */
+	unsigned long long count;	/* occupied slots */
+} distcache_header_t;
+
+// An open addressing hash table of distances kept in a memory mapped file.
+// Any number of processes may open the same file. Lookups take a shared lock
+// and stores an exclusive one, so concurrent gogo sessions and batch jobs on
+// one dataset share every distance any of them has computed.
+typedef struct distcache_struct
+{
+	int fd;
+	distcache_header_t * header;
+	distcache_entry_t * table;
+	size_t mapped;				/* bytes currently mapped */
+	
+	distcache_struct();
+	~distcache_struct();
+	
+	// Open or create the cache at path. Returns false, leaving the file as it
+	// was, if it holds anything but a cache. A cache of another version, or a
+	// damaged one, is replaced by a fresh file renamed over it, never truncated,
+	// as other processes may still have it mapped.
+	bool open(const char * path);
+	void close();
+	bool is_open() const { return fd >= 0; }
+	
+	// Take or drop the file lock. Batches of find/store calls go between lock and unlock.
+	void lock(bool exclusive);
+	void unlock();
+	
+	// The distance under key between genomes of pi_genes and id_genes genes
+	bool find(distkey_t key, int pi_genes, int id_genes, int * value);
+	void store(distkey_t key, int pi_genes, int id_genes, int value);
+	
+	// Single lookups and stores that do their own locking
+	bool get(distkey_t key, int pi_genes, int id_genes, int * value);
+	void put(distkey_t key, int pi_genes, int id_genes, int value);
+	
+private:
+	bool lock_path(const char * path);
+	bool map();
+	void unmap();
+	void grow();
+	
+} distcache_t;
+
+#endif
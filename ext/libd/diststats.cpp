@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <time.h>
+#include "diststats.h"
+
+const char * diststats_names[STAT_TIMERS] = {
+	"adjacencies", "breakpoints", "inversions", "DCJ", "hurdles", "incremental", "marshal"
+};
+
+#ifdef DIST_NO_STATS
+
+bool diststats_enabled(){
+	return false;
+}
+
+void diststats_read(unsigned long long * values){
+	std::fill(values,values + STAT_VALUES,0ULL);
+}
+
+void diststats_reset(){
+}
+
+#else
+
+// The counters of one thread
+typedef struct diststats_block_struct
+{
+	std::atomic<unsigned long long> value[STAT_VALUES];
+	unsigned int calls[STAT_TIMERS];		/* single calls since the last timed one */
+
+	diststats_block_struct();
+	~diststats_block_struct();
+} diststats_block_t;
+
+// The blocks of the live threads, and the totals of the threads that have exited
+typedef struct diststats_registry_struct
+{
+	std::mutex mutex;
+	std::vector<diststats_block_t *> blocks;
+	unsigned long long retired[STAT_VALUES];
+} diststats_registry_t;
+
+static diststats_registry_t & registry(){
+	static diststats_registry_t r;
+	return r;
+}
+
+static thread_local diststats_block_t block;
+
+diststats_block_struct::diststats_block_struct(){
+	diststats_registry_t & r = registry();
+	int i;
+
+	for(i=0;i<STAT_VALUES;i++){
+		value[i].store(0,std::memory_order_relaxed);
+	}
+	for(i=0;i<STAT_TIMERS;i++){
+		calls[i] = 0;
+	}
+
+	std::lock_guard<std::mutex> lock(r.mutex);
+	r.blocks.push_back(this);
+}
+
+diststats_block_struct::~diststats_block_struct(){
+	diststats_registry_t & r = registry();
+	int i;
+
+	std::lock_guard<std::mutex> lock(r.mutex);
+	for(i=0;i<STAT_VALUES;i++){
+		r.retired[i] += value[i].load(std::memory_order_relaxed);
+	}
+	r.blocks.erase(std::find(r.blocks.begin(),r.blocks.end(),this));
+}
+
+bool diststats_enabled(){
+	return true;
+}
+
+// Only this thread writes its block, so a plain load and store is an atomic add
+static inline void add(std::atomic<unsigned long long> & v, unsigned long long n){
+	v.store(v.load(std::memory_order_relaxed) + n,std::memory_order_relaxed);
+}
+
+void diststats_add(int value, unsigned long long n){
+	add(block.value[value],n);
+}
+
+void diststats_count(int timer, unsigned long long calls, unsigned long long genes,
+	unsigned long long ns, unsigned long long timed){
+	std::atomic<unsigned long long> * v = block.value + timer * STAT_PER_TIMER;
+
+	add(v[STAT_CALLS],calls);
+	add(v[STAT_GENES],genes);
+	if(timed){
+		add(v[STAT_NS],ns);
+		add(v[STAT_TIMED],timed);
+	}
+}
+
+// The first call of each timer is timed, so a single call is never an estimate
+bool diststats_sample(int timer){
+	unsigned int & calls = block.calls[timer];
+
+	if(calls){
+		calls = calls + 1 < STATS_SAMPLE ? calls + 1 : 0;
+		return false;
+	}
+	calls = 1;
+	return true;
+}
+
+unsigned long long diststats_now(){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void diststats_read(unsigned long long * values){
+	diststats_registry_t & r = registry();
+	size_t b;
+	int i;
+
+	{
+		std::lock_guard<std::mutex> lock(r.mutex);
+		for(i=0;i<STAT_VALUES;i++){
+			values[i] = r.retired[i];
+			for(b=0;b<r.blocks.size();b++){
+				values[i] += r.blocks[b]->value[i].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	for(i=0;i<STAT_TIMERS;i++){
+		unsigned long long * v = values + i * STAT_PER_TIMER;
+
+		if(v[STAT_TIMED] && v[STAT_TIMED] < v[STAT_CALLS]){
+			v[STAT_NS] = (unsigned long long)((double)v[STAT_NS] * v[STAT_CALLS] / v[STAT_TIMED]);
+		}
+	}
+}
+
+void diststats_reset(){
+	diststats_registry_t & r = registry();
+	size_t b;
+	int i;
+
+	std::lock_guard<std::mutex> lock(r.mutex);
+	for(i=0;i<STAT_VALUES;i++){
+		r.retired[i] = 0;
+		for(b=0;b<r.blocks.size();b++){
+			r.blocks[b]->value[i].store(0,std::memory_order_relaxed);
+		}
+	}
+}
+
+#endif
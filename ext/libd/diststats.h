@@ -0,0 +1,104 @@
+#ifndef DISTSTATS_H
+#define DISTSTATS_H
+
+// Counters of where the distance library spends its time: for each timer, the
+// calls made, the genes they processed and the nanoseconds they took, and the
+// hits and misses of the cache file.
+//
+// Every thread counts into its own block, written only by that thread with
+// relaxed atomic loads and stores, so counting takes no lock and no locked
+// instruction. Reading sums the blocks of the live threads and what the threads
+// that have exited left behind.
+//
+// A pair of small genomes takes less time than reading the clock twice, so the
+// timer of a single call reads it on one call in STATS_SAMPLE of each thread,
+// and the time of the rest is estimated from those. Matrix rows and other
+// counts of many calls at once are always timed.
+//
+// Building with -DDIST_NO_STATS (perl Makefile.PL DEFINE=-DDIST_NO_STATS)
+// compiles every counter and timer out: the macros below expand to nothing and
+// diststats_read returns zeros.
+
+enum {
+	STAT_ADJACENCIES,			/* shared adjacencies, pair by pair or in a matrix */
+	STAT_BREAKPOINTS,
+	STAT_INVERSIONS,
+	STAT_DCJ,
+	STAT_HURDLES,				/* hurdle and fortress detection within inversions */
+	STAT_INCREMENTAL,			/* building and filtering the incremental matrix */
+	STAT_MARSHAL,				/* turning packed gene orders into genomes for the kernels */
+	STAT_TIMERS
+};
+
+// Each timer counts calls, genes and nanoseconds, then come the cache counters
+enum {
+	STAT_CALLS,
+	STAT_GENES,
+	STAT_NS,					/* of the timed calls, until diststats_read scales it to all */
+	STAT_TIMED,					/* the calls that were timed */
+	STAT_PER_TIMER
+};
+
+#define STATS_SAMPLE		16
+#define STAT_CACHE_HITS		(STAT_TIMERS * STAT_PER_TIMER)
+#define STAT_CACHE_MISSES	(STAT_CACHE_HITS + 1)
+#define STAT_VALUES			(STAT_CACHE_MISSES + 1)
+
+// The names of the timers, as Bio::GeneOrder::Distance->stats reports them
+extern const char * diststats_names[STAT_TIMERS];
+
+// Whether the counters were compiled in
+bool diststats_enabled();
+
+// The totals of every counter over all threads, in STAT_VALUES values, with
+// the nanoseconds of each timer estimated for all of its calls
+void diststats_read(unsigned long long * values);
+
+// Set every counter to 0. Counts made by other threads while this runs may be lost.
+void diststats_reset();
+
+#ifdef DIST_NO_STATS
+
+#define STATS_TIME(timer,genes)
+#define STATS_COUNT(timer,calls,genes,ns)	do{ (void)(calls); (void)(genes); (void)(ns); }while(0)
+#define STATS_CACHE(hit)
+#define STATS_NOW()			0ULL
+
+#else
+
+void diststats_add(int value, unsigned long long n);
+void diststats_count(int timer, unsigned long long calls, unsigned long long genes,
+	unsigned long long ns, unsigned long long timed);
+bool diststats_sample(int timer);
+unsigned long long diststats_now();
+
+// Times the rest of the enclosing block as one call of a timer
+typedef struct diststats_timer_struct
+{
+	int timer;
+	unsigned long long genes;
+	unsigned long long start;
+
+	diststats_timer_struct(int t, unsigned long long g){
+		timer = t;
+		genes = g;
+		start = diststats_sample(t) ? diststats_now() : 0;
+	}
+
+	~diststats_timer_struct(){
+		if(start){
+			diststats_count(timer,1,genes,diststats_now() - start,1);
+		}else{
+			diststats_count(timer,1,genes,0,0);
+		}
+	}
+} diststats_timer_t;
+
+#define STATS_TIME(timer,genes)				diststats_timer_t stats_timer_(timer,genes)
+#define STATS_COUNT(timer,calls,genes,ns)	diststats_count(timer,calls,genes,ns,calls)
+#define STATS_CACHE(hit)					diststats_add((hit) ? STAT_CACHE_HITS : STAT_CACHE_MISSES,1)
+#define STATS_NOW()							diststats_now()
+
+#endif
+
+#endif
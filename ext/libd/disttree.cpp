@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include "disttree.h"
+
+// The distances between the n slots of a tree being built, as a lower triangle.
+// A join leaves the new node in the slot of one of the pair it joined.
+typedef struct triangle_struct
+{
+	std::vector<double> d;
+
+	triangle_struct(int n) : d(n > 1 ? (size_t)n * (n - 1) / 2 : 0) {}
+
+	double & at(int a, int b){
+		if(a < b){
+			std::swap(a,b);
+		}
+		return d[(size_t)a * (a - 1) / 2 + b];
+	}
+} triangle_t;
+
+// A sorted row entry of neighbour joining. The distance is rounded down to a
+// float, so the bound it gives is never above the Q it stands for.
+typedef struct njentry_struct
+{
+	float d;
+	int slot;
+} njentry_t;
+
+static bool entry_less(const njentry_t & x, const njentry_t & y){
+	return x.d < y.d || (x.d == y.d && x.slot < y.slot);
+}
+
+static float rounded_down(double d){
+	float f = (float)d;
+
+	if((double)f > d){
+		f = nextafterf(f,-HUGE_VALF);
+	}
+	return f;
+}
+
+static void start_tree(disttree_t & tree, int n){
+	tree.num_leaves = n;
+	tree.parent.assign(n,-1);
+	tree.length.assign(n,0.0);
+}
+
+static int add_node(disttree_t & tree){
+	tree.parent.push_back(-1);
+	tree.length.push_back(0.0);
+	return tree.parent.size() - 1;
+}
+
+static void attach(disttree_t & tree, int child, int parent, double length){
+	tree.parent[child] = parent;
+	tree.length[child] = length;
+}
+
+// Whether the pair of nodes a,b comes before the pair c,d
+static bool earlier_pair(int a, int b, int c, int d){
+	if(a > b){
+		std::swap(a,b);
+	}
+	if(c > d){
+		std::swap(c,d);
+	}
+	return a < c || (a == c && b < d);
+}
+
+void disttree_nj(const int * matrix, int n, disttree_t & tree){
+	triangle_t d(n);
+	std::vector<double> sum(n,0.0);
+	std::vector<int> node(n), born(n);
+	std::vector<char> alive(n,1);
+	std::vector< std::vector<njentry_t> > rows(n);
+	int a,b,k;
+	int r = n;
+	int joins = 0;
+	int next = n;
+
+	start_tree(tree,n);
+
+	for(a=0;a<n;a++){
+		node[a] = born[a] = a;
+		for(b=0;b<a;b++){
+			double dab = matrix[(size_t)a * n + b];
+
+			d.at(a,b) = dab;
+			sum[a] += dab;
+			sum[b] += dab;
+		}
+	}
+
+	// Each row holds the nodes that were there when the node of its slot was
+	// made, so every pair lies in the row of the later of the two
+	for(a=0;a<n;a++){
+		rows[a].resize(a);
+		for(b=0;b<a;b++){
+			njentry_t entry = { rounded_down(d.at(a,b)), b };
+			rows[a][b] = entry;
+		}
+		std::sort(rows[a].begin(),rows[a].end(),entry_less);
+	}
+
+	while(r > 3){
+		double most = -HUGE_VAL;
+		double best = HUGE_VAL;
+		int i = -1, j = -1;
+
+		for(a=0;a<n;a++){
+			if(alive[a] && sum[a] > most){
+				most = sum[a];
+			}
+		}
+
+		for(a=0;a<n;a++){
+			if(!alive[a]){
+				continue;
+			}
+
+			const std::vector<njentry_t> & row = rows[a];
+			size_t e;
+
+			for(e=0;e<row.size();e++){
+				b = row[e].slot;
+
+				// A slot taken by a node made after this row is not the node the entry was for
+				if(!alive[b] || born[b] > born[a]){
+					continue;
+				}
+				if((r - 2) * (double)row[e].d - sum[a] - most > best){
+					break;
+				}
+
+				double q = (r - 2) * d.at(a,b) - sum[a] - sum[b];
+
+				if(q < best || (q == best && earlier_pair(node[a],node[b],node[i],node[j]))){
+					best = q;
+					i = a;
+					j = b;
+				}
+			}
+		}
+
+		double dij = d.at(i,j);
+		double length = 0.5 * dij + (sum[i] - sum[j]) / (2.0 * (r - 2));
+		int u = add_node(tree);
+
+		attach(tree,node[i],u,length);
+		attach(tree,node[j],u,dij - length);
+
+		// The new node takes the slot of i
+		alive[j] = 0;
+		std::vector<njentry_t>().swap(rows[j]);
+		sum[i] = 0.0;
+		for(k=0;k<n;k++){
+			if(!alive[k] || k == i){
+				continue;
+			}
+
+			double dik = d.at(i,k);
+			double djk = d.at(j,k);
+			double duk = 0.5 * (dik + djk - dij);
+
+			sum[k] += duk - dik - djk;
+			sum[i] += duk;
+			d.at(i,k) = duk;
+		}
+		node[i] = u;
+		born[i] = next++;
+		r--;
+
+		rows[i].clear();
+		for(k=0;k<n;k++){
+			if(alive[k] && k != i){
+				njentry_t entry = { rounded_down(d.at(i,k)), k };
+				rows[i].push_back(entry);
+			}
+		}
+		std::sort(rows[i].begin(),rows[i].end(),entry_less);
+
+		// Drop the entries of joined nodes once there are about as many of them as live ones
+		if(++joins >= r / 2){
+			joins = 0;
+			for(a=0;a<n;a++){
+				if(!alive[a]){
+					continue;
+				}
+
+				std::vector<njentry_t> & row = rows[a];
+				size_t e, kept = 0;
+
+				for(e=0;e<row.size();e++){
+					if(alive[row[e].slot] && born[row[e].slot] < born[a]){
+						row[kept++] = row[e];
+					}
+				}
+				row.resize(kept);
+			}
+		}
+	}
+
+	// The last two or three nodes hang from the root
+	std::vector<int> last;
+	for(a=0;a<n;a++){
+		if(alive[a]){
+			last.push_back(a);
+		}
+	}
+
+	if(r == 3){
+		int root = add_node(tree);
+
+		for(k=0;k<3;k++){
+			a = last[k];
+			b = last[(k + 1) % 3];
+			int c = last[(k + 2) % 3];
+
+			attach(tree,node[a],root,0.5 * (d.at(a,b) + d.at(a,c) - d.at(b,c)));
+		}
+	}else if(r == 2){
+		int root = add_node(tree);
+		double dab = d.at(last[0],last[1]);
+
+		attach(tree,node[last[0]],root,0.5 * dab);
+		attach(tree,node[last[1]],root,0.5 * dab);
+	}
+}
+
+void disttree_upgma(const int * matrix, int n, disttree_t & tree){
+	triangle_t d(n);
+	std::vector<int> node(n), size(n,1);
+	std::vector<double> height(n,0.0);
+	std::vector<char> alive(n,1);
+	std::vector<int> chain;
+	int a,b,k;
+	int r = n;
+
+	start_tree(tree,n);
+
+	for(a=0;a<n;a++){
+		node[a] = a;
+		for(b=0;b<a;b++){
+			d.at(a,b) = matrix[(size_t)a * n + b];
+		}
+	}
+
+	// Follow nearest neighbours from any node until two are each other's nearest.
+	// Average linkage never brings a join nearer to the other nodes than the
+	// nearer of the pair it joined, so the rest of the chain stays a chain.
+	while(r > 1){
+		if(chain.empty()){
+			for(a=0;!alive[a];a++);
+			chain.push_back(a);
+		}
+
+		a = chain.back();
+		int prev = chain.size() > 1 ? chain[chain.size() - 2] : -1;
+		int nearest = prev;
+		double least = prev >= 0 ? d.at(a,prev) : HUGE_VAL;
+
+		// Ties go to the node before a in the chain, and then to the earliest node
+		for(b=0;b<n;b++){
+			if(b == a || !alive[b]){
+				continue;
+			}
+
+			double dab = d.at(a,b);
+
+			if(dab < least || (dab == least && nearest != prev && node[b] < node[nearest])){
+				least = dab;
+				nearest = b;
+			}
+		}
+
+		if(nearest != prev){
+			chain.push_back(nearest);
+			continue;
+		}
+
+		chain.pop_back();
+		chain.pop_back();
+
+		int u = add_node(tree);
+		double h = 0.5 * least;
+		int i = std::min(a,prev);
+		int j = std::max(a,prev);
+
+		attach(tree,node[prev],u,h - height[prev]);
+		attach(tree,node[a],u,h - height[a]);
+
+		for(k=0;k<n;k++){
+			if(alive[k] && k != i && k != j){
+				d.at(i,k) = (size[i] * d.at(i,k) + size[j] * d.at(j,k)) / (size[i] + size[j]);
+			}
+		}
+		size[i] += size[j];
+		height[i] = h;
+		node[i] = u;
+		alive[j] = 0;
+		r--;
+	}
+}
+
+static void newick_name(std::string & out, const std::string & name){
+	size_t c;
+
+	if(!name.empty() && name.find_first_of(" \t\r\n()[]':;,") == std::string::npos){
+		out += name;
+		return;
+	}
+
+	out += '\'';
+	for(c=0;c<name.size();c++){
+		if(name[c] == '\''){
+			out += '\'';
+		}
+		out += name[c];
+	}
+	out += '\'';
+}
+
+std::string disttree_newick(const disttree_t & tree, const std::vector<std::string> & names){
+	int num_nodes = tree.parent.size();
+	std::vector< std::vector<int> > children(num_nodes);
+	std::vector< std::pair<int,size_t> > stack;		/* node, its next child */
+	std::string out;
+	int v;
+
+	for(v=0;v<num_nodes;v++){
+		if(tree.parent[v] < 0){
+			stack.push_back(std::make_pair(v,(size_t)0));
+		}else{
+			children[tree.parent[v]].push_back(v);
+		}
+	}
+
+	while(!stack.empty()){
+		v = stack.back().first;
+		size_t c = stack.back().second;
+
+		if(v < tree.num_leaves){
+			newick_name(out,names[v]);
+		}else if(c < children[v].size()){
+			out += c ? ',' : '(';
+			stack.back().second++;
+			stack.push_back(std::make_pair(children[v][c],(size_t)0));
+			continue;
+		}else{
+			out += ')';
+		}
+
+		if(tree.parent[v] >= 0){
+			char length[32];
+
+			snprintf(length,sizeof(length),":%.10g",tree.length[v] == 0.0 ? 0.0 : tree.length[v]);
+			out += length;
+		}
+		stack.pop_back();
+	}
+
+	out += ';';
+	return out;
+}
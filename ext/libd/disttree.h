@@ -0,0 +1,40 @@
+#ifndef DISTTREE_H
+#define DISTTREE_H
+
+#include <string>
+#include <vector>
+
+// Trees of genomes built from an n*n distance matrix by neighbour joining or by
+// UPGMA. Nodes 0 .. n-1 are the genomes and every join adds one node after them,
+// so the last node is the root. Neighbour joining builds an unrooted tree, so
+// its root is left with the last three nodes below it.
+
+typedef struct disttree_struct
+{
+	int num_leaves;
+	std::vector<int> parent;			/* of each node, -1 for the root */
+	std::vector<double> length;			/* of the branch from each node to its parent */
+} disttree_t;
+
+// Neighbour joining. Each round joins the pair i,j with the least
+// Q = (r - 2) d(i,j) - R(i) - R(j), where r nodes are left and R(i) sums the
+// distances from i. Distances between nodes never change once both exist, so the
+// distances of each node to the nodes before it are sorted once, and a row is
+// scanned only until (r - 2) d(i,j) - R(i) - max R rules out a smaller Q, as in
+// RapidNJ. Ties go to the pair of earliest nodes, so the tree is the one a full
+// scan of Q would build.
+void disttree_nj(const int * matrix, int n, disttree_t & tree);
+
+// UPGMA, joining the pair at the least average distance. The pairs are found by
+// following chains of nearest neighbours, so the tree costs O(n^2) rather than
+// the O(n^3) of searching the matrix before every join. When several pairs tie
+// for the least distance, the chains may join them in another order than a
+// search of the matrix would, and so build another tree, with another root
+// height; each join is still at the least average distance left.
+void disttree_upgma(const int * matrix, int n, disttree_t & tree);
+
+// The tree in Newick format, naming genome i names[i]. Names that Newick would
+// misread are quoted.
+std::string disttree_newick(const disttree_t & tree, const std::vector<std::string> & names);
+
+#endif
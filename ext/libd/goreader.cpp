@@ -0,0 +1,195 @@
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "goreader.h"
+
+#define FNV_OFFSET	2166136261u
+#define FNV_PRIME	16777619u
+
+static inline unsigned int fnv(const char * s, size_t n){
+	size_t i;
+	unsigned int h = FNV_OFFSET;
+
+	for(i=0;i<n;i++){
+		h ^= (unsigned char)s[i];
+		h *= FNV_PRIME;
+	}
+	return h;
+}
+
+// Perl's \s, which separates the genes of a line
+static inline bool blank(char c){
+	return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+goreader_struct::goreader_struct(){
+	fd = -1;
+	data = NULL;
+	size = 0;
+	pos = 0;
+	line = 1;
+	name = NULL;
+	name_length = 0;
+}
+
+goreader_struct::~goreader_struct(){
+	close();
+}
+
+bool goreader_struct::open(const char * path){
+	struct stat st;
+
+	close();
+
+	fd = ::open(path,O_RDONLY);
+	if(fd < 0){
+		return false;
+	}
+	if(fstat(fd,&st) < 0){
+		close();
+		return false;
+	}
+
+	size = st.st_size;
+	if(size > 0){
+		void * map = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+
+		if(map == MAP_FAILED){
+			close();
+			return false;
+		}
+		madvise(map,size,MADV_SEQUENTIAL);
+		data = (const char *)map;
+	}
+	return true;
+}
+
+void goreader_struct::close(){
+	if(data){
+		munmap((void *)data,size);
+	}
+	if(fd >= 0){
+		::close(fd);
+	}
+	fd = -1;
+	data = NULL;
+	size = 0;
+	pos = 0;
+	line = 1;
+	names.clear();
+	slots.clear();
+	genes.clear();
+	offsets.clear();
+	circular.clear();
+	name = NULL;
+	name_length = 0;
+}
+
+void goreader_struct::grow(){
+	size_t k;
+	size_t capacity = slots.empty() ? 1024 : 2 * slots.size();
+
+	slots.assign(capacity,0);
+	for(k=0;k<names.size();k++){
+		size_t slot = fnv(names[k].data(),names[k].size()) & (capacity - 1);
+
+		while(slots[slot]){
+			slot = (slot + 1) & (capacity - 1);
+		}
+		slots[slot] = k + 1;
+	}
+}
+
+int goreader_struct::intern(const char * s, size_t n){
+	// Keep the table at most half full
+	if(2 * (names.size() + 1) > slots.size()){
+		grow();
+	}
+
+	size_t mask = slots.size() - 1;
+	size_t slot = fnv(s,n) & mask;
+
+	while(slots[slot]){
+		const std::string & known = names[slots[slot] - 1];
+
+		if(known.size() == n && !memcmp(known.data(),s,n)){
+			return slots[slot];
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	names.push_back(std::string(s,n));
+	slots[slot] = names.size();
+	return names.size();
+}
+
+int goreader_struct::next(){
+
+	genes.clear();
+	offsets.assign(1,0);
+	circular.clear();
+	name = NULL;
+	name_length = 0;
+
+	while(pos < size){
+		const char * p = data + pos;
+		const char * eol = (const char *)memchr(p,'\n',size - pos);
+		const char * end = eol ? eol : data + size;
+		const char * q;
+
+		if(*p == '>'){
+			// The next record's header ends this one
+			if(name){
+				return 1;
+			}
+			name = p + 1;
+			name_length = end - name;
+			// Lines of files written on Windows end in "\r\n"
+			if(name_length && name[name_length-1] == '\r'){
+				name_length--;
+			}
+		}else{
+			for(q=p;q<end && blank(*q);q++);
+
+			if(q < end && *p != ';'){
+				if(!name){
+					return -1;
+				}
+
+				bool linear = *p == '~';
+				if(linear){
+					for(q=p+1;q<end && blank(*q);q++);
+				}
+
+				while(q < end){
+					const char * token = q;
+					int sign = 1;
+
+					while(q < end && !blank(*q)){
+						q++;
+					}
+					// A sign alone is taken as the name of a gene
+					if((*token == '-' || *token == '+') && q - token > 1){
+						sign = *token == '-' ? -1 : 1;
+						token++;
+					}
+					genes.push_back(sign * intern(token,q - token));
+
+					while(q < end && blank(*q)){
+						q++;
+					}
+				}
+
+				offsets.push_back(genes.size());
+				circular.push_back(linear ? 0 : 1);
+			}
+		}
+
+		pos = eol ? eol - data + 1 : size;
+		line++;
+	}
+
+	return name ? 1 : 0;
+}
@@ -0,0 +1,53 @@
+#ifndef GOREADER_H
+#define GOREADER_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// A gene order file read in place from a memory map, one record at a time.
+// Each record is a '>' line naming the gene order followed by one line per
+// chromosome of blank separated gene names, each optionally signed with '+'
+// or '-'. A chromosome line starting with '~' is linear. Blank lines and
+// lines starting with ';' are skipped.
+//
+// Gene names are interned as they are first seen and numbered from 1, so every
+// record read from one file shares one key, and only the genes of the current
+// record are held besides the names.
+typedef struct goreader_struct
+{
+	int fd;
+	const char * data;
+	size_t size;
+	size_t pos;
+	int line;							/* of the next line to read, from 1 */
+
+	std::vector<std::string> names;		/* of each gene number, from 1 at names[0] */
+	std::vector<int> slots;				/* open addressing table of gene numbers, 0 if empty */
+
+	// The current record
+	const char * name;
+	size_t name_length;
+	std::vector<int> genes;				/* signed gene numbers of every chromosome */
+	std::vector<int> offsets;			/* num_chromosomes + 1 of them */
+	std::vector<unsigned char> circular;
+
+	goreader_struct();
+	~goreader_struct();
+
+	bool open(const char * path);
+	void close();
+
+	// Read the next record. Returns 1 if one was read, 0 at the end of the file
+	// and -1 if chromosome lines come before the first '>' line.
+	int next();
+
+	int num_chromosomes() const { return circular.size(); }
+
+private:
+	int intern(const char * s, size_t n);
+	void grow();
+
+} goreader_t;
+
+#endif
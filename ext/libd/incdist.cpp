@@ -0,0 +1,414 @@
+#include <stdlib.h>
+#include "incdist.h"
+#include "adjmatch.h"
+#include "parallel.h"
+#include "diststats.h"
+
+static inline void join(int * partner, int e, int f){
+	partner[e] = f;
+	partner[f] = e;
+}
+
+static inline extremity_pair_t extremity_pair(int e, int f){
+	extremity_pair_t pair;
+
+	pair.e = e < f ? e : f;
+	pair.f = e < f ? f : e;
+	return pair;
+}
+
+static inline bool holds(const extremity_pair_t * pairs, int num_pairs, const extremity_pair_t & pair){
+	int k;
+
+	for(k=0;k<num_pairs;k++){
+		if(pairs[k].e == pair.e && pairs[k].f == pair.f){
+			return true;
+		}
+	}
+	return false;
+}
+
+incdist_struct::incdist_struct(){
+	clear();
+}
+
+void incdist_struct::clear(){
+	num_genomes = 0;
+	max_gene = 0;
+	extremities = 0;
+	genes.clear();
+	begin.clear();
+	end.clear();
+	circular.clear();
+	occurrence_offsets.clear();
+	occurrences.clear();
+	genome_of.clear();
+	partner.clear();
+	num_bounds.clear();
+	shared.clear();
+	hidden.clear();
+}
+
+// Count the shared adjacencies of every pair of genomes, reading only their
+// visible genes, with the matrix kernel
+template <typename T>
+static void count_shared(incdist_t * inc, int num_threads){
+
+	int i,p;
+	int m = inc->num_genomes;
+	int total = inc->genes.size();
+	int num_chromosomes = 0;
+
+	for(p=0;p<total;p++){
+		num_chromosomes += inc->end[p] == p + 1;
+	}
+
+	std::vector< GenomeDescT<T> > visible(m);
+	std::vector<T> buffer;
+	std::vector<int> offsets;
+	std::vector<unsigned char> flags;
+
+	// Reserved up front so the descriptors can point into them
+	buffer.reserve(total);
+	offsets.reserve(num_chromosomes + m);
+	flags.reserve(num_chromosomes);
+
+	p = 0;
+	for(i=0;i<m;i++){
+		int base = buffer.size();
+		int first_offset = offsets.size();
+		int first_flag = flags.size();
+
+		offsets.push_back(0);
+		for(;p<total && inc->genome_of[p] == i;p++){
+			if(!inc->hidden[abs(inc->genes[p])]){
+				buffer.push_back(inc->genes[p]);
+			}
+			if(inc->end[p] == p + 1){
+				offsets.push_back(buffer.size() - base);
+				flags.push_back(inc->circular[p]);
+			}
+		}
+
+		visible[i].genes = buffer.data() + base;
+		visible[i].offsets = offsets.data() + first_offset;
+		visible[i].circular = flags.data() + first_flag;
+		visible[i].num_chromosomes = offsets.size() - first_offset - 1;
+	}
+
+	std::fill(inc->shared.begin(),inc->shared.end(),DIST_UNKNOWN);
+	_distance_matrix_parallel(visible,DIST_ADJACENCIES,inc->shared.data(),num_threads,false);
+}
+
+bool incdist_struct::build(const std::vector<GenomeDesc32> & genomes, const std::vector<char> & hide, int num_threads){
+
+	int i,c,k,p,g;
+	unsigned long long start = STATS_NOW();
+
+	clear();
+
+	int m = genomes.size();
+	int total = 0;
+
+	for(i=0;i<m;i++){
+		for(k=0;k<genomes[i].num_genes();k++){
+			if(abs(genomes[i].genes[k]) > max_gene){
+				max_gene = abs(genomes[i].genes[k]);
+			}
+		}
+		total += genomes[i].num_genes();
+	}
+
+	num_genomes = m;
+	extremities = 2 * max_gene + 2;
+
+	genes.reserve(total);
+	begin.reserve(total);
+	end.reserve(total);
+	circular.reserve(total);
+	genome_of.reserve(total);
+
+	for(i=0;i<m;i++){
+		const GenomeDesc32 & genome = genomes[i];
+
+		for(c=0;c<genome.num_chromosomes;c++){
+			int first = genes.size();
+			int last = first + genome.offsets[c+1] - genome.offsets[c];
+
+			for(k=genome.offsets[c];k<genome.offsets[c+1];k++){
+				genes.push_back(genome.genes[k]);
+				begin.push_back(first);
+				end.push_back(last);
+				circular.push_back(genome.circular[c]);
+				genome_of.push_back(i);
+			}
+		}
+	}
+
+	// Bucket the positions of each gene. Positions are visited in the order of
+	// their genomes, so a genome repeating a gene puts it twice in a row.
+	occurrence_offsets.assign(max_gene + 2,0);
+	for(p=0;p<total;p++){
+		occurrence_offsets[abs(genes[p]) + 1]++;
+	}
+	for(g=0;g<=max_gene;g++){
+		occurrence_offsets[g+1] += occurrence_offsets[g];
+	}
+
+	std::vector<int> fill(occurrence_offsets.begin(),occurrence_offsets.end() - 1);
+
+	occurrences.resize(total);
+	for(p=0;p<total;p++){
+		g = abs(genes[p]);
+		if(fill[g] > occurrence_offsets[g] && genome_of[occurrences[fill[g] - 1]] == genome_of[p]){
+			clear();
+			return false;
+		}
+		occurrences[fill[g]++] = p;
+	}
+
+	hidden.assign(max_gene + 1,0);
+	for(g=1;g<=max_gene && g<(int)hide.size();g++){
+		hidden[g] = hide[g];
+	}
+
+	// Join each visible gene to the next one of its chromosome
+	partner.assign((size_t)m * extremities,0);
+	num_bounds.assign(m,0);
+
+	for(p=0;p<total;p=end[p]){
+		int * part = partners(genome_of[p]);
+		int first = 0;
+		int last = 0;
+
+		for(k=p;k<end[p];k++){
+			if(hidden[abs(genes[k])]){
+				continue;
+			}
+			if(last){
+				join(part,right_extremity(last),left_extremity(genes[k]));
+				num_bounds[genome_of[p]]++;
+			}else{
+				first = genes[k];
+			}
+			last = genes[k];
+		}
+		if(circular[p] && first){
+			join(part,right_extremity(last),left_extremity(first));
+			num_bounds[genome_of[p]]++;
+		}
+	}
+
+	shared.resize((size_t)m * m);
+	if(max_gene <= gene_traits<intArray>::max_gene){
+		count_shared<intArray>(this,num_threads);
+	}else{
+		count_shared<intArray32>(this,num_threads);
+	}
+
+	STATS_COUNT(STAT_INCREMENTAL,1,total,STATS_NOW() - start);
+	return true;
+}
+
+int incdist_struct::left_neighbour(int p) const {
+	int k;
+
+	for(k=p-1;k>=begin[p];k--){
+		if(!hidden[abs(genes[k])]){
+			return genes[k];
+		}
+	}
+	if(circular[p]){
+		for(k=end[p]-1;k>p;k--){
+			if(!hidden[abs(genes[k])]){
+				return genes[k];
+			}
+		}
+	}
+	return 0;
+}
+
+int incdist_struct::right_neighbour(int p) const {
+	int k;
+
+	for(k=p+1;k<end[p];k++){
+		if(!hidden[abs(genes[k])]){
+			return genes[k];
+		}
+	}
+	if(circular[p]){
+		for(k=begin[p];k<p;k++){
+			if(!hidden[abs(genes[k])]){
+				return genes[k];
+			}
+		}
+	}
+	return 0;
+}
+
+// Every adjacency noted in changed was held by the genome before and not after,
+// or the other way round, so nothing is noted twice
+int incdist_struct::change(int p, bool hide, extremity_pair_t * changed){
+
+	int i = genome_of[p];
+	int * part = partners(i);
+	int left = left_extremity(genes[p]);
+	int right = right_extremity(genes[p]);
+	int n = 0;
+
+	if(hide){
+		int a = part[left];
+		int b = part[right];
+
+		if(a == right){
+			// The gene is alone on a circular chromosome
+			changed[n++] = extremity_pair(left,right);
+			part[left] = part[right] = 0;
+			num_bounds[i]--;
+			return n;
+		}
+		if(a){
+			changed[n++] = extremity_pair(left,a);
+			part[a] = 0;
+			num_bounds[i]--;
+		}
+		if(b){
+			changed[n++] = extremity_pair(right,b);
+			part[b] = 0;
+			num_bounds[i]--;
+		}
+		part[left] = part[right] = 0;
+		if(a && b){
+			join(part,a,b);
+			changed[n++] = extremity_pair(a,b);
+			num_bounds[i]++;
+		}
+	}else{
+		int l = left_neighbour(p);
+		int r = right_neighbour(p);
+
+		if(!l && !r){
+			if(circular[p]){
+				join(part,left,right);
+				changed[n++] = extremity_pair(left,right);
+				num_bounds[i]++;
+			}
+			return n;
+		}
+
+		int a = l ? right_extremity(l) : 0;
+		int b = r ? left_extremity(r) : 0;
+
+		// The neighbours are joined while the gene is hidden
+		if(a && b){
+			part[a] = part[b] = 0;
+			changed[n++] = extremity_pair(a,b);
+			num_bounds[i]--;
+		}
+		if(a){
+			join(part,a,left);
+			changed[n++] = extremity_pair(a,left);
+			num_bounds[i]++;
+		}
+		if(b){
+			join(part,right,b);
+			changed[n++] = extremity_pair(right,b);
+			num_bounds[i]++;
+		}
+	}
+	return n;
+}
+
+// The change in the number of adjacencies shared by genomes i and j, which
+// changed the adjacencies noted in changed_i and changed_j. Both are already
+// updated, so an adjacency a genome changed was held before if it is not now.
+static int shared_change(const int * part_i, const extremity_pair_t * changed_i, int num_i,
+						 const int * part_j, const extremity_pair_t * changed_j, int num_j){
+	int k;
+	int d = 0;
+
+	for(k=0;k<num_i+num_j;k++){
+		const extremity_pair_t & pair = k < num_i ? changed_i[k] : changed_j[k - num_i];
+
+		if(k >= num_i && holds(changed_i,num_i,pair)){
+			continue;
+		}
+
+		bool now_i = part_i[pair.e] == pair.f;
+		bool now_j = part_j[pair.e] == pair.f;
+		bool before_i = now_i != holds(changed_i,num_i,pair);
+		bool before_j = now_j != holds(changed_j,num_j,pair);
+
+		d += (now_i && now_j) - (before_i && before_j);
+	}
+	return d;
+}
+
+bool incdist_struct::filter(int gene, bool hide){
+
+	int x,j;
+
+	if(gene < 1 || gene > max_gene || (bool)hidden[gene] == hide){
+		return false;
+	}
+
+	int first = occurrence_offsets[gene];
+	int k = occurrence_offsets[gene+1] - first;
+	int m = num_genomes;
+
+	std::vector<extremity_pair_t> changed(3 * k);
+	std::vector<int> num_changed(k);
+	std::vector<int> slot(m,-1);
+
+	for(x=0;x<k;x++){
+		int p = occurrences[first + x];
+
+		num_changed[x] = change(p,hide,&changed[3 * x]);
+		slot[genome_of[p]] = x;
+	}
+	hidden[gene] = hide;
+
+	// Pairs of genomes that both hold the gene are visited once, from the first
+	for(x=0;x<k;x++){
+		int i = genome_of[occurrences[first + x]];
+
+		for(j=0;j<m;j++){
+			if(slot[j] >= 0 && slot[j] < x){
+				continue;
+			}
+
+			int y = slot[j];
+			int d = shared_change(partners(i),&changed[3 * x],num_changed[x],
+								  partners(j),y >= 0 ? &changed[3 * y] : NULL,y >= 0 ? num_changed[y] : 0);
+
+			if(d){
+				shared[(size_t)i * m + j] += d;
+				if(i != j){
+					shared[(size_t)j * m + i] += d;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+int incdist_struct::sync(const std::vector<char> & hide){
+	STATS_TIME(STAT_INCREMENTAL,max_gene);
+	int g;
+	int n = 0;
+
+	for(g=1;g<=max_gene;g++){
+		n += filter(g,g < (int)hide.size() && hide[g]);
+	}
+	return n;
+}
+
+int incdist_struct::distance(int metric, int i, int j) const {
+	int s = shared[(size_t)i * num_genomes + j];
+
+	if(metric == DIST_BREAKPOINTS){
+		return (num_bounds[i] > num_bounds[j] ? num_bounds[i] : num_bounds[j]) - s;
+	}
+	return s;
+}
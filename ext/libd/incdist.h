@@ -0,0 +1,78 @@
+#ifndef INCDIST_H
+#define INCDIST_H
+
+#include <vector>
+#include "structs.h"
+
+// An adjacency as the two gene extremities it joins (see adjmatch.h), smaller first
+typedef struct extremity_pair_struct
+{
+	int e;
+	int f;
+} extremity_pair_t;
+
+// Breakpoint and adjacency distances between a fixed list of genomes, kept
+// current while genes are filtered out of every genome and restored again.
+//
+// Each genome keeps the partner of every extremity in its visible genes, so
+// hiding a gene drops the two adjacencies through it and joins its neighbours,
+// and restoring it does the reverse. Only those adjacencies can change whether
+// a pair of genomes shares them, so the shared count of each pair is updated by
+// looking at them alone. Filtering k genes out of m genomes costs O(k m^2)
+// table lookups instead of the O(m^2 n) of computing the matrix again.
+//
+// The genomes must not repeat a gene.
+typedef struct incdist_struct
+{
+	int num_genomes;
+	int max_gene;
+	int extremities;					/* entries of partner per genome, 2 * max_gene + 2 */
+
+	std::vector<int> genes;				/* every genome's genes, filtered or not, back to back */
+	std::vector<int> begin;				/* the first and one past the last gene of the */
+	std::vector<int> end;				/* chromosome holding each gene of genes */
+	std::vector<char> circular;			/* of the chromosome holding each gene of genes */
+
+	std::vector<int> occurrence_offsets;	/* gene g is at occurrences[occurrence_offsets[g] ..] */
+	std::vector<int> occurrences;		/* its positions in genes, one per genome holding it */
+	std::vector<int> genome_of;			/* the genome of each gene of genes */
+
+	std::vector<int> partner;			/* per genome, the partner of each extremity or 0 */
+	std::vector<int> num_bounds;		/* adjacencies of each genome */
+	std::vector<int> shared;			/* num_genomes^2 shared adjacency counts */
+	std::vector<char> hidden;			/* per gene */
+
+	incdist_struct();
+
+	// Index the genomes with every one of their genes, hiding those flagged in
+	// hidden (indexed by gene, and possibly shorter than the largest gene), and
+	// count the shared adjacencies of every pair with num_threads threads.
+	// Returns false, and holds no genomes, if a genome repeats a gene.
+	bool build(const std::vector<GenomeDesc32> & genomes, const std::vector<char> & hidden, int num_threads);
+
+	// Hide or restore one gene in every genome. Returns whether anything changed.
+	bool filter(int gene, bool hide);
+
+	// Hide exactly the genes flagged in hidden, changing only those that differ.
+	// Returns the number of genes changed.
+	int sync(const std::vector<char> & hidden);
+
+	// DIST_ADJACENCIES or DIST_BREAKPOINTS between genomes i and j
+	int distance(int metric, int i, int j) const;
+
+	void clear();
+
+private:
+	int * partners(int i) { return &partner[(size_t)i * extremities]; }
+	const int * partners(int i) const { return &partner[(size_t)i * extremities]; }
+
+	// The visible neighbours of the gene at position p, or 0
+	int left_neighbour(int p) const;
+	int right_neighbour(int p) const;
+
+	// Hide or restore the gene at position p, noting the adjacencies it changed
+	int change(int p, bool hide, extremity_pair_t * changed);
+
+} incdist_t;
+
+#endif
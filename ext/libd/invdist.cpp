@@ -1,9 +1,10 @@
 #include "invdist.h"
+#include "diststats.h"
 
-int
-calculate_offset ( Genome *g1, Genome *g2)
+template < typename T > int
+calculate_offset ( GenomeT < T > *g1, GenomeT < T > *g2 )
 {
-    intArray *genes2 = g2[0].pi;
+    T *genes2 = g2[0].pi;
     int num_genes = g2[0].len;
     int gA = g1[0].pi[0];
 
@@ -41,75 +42,73 @@ num_breakpoints ( int *perm, int size )
     return ( b );
 }
 
-int
-num_cycles ( int *perm, int size, distmem_t * distmem )
+/* The breakpoint graph is held in one block of vertex records (see vertex_T
+   in structs.h). Graphs small enough for 16 bit indices use them, so that
+   the block takes half the cache. */
+static inline bool
+narrow_vertices ( int size, distmem_t * distmem )
 {
-    int *done = distmem->done;
-    int *greyEdges = distmem->greyEdges;
-    int *invperm = distmem->done;
-    int *cycle = distmem->labeled;
+    return ( size < VERTEX16_LIMIT && !distmem->wide );
+}
+
+template < typename I > static int
+num_cycles_T ( int *perm, int size, vertex_T < I > *v )
+{
+    const int NONE = vertex_T < I >::NONE;
     
     int c = 0;
 	int i, ind, j1, j2;
     int next;
     
-#if 0
-    /* This is now implicit */
-    /* set black -edges */
-    for ( i = 0; i < size; i += 2 )
-    {
-        blackEdges[i] = i + 1;
-        blackEdges[i + 1] = i;
-    }
-#endif
-
-    /* set grey -edges */
+    /* set grey -edges, finding each vertex through the position of its value
+       in perm, which is kept in mark until the edges are done */
     for ( i = 0; i < size; i++ )
     {
-        invperm[perm[i]] = i;
-        greyEdges[i] = -1;
+        v[perm[i]].mark = i;
+        v[i].grey = NONE;
     }
 
-    j1 = invperm[1];
+    j1 = v[1].mark;
     if ( j1 != 1 )
-        greyEdges[0] = j1;
+        v[0].grey = j1;
 
     for ( i = 1; i < size - 1; i += 2 )
     {
         ind = perm[i];
         if ( ind < perm[i + 1] )
         {
-            j1 = invperm[ind - 1];
-            j2 = invperm[ind + 2];
+            j1 = v[ind - 1].mark;
+            j2 = v[ind + 2].mark;
         }
         else
         {
-            j1 = invperm[ind + 1];
-            j2 = invperm[ind - 2];
+            j1 = v[ind + 1].mark;
+            j2 = v[ind - 2].mark;
         }
         if ( j1 != i - 1 )
         {
-            greyEdges[i] = j1;
+            v[i].grey = j1;
         }
         if ( j2 != i + 2 )
         {
-            greyEdges[i + 1] = j2;
+            v[i + 1].grey = j2;
         }
     }
 
-    j1 = invperm[size - 2];
+    j1 = v[size - 2].mark;
     if ( j1 != size - 2 )
-        greyEdges[size - 1] = j1;
+        v[size - 1].grey = j1;
 
+    /* mark now records the vertices already put on a cycle */
     for ( i = 0; i < size; i++ )
-        done[i] = 0;
+        v[i].mark = 0;
 
     for ( i = 0; i < size; i++ )
     {
-        if ( done[i] == 0 && greyEdges[i] != -1 )
+        if ( v[i].mark == 0 && v[i].grey != NONE )
         {
-            cycle[i] = i;
-            done[i] = 1;
+            v[i].parent = i;
+            v[i].mark = 1;
             next = i;
             do
             {
@@ -117,11 +116,11 @@ num_cycles ( int *perm, int size, distmem_t * distmem )
                     next++;
                 else
                     next--;
-                done[next] = 1;
-                cycle[next] = i;
-                next = greyEdges[next];
-                done[next] = 1;
-                cycle[next] = i;
+                v[next].mark = 1;
+                v[next].parent = i;
+                next = v[next].grey;
+                v[next].mark = 1;
+                v[next].parent = i;
             }
             while ( next != i );
             c++;
@@ -131,63 +130,66 @@ num_cycles ( int *perm, int size, distmem_t * distmem )
     return ( c );
 }
 
-void
-connected_component ( int size, distmem_t * distmem, int *num_components )
+int
+num_cycles ( int *perm, int size, distmem_t * distmem )
+{
+    if ( narrow_vertices ( size, distmem ) )
+        return ( num_cycles_T ( perm, size, ( vertex16_t * ) distmem->vertices ) );
+    
+    return ( num_cycles_T ( perm, size, ( vertex32_t * ) distmem->vertices ) );
+}
+
+/* The stack of open components is kept in the next and cc fields of the
+   vertices from the start of the block: entry k's root in v[k].next and its
+   range in v[k].cc. Neither field is otherwise used until the stack is done. */
+template < typename I > static void
+connected_component_T ( int size, vertex_T < I > *v, component_t * components,
+                        int *num_components )
 {
+    const int NONE = vertex_T < I >::NONE;
+    
     int i;
     int stack_ptr;
-    int *greyEdges;
-    int *cycle, *range, *cc;
-    component_t *components;
-    int *stack_root, *stack_range;
-    int *parent, *next;
     int right, p;
 
-    greyEdges = distmem->greyEdges;
-
-    next = stack_root = distmem->stack;
-    range = distmem->oriented;
-    stack_range = cc = distmem->cc;
-    parent = cycle = distmem->labeled;
-    components = distmem->components;
     stack_ptr = -1;
     *num_components = 0;
 
     /* Use Linear algorithm to compute connected component */
     for ( i = 0; i < size; i++ )
     {
-        if ( greyEdges[i] == -1 )
+        if ( v[i].grey == NONE )
             continue;
-        range[cycle[i]] = i;
+        v[v[i].parent].range = i;
     }
 
     for ( i = 0; i < size; i++ )
     {
-        if ( greyEdges[i] == -1 )
+        if ( v[i].grey == NONE )
             continue;           /*it is self loop,discard it */
-        if ( parent[i] == i )
+        if ( v[i].parent == i )
         {
             stack_ptr++;
-            stack_root[stack_ptr] = i;
-            stack_range[stack_ptr] = range[i];
+            v[stack_ptr].next = i;
+            v[stack_ptr].cc = v[i].range;
         }
         else
         {                       /*check the top of stack for intersection */
             right = i;
-            while ( stack_root[stack_ptr] > parent[i] )
+            while ( v[stack_ptr].next > v[i].parent )
             {
                 /*union top to the i's connected component */
-                parent[stack_root[stack_ptr]] = parent[i];
-                if ( right < stack_range[stack_ptr] )
-                    right = stack_range[stack_ptr]; /*extend the active range */
+                v[v[stack_ptr].next].parent = v[i].parent;
+                if ( right < v[stack_ptr].cc )
+                    right = v[stack_ptr].cc; /*extend the active range */
                 stack_ptr--;
             }
-            if ( stack_range[stack_ptr] < right )
-                stack_range[stack_ptr] = right;
-            if ( stack_range[stack_ptr] <= i )
+            if ( v[stack_ptr].cc < right )
+                v[stack_ptr].cc = right;
+            if ( v[stack_ptr].cc <= i )
             {
                 /*the top connected-component is INACTIVE */
-                components[*num_components].index = stack_root[stack_ptr];
+                components[*num_components].index = v[stack_ptr].next;
                 ( *num_components )++;
                 stack_ptr--;
             }
@@ -196,16 +198,16 @@ connected_component ( int size, distmem_t * distmem, int *num_components )
     /*turn the forest to set of linked lists whose list head is index of
        component */
     for ( i = 0; i < size; i++ )
-        next[i] = -1;
+        v[i].next = NONE;
     for ( i = 0; i < size; i++ )
     {
-        if ( greyEdges[i] == -1 )
-            cc[i] = -1;
-        else if ( i != parent[i] )
+        if ( v[i].grey == NONE )
+            v[i].cc = NONE;
+        else if ( i != v[i].parent )
         {
             /* insert i between parent(i) and next of parent(i) */
-            next[i] = next[parent[i]];
-            next[parent[i]] = i;
+            v[i].next = v[v[i].parent].next;
+            v[v[i].parent].next = i;
         }
     }
 
@@ -213,10 +215,10 @@ connected_component ( int size, distmem_t * distmem, int *num_components )
     for ( i = 0; i < *num_components; i++ )
     {
         p = components[i].index;
-        while ( p != -1 )
+        while ( p != NONE )
         {
-            cc[p] = i;
-            p = next[p];
+            v[p].cc = i;
+            p = v[p].next;
         }
     }
 
@@ -224,32 +226,36 @@ connected_component ( int size, distmem_t * distmem, int *num_components )
 }
 
 void
-num_hurdles_and_fortress ( int *perm, int size,
-                           int *num_hurdles, int *num_fortress,
-                           distmem_t * distmem )
+connected_component ( int size, distmem_t * distmem, int *num_components )
 {
+    if ( narrow_vertices ( size, distmem ) )
+        connected_component_T ( size, ( vertex16_t * ) distmem->vertices,
+                                distmem->components, num_components );
+    else
+        connected_component_T ( size, ( vertex32_t * ) distmem->vertices,
+                                distmem->components, num_components );
+}
+
+/* Whether a vertex's grey edge is oriented is kept in its range field, which
+   connected_component no longer needs */
+template < typename I > static void
+num_hurdles_and_fortress_T ( int size, int *num_hurdles, int *num_fortress,
+                             vertex_T < I > *v, component_t * components )
+{
+    const int NONE = vertex_T < I >::NONE;
+    
     int cIdx;
     int i, j;
-    int *oriented, *cc, *labeled;
-    component_t *components;
     int num_components;
     int num_oriented;
     int first_comp, last_comp, num_block;
     int num_superhurdles;
-    int *greyEdges;
 
     /* By default, set number of hurdles and fortresses to 0 */
     *num_hurdles = 0;
     *num_fortress = 0;
 
-    greyEdges = distmem->greyEdges;
-
-    oriented = distmem->oriented;
-    cc = distmem->cc;
-    labeled = distmem->labeled;
-    components = distmem->components;
-
-    connected_component ( size, distmem, &num_components );
+    connected_component_T ( size, v, components, &num_components );
 
 
     if ( num_components == 0 )
@@ -265,10 +271,10 @@ num_hurdles_and_fortress ( int *perm, int size,
 
     for ( i = 0; i < size; i++ )
     {
-        j = greyEdges[i];
-        if ( j == -1 )
+        j = v[i].grey;
+        if ( j == NONE )
         {
-            oriented[i] = false;
+            v[i].range = false;
         }
         else
         {
@@ -276,13 +282,13 @@ num_hurdles_and_fortress ( int *perm, int size,
             {
                 if ( ( j - i ) % 2 != 0 )
                 {
-                    oriented[i] = false;
-                    oriented[j] = false;
+                    v[i].range = false;
+                    v[j].range = false;
                 }
                 else
                 {
-                    oriented[i] = true;
-                    oriented[j] = true;
+                    v[i].range = true;
+                    v[j].range = true;
                 }
             }
         }
@@ -305,8 +311,8 @@ num_hurdles_and_fortress ( int *perm, int size,
 
     for ( i = 0; i < size; i++ )
     {
-        if ( oriented[i] == 1 )
-            components[cc[i]].oriented = true;
+        if ( v[i].range == 1 )
+            components[v[i].cc].oriented = true;
     }
 
 
@@ -350,8 +356,8 @@ num_hurdles_and_fortress ( int *perm, int size,
     num_block = -1;
     for ( i = 0; i < size; i++ )
     {
-        cIdx = cc[i];
-        if ( cIdx != -1 )
+        cIdx = v[i].cc;
+        if ( cIdx != NONE )
         {
             if ( components[cIdx].oriented == false )
             {
@@ -431,26 +437,84 @@ num_hurdles_and_fortress ( int *perm, int size,
     return;
 }
 
+
+void
+num_hurdles_and_fortress ( int size, int *num_hurdles, int *num_fortress,
+                           distmem_t * distmem )
+{
+    STATS_TIME ( STAT_HURDLES, size );
+
+    if ( narrow_vertices ( size, distmem ) )
+        num_hurdles_and_fortress_T ( size, num_hurdles, num_fortress,
+                                     ( vertex16_t * ) distmem->vertices,
+                                     distmem->components );
+    else
+        num_hurdles_and_fortress_T ( size, num_hurdles, num_fortress,
+                                     ( vertex32_t * ) distmem->vertices,
+                                     distmem->components );
+}
+
+template < typename I > static int
+breakpoint_components_T ( int size, vertex_T < I > *v, component_t * components,
+                          int *cc, int *hurdles )
+{
+    const int NONE = vertex_T < I >::NONE;
+
+    int i;
+    int num_components = 0;
+
+    for ( i = 0; i < size; i++ )
+    {
+        if ( v[i].grey == NONE || v[i].cc == NONE )
+            cc[i] = -1;
+        else
+        {
+            cc[i] = v[i].cc;
+            if ( cc[i] >= num_components )
+                num_components = cc[i] + 1;
+        }
+    }
+
+    /* hurdle is only set once some component is found unoriented */
+    for ( i = 0; i < num_components; i++ )
+        hurdles[i] = components[i].oriented ? 0 : components[i].hurdle;
+
+    return ( num_components );
+}
+
 int
-invdist_noncircular ( Genome * g1, Genome * g2, int offset )
+breakpoint_components ( int size, int *cc, int *hurdles, distmem_t * distmem )
+{
+    if ( narrow_vertices ( size, distmem ) )
+        return ( breakpoint_components_T ( size, ( vertex16_t * ) distmem->vertices,
+                                           distmem->components, cc, hurdles ) );
+
+    return ( breakpoint_components_T ( size, ( vertex32_t * ) distmem->vertices,
+                                       distmem->components, cc, hurdles ) );
+}
+
+/* Each thread keeps one workspace that is reused by every distance call
+   made on it. It only grows, when a genome larger than any seen so far
+   arrives, so an all-vs-all matrix allocates once instead of once per pair. */
+distmem_t *
+distmem_pool ( int num_genes )
+{
+    static thread_local distmem_t pool;
+
+    pool.reserve ( 2 * num_genes + 2 );
+
+    return ( &pool );
+}
+
+/* Map every extremity of g1 to its position: gene i of g1 shows its left
+   extremity at 2i+1 and its right extremity at 2i+2 */
+template < typename T > static void
+position_map ( GenomeT < T > *g1, int *perm1 )
 {
     int i, twoi;
-    int b, c;
     int g;
-    int num_hurdles;
-    int num_fortress;
-    int reversal_dist;
-    
-    int num_genes = g1[0].len;
-    int n = 2 * num_genes + 2;
-    
-    distmem_t * distmem = new distmem_t(n);
 
-    int *perm1 = distmem->perm1;
-    int *perm2 = distmem->perm2;
-    int *perm = distmem->perm;
-
-    for ( i = 0; i < num_genes; i++ )
+    for ( i = 0; i < g1[0].len; i++ )
     {
         g = 2 * g1[0].pi[i];
         twoi = 2 * i + 1;
@@ -465,6 +529,44 @@ invdist_noncircular ( Genome * g1, Genome * g2, int offset )
             perm1[-g - 1] = twoi + 1;
         }
     }
+}
+
+/* The reversal distance of the framed permutation perm of n extremities */
+int
+reversal_distance ( int *perm, int n, distmem_t * distmem )
+{
+    int b, c;
+    int num_hurdles;
+    int num_fortress;
+
+    b = num_breakpoints ( perm, n );
+    c = num_cycles ( perm, n, distmem );
+    num_hurdles_and_fortress ( n, &num_hurdles, &num_fortress,
+                               distmem );
+
+    return ( b - c + num_hurdles + num_fortress );
+}
+
+template < typename T > int
+invdist_noncircular ( GenomeT < T > *g1, GenomeT < T > *g2, int offset,
+                      distmem_t * distmem )
+{
+    int i, twoi;
+    int g;
+    
+    int num_genes = g1[0].len;
+    int n = 2 * num_genes + 2;
+    
+    if ( distmem == NULL )
+        distmem = distmem_pool ( num_genes );
+    else
+        distmem->reserve ( n );
+
+    int *perm1 = distmem->perm1;
+    int *perm2 = distmem->perm2;
+    int *perm = distmem->perm;
+
+    position_map ( g1, perm1 );
     
     for ( i = 0; i < num_genes; i++ )
     {
@@ -493,23 +595,103 @@ invdist_noncircular ( Genome * g1, Genome * g2, int offset )
     }
     perm[n - 1] = n - 1;
 
-    b = num_breakpoints ( perm, n );
-    c = num_cycles ( perm, n, distmem );
-    num_hurdles_and_fortress ( perm, n, &num_hurdles, &num_fortress,
-                               distmem );
-    reversal_dist = b - c + num_hurdles + num_fortress;
-    delete distmem;
-
-    return ( reversal_dist );
+    return ( reversal_distance ( perm, n, distmem ) );
 }
 
-int
-invdist_circular ( Genome * g1, Genome * g2 )
+/* The inversion distance from g1 to the circular chromosome g2.
+ 
+   g2 is cut at the first gene of g1, so that both start with it and the
+   distance between the two cycles is the distance between the linear orders.
+   Rather than finding that gene first and then reading g2 around from it,
+   g2 is read once in its own rotation, each extremity mapped straight to its
+   position in g1, and the cut falls out of the same pass. The cycle of mapped
+   extremities is then laid out from the cut in two contiguous runs, forwards
+   if g2 holds the gene in the same orientation and backwards otherwise.
+
+   A linear g1 has ends that g2 lacks, and opening g2 to match them costs one
+   more inversion than the distance between the linear orders. */
+template < typename T > int
+invdist_circular ( GenomeT < T > *g1, GenomeT < T > *g2, distmem_t * distmem )
 {
+    int i, j, twoi;
+    int g, gA;
+    int cut;
+    bool reversed;
 
-    int offset;
-	
-    offset = calculate_offset ( g1, g2 );
+    int num_genes = g1[0].len;
+    int n = 2 * num_genes + 2;
+    int m = 2 * num_genes;
+    
+    if ( num_genes == 0 )
+        return ( 0 );
+
+    if ( distmem == NULL )
+        distmem = distmem_pool ( num_genes );
+    else
+        distmem->reserve ( n );
+
+    int *perm1 = distmem->perm1;
+    int *cycle = distmem->perm2;
+    int *perm = distmem->perm;
+
+    position_map ( g1, perm1 );
+    
+    gA = g1[0].pi[0];
+    cut = -1;
+    reversed = false;
+    
+    for ( i = 0; i < num_genes; i++ )
+    {
+        g = g2[0].pi[i];
+        twoi = 2 * i;
+        if ( g > 0 )
+        {
+            cycle[twoi] = perm1[2 * g - 1];
+            cycle[twoi + 1] = perm1[2 * g];
+        }
+        else
+        {
+            cycle[twoi] = perm1[-2 * g];
+            cycle[twoi + 1] = perm1[-2 * g - 1];
+        }
+        if ( g == gA || g == -gA )
+        {
+            cut = twoi;
+            reversed = g != gA;
+        }
+    }
+    
+    if ( cut < 0 )
+        return ( ERR_CONTENT );
+
+    perm[0] = 0;
+    j = 1;
+    if ( !reversed )
+    {
+        for ( i = cut; i < m; i++ )
+            perm[j++] = cycle[i];
+        for ( i = 0; i < cut; i++ )
+            perm[j++] = cycle[i];
+    }
+    else
+    {
+        for ( i = cut + 1; i >= 0; i-- )
+            perm[j++] = cycle[i];
+        for ( i = m - 1; i > cut + 1; i-- )
+            perm[j++] = cycle[i];
+    }
+    perm[n - 1] = n - 1;
+
+    return ( reversal_distance ( perm, n, distmem ) + ( g1[0].circular ? 0 : 1 ) );
+}
 
-    return ( invdist_noncircular ( g1, g2, offset ) );
-}
\ No newline at end of file
+template int calculate_offset ( Genome * g1, Genome * g2 );
+template int calculate_offset ( Genome32 * g1, Genome32 * g2 );
+template int invdist_noncircular ( Genome * g1, Genome * g2, int offset,
+                                   distmem_t * distmem );
+template int invdist_noncircular ( Genome32 * g1, Genome32 * g2, int offset,
+                                   distmem_t * distmem );
+template int invdist_circular ( Genome * g1, Genome * g2,
+                                distmem_t * distmem );
+template int invdist_circular ( Genome32 * g1, Genome32 * g2,
+                                distmem_t * distmem );
@@ -3,17 +3,35 @@
 
 #include "structs.h"
 
-int invdist_noncircular ( Genome * g1, Genome * g2, int offset );
+template < typename T >
+int invdist_noncircular ( GenomeT < T > *g1, GenomeT < T > *g2, int offset,
+                          distmem_t * distmem = NULL );
                           
-int invdist_circular ( Genome * g1, Genome * g2);
+/* g2 must be circular; g1 may be either */
+template < typename T >
+int invdist_circular ( GenomeT < T > *g1, GenomeT < T > *g2,
+                       distmem_t * distmem = NULL );
 
-int calculate_offset ( Genome * g1, Genome * g2);
+distmem_t * distmem_pool ( int num_genes );
+
+template < typename T >
+int calculate_offset ( GenomeT < T > *g1, GenomeT < T > *g2 );
 
 void connected_component ( int size, distmem_t * distmem,
                            int * num_components );
                            
 int num_cycles ( Genome * g1, Genome * g2 );
 
+/* The reversal distance of a framed permutation of extremities: perm[0] is 0,
+   perm[size-1] is size-1 and the two extremities of each gene sit side by side */
+int reversal_distance ( int *perm, int size, distmem_t * distmem );
+
+/* The components of the breakpoint graph that reversal_distance last built in
+   distmem: cc[i] is the component of vertex i, or -1 for a vertex on an
+   adjacency, and hurdles[c] the HURDLE flags of component c, 0 if it is
+   oriented. hurdles needs room for size / 2 components. Returns their number. */
+int breakpoint_components ( int size, int *cc, int *hurdles, distmem_t * distmem );
+
 int num_breakpoints ( Genome * g1, Genome * g2 );
 
 #endif
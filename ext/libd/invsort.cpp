@@ -0,0 +1,420 @@
+#include <algorithm>
+#include "invsort.h"
+#include "invdist.h"
+
+// A signed permutation of 1..n between the frame genes 0 and n+1, which the
+// inversions of the scenario sort into the identity
+typedef struct sorting_struct
+{
+	int n;
+	std::vector<int> p;					/* the gene at each position */
+	std::vector<int> pos;				/* the position of each gene, on either strand */
+	std::vector<int> perm;				/* the extremities of p, laid out as invdist does */
+	std::vector<int> at;				/* the position of each extremity in perm */
+	std::vector<int> cc;				/* the component of each vertex, see breakpoint_components */
+	std::vector<int> hurdles;			/* the hurdle flags of each component */
+	distmem_t * distmem;
+	std::vector<inversion_t> & scenario;
+
+	sorting_struct(int num_genes, std::vector<inversion_t> & s);
+
+	// Invert the genes at positions first..last, counted from 1
+	void invert(int first, int last);
+
+	// Invert them as the next step of the scenario
+	void take(int first, int last);
+
+	// The inversion distance left, leaving its breakpoint graph in distmem
+	int distance();
+
+	// The components of the graph the last distance built. Returns their number.
+	int components();
+
+	// The positions in perm of the two ends of the grey edge of genes k and k+1
+	void ends(int k, int * lo, int * hi) const;
+
+	// The inversion that makes genes k and k+1 adjacent, when they have opposite strands
+	void oriented_inversion(int k, int * first, int * last) const;
+} sorting_t;
+
+sorting_struct::sorting_struct(int num_genes, std::vector<inversion_t> & s) : scenario(s) {
+	n = num_genes;
+	p.resize(n + 2);
+	pos.resize(n + 2);
+	perm.resize(2 * n + 2);
+	at.resize(2 * n + 2);
+	cc.resize(2 * n + 2);
+	hurdles.resize(n + 1);
+	distmem = distmem_pool(n);
+}
+
+void sorting_struct::invert(int first, int last){
+	int x;
+
+	std::reverse(p.begin() + first,p.begin() + last + 1);
+	for(x=first;x<=last;x++){
+		p[x] = -p[x];
+		pos[abs(p[x])] = x;
+	}
+}
+
+void sorting_struct::take(int first, int last){
+	inversion_t inversion = { first - 1, last - 1 };
+
+	invert(first,last);
+	scenario.push_back(inversion);
+}
+
+int sorting_struct::distance(){
+	int x,g;
+	int size = 2 * n + 2;
+
+	perm[0] = 0;
+	for(x=1;x<=n;x++){
+		g = p[x];
+		if(g > 0){
+			perm[2*x-1] = 2 * g - 1;
+			perm[2*x] = 2 * g;
+		}else{
+			perm[2*x-1] = -2 * g;
+			perm[2*x] = -2 * g - 1;
+		}
+	}
+	perm[size-1] = size - 1;
+
+	for(x=0;x<size;x++){
+		at[perm[x]] = x;
+	}
+
+	return reversal_distance(perm.data(),size,distmem);
+}
+
+int sorting_struct::components(){
+	return breakpoint_components(2 * n + 2,cc.data(),hurdles.data(),distmem);
+}
+
+// The right end of gene k is extremity 2k and the left end of gene k+1 is 2k+1.
+// A gene at position x shows its extremities at 2x-1 and 2x of perm.
+void sorting_struct::ends(int k, int * lo, int * hi) const {
+	int x = pos[k];
+	int y = pos[k+1];
+	int a = p[x] >= 0 ? 2 * x : 2 * x - 1;
+	int b = p[y] >= 0 ? 2 * y - 1 : 2 * y;
+
+	*lo = std::min(a,b);
+	*hi = std::max(a,b);
+}
+
+void sorting_struct::oriented_inversion(int k, int * first, int * last) const {
+	int x = pos[k];
+	int y = pos[k+1];
+	int a = p[x] >= 0 ? x : x - 1;		/* the point after k, read on its strand */
+	int b = p[y] >= 0 ? y - 1 : y;		/* the point before k+1 */
+
+	*first = std::min(a,b) + 1;
+	*last = std::max(a,b);
+}
+
+// Try the inversion of positions first..last, keeping it if it is a step of a
+// shortest scenario from a permutation d inversions from the identity
+static bool try_inversion(sorting_t & s, int first, int last, int d){
+	s.invert(first,last);
+	if(s.distance() == d - 1){
+		inversion_t inversion = { first - 1, last - 1 };
+
+		s.scenario.push_back(inversion);
+		return true;
+	}
+	s.invert(first,last);
+	return false;
+}
+
+// Take one inversion that merges two hurdles or cuts one. Returns 0 if there
+// are no hurdles, and -1 if no such inversion shortens the scenario.
+static int clear_hurdle(sorting_t & s, int d){
+	int num_components = s.components();
+	int n = s.n;
+	int x,y,e,c;
+	size_t i,j,a,b;
+	std::vector<int> hurdle_of(num_components,-1);
+	std::vector< std::vector<int> > edges;		/* the breakpoints of each hurdle */
+
+	for(c=0;c<num_components;c++){
+		if(s.hurdles[c] & HURDLE){
+			hurdle_of[c] = edges.size();
+			edges.push_back(std::vector<int>());
+		}
+	}
+	if(edges.empty()){
+		return 0;
+	}
+
+	// Breakpoint x lies between positions x and x+1, that is between vertices
+	// 2x and 2x+1 of the graph. Walk each cycle through its breakpoints.
+	std::vector<int> cycle(n + 1,-1);
+	std::vector<int> breakpoints;
+
+	for(x=0;x<=n;x++){
+		c = s.cc[2*x];
+		if(c < 0){
+			continue;
+		}
+		breakpoints.push_back(x);
+		if(hurdle_of[c] >= 0){
+			edges[hurdle_of[c]].push_back(x);
+		}
+		if(cycle[x] < 0){
+			cycle[x] = x;
+			e = 2 * x + 1;
+			do{
+				int q = s.at[s.perm[e] ^ 1];
+
+				y = q >> 1;
+				cycle[y] = x;
+				e = q ^ 1;
+			}while(y != x);
+		}
+	}
+
+	// Merging two hurdles joins their cycles, and cutting one inverts between
+	// two breakpoints of one of its cycles. Which of them is safe depends on the
+	// hurdles around, so each is tried in turn.
+	std::vector< std::pair<int,int> > candidates;
+
+	for(i=0;i<edges.size();i++){
+		for(j=i+1;j<edges.size();j++){
+			candidates.push_back(std::make_pair(std::min(edges[i][0],edges[j][0]),std::max(edges[i][0],edges[j][0])));
+		}
+	}
+	for(i=0;i<edges.size();i++){
+		bool found = false;
+
+		for(a=0;a<edges[i].size() && !found;a++){
+			for(b=a+1;b<edges[i].size() && !found;b++){
+				if(cycle[edges[i][a]] == cycle[edges[i][b]]){
+					candidates.push_back(std::make_pair(edges[i][a],edges[i][b]));
+					found = true;
+				}
+			}
+		}
+	}
+
+	for(i=0;i<candidates.size();i++){
+		if(try_inversion(s,candidates[i].first + 1,candidates[i].second,d)){
+			return 1;
+		}
+	}
+
+	// Some inversion between two breakpoints always shortens the scenario
+	for(a=0;a<breakpoints.size();a++){
+		for(b=a+1;b<breakpoints.size();b++){
+			if(try_inversion(s,breakpoints[a] + 1,breakpoints[b],d)){
+				return 1;
+			}
+		}
+	}
+
+	return -1;
+}
+
+static inline bool test_bit(const std::vector<unsigned long long> & bits, int u){
+	return bits[u >> 6] >> (u & 63) & 1;
+}
+
+static inline void flip_bit(unsigned long long * bits, int u){
+	bits[u >> 6] ^= 1ULL << (u & 63);
+}
+
+// Sort an oriented component, given the intervals k of its grey edges. Its
+// overlap graph is held as rows of bits. Inverting vertex v complements the
+// graph among the neighbours of v, changes their orientation and leaves v an
+// adjacency, so the graph is never rebuilt. Returns false if the component
+// could not be sorted, which only an unoriented component would cause.
+static bool sort_component(sorting_t & s, const std::vector<int> & intervals){
+	int K = intervals.size();
+	int W = (K + 63) / 64;
+	int u,v,w,i;
+	int first,last;
+	std::vector<unsigned long long> rows((size_t)K * W,0);
+	std::vector<unsigned long long> oriented(W,0), active(W,0), neighbours(W);
+	std::vector<int> lo(K), hi(K);
+
+	for(u=0;u<K;u++){
+		s.ends(intervals[u],&lo[u],&hi[u]);
+		flip_bit(active.data(),u);
+		if((hi[u] - lo[u]) % 2 == 0){
+			flip_bit(oriented.data(),u);
+		}
+	}
+	for(u=0;u<K;u++){
+		for(w=u+1;w<K;w++){
+			if((lo[u] < lo[w] && lo[w] < hi[u] && hi[u] < hi[w]) ||
+			   (lo[w] < lo[u] && lo[u] < hi[w] && hi[w] < hi[u])){
+				flip_bit(&rows[(size_t)u * W],w);
+				flip_bit(&rows[(size_t)w * W],u);
+			}
+		}
+	}
+
+	for(;;){
+		// Bergeron's score of inverting u counts the oriented vertices it leaves:
+		// its unoriented neighbours become oriented and its oriented ones do not
+		int best = -1;
+		int best_score = 0;
+
+		for(u=0;u<K;u++){
+			if(!test_bit(oriented,u) || !test_bit(active,u)){
+				continue;
+			}
+
+			const unsigned long long * row = &rows[(size_t)u * W];
+			int score = 0;
+
+			for(i=0;i<W;i++){
+				score += __builtin_popcountll(row[i] & ~oriented[i]) - __builtin_popcountll(row[i] & oriented[i]);
+			}
+			if(best < 0 || score > best_score){
+				best = u;
+				best_score = score;
+			}
+		}
+		if(best < 0){
+			break;
+		}
+
+		v = best;
+		s.oriented_inversion(intervals[v],&first,&last);
+		s.take(first,last);
+
+		unsigned long long * row_v = &rows[(size_t)v * W];
+
+		std::copy(row_v,row_v + W,neighbours.begin());
+		for(i=0;i<W;i++){
+			unsigned long long word = neighbours[i];
+
+			while(word){
+				u = i * 64 + __builtin_ctzll(word);
+				word &= word - 1;
+
+				unsigned long long * row_u = &rows[(size_t)u * W];
+
+				for(w=0;w<W;w++){
+					row_u[w] ^= neighbours[w];
+				}
+				flip_bit(row_u,u);
+				flip_bit(row_u,v);
+				flip_bit(oriented.data(),u);
+			}
+		}
+		std::fill(row_v,row_v + W,0);
+		flip_bit(active.data(),v);
+	}
+
+	// An inversion may make other pairs adjacent too, and they are left as
+	// isolated unoriented vertices. Any edge left is an unoriented component.
+	for(i=0;i<K*W;i++){
+		if(rows[i]){
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename T>
+int invsort(GenomeT<T> * g1, GenomeT<T> * g2, std::vector<inversion_t> & scenario){
+	int n = g1->len;
+	int k,x,g;
+	int max_gene = 0;
+	int start = 0;
+	bool reflect = false;
+
+	scenario.clear();
+	if(g1->circular != g2->circular){
+		return ERR_CIRCULAR;
+	}
+	if(n != g2->len){
+		return ERR_CONTENT;
+	}
+	if(n == 0){
+		return 0;
+	}
+
+	// Number the genes by their place in g2, so that g2 is the identity. A
+	// circular g2 is read from the first gene of g1, on the strand g1 has it.
+	if(g1->circular){
+		start = -1;
+		for(k=0;k<n;k++){
+			if(abs(g2->pi[k]) == abs(g1->pi[0])){
+				start = k;
+				reflect = g2->pi[k] != g1->pi[0];
+			}
+		}
+		if(start < 0){
+			return ERR_CONTENT;
+		}
+	}
+
+	for(k=0;k<n;k++){
+		max_gene = std::max(max_gene,(int)abs(g2->pi[k]));
+	}
+
+	std::vector<int> label(max_gene + 1,0);
+
+	for(k=0;k<n;k++){
+		g = reflect ? -g2->pi[(start - k + n) % n] : g2->pi[(start + k) % n];
+		label[abs(g)] = g > 0 ? k + 1 : -(k + 1);
+	}
+
+	sorting_t s(n,scenario);
+
+	s.p[0] = s.pos[0] = 0;
+	s.p[n+1] = s.pos[n+1] = n + 1;
+	for(x=1;x<=n;x++){
+		g = g1->pi[x-1];
+		if(abs(g) > max_gene || !label[abs(g)]){
+			return ERR_CONTENT;
+		}
+		s.p[x] = g > 0 ? label[abs(g)] : -label[abs(g)];
+		s.pos[abs(s.p[x])] = x;
+	}
+
+	int distance = s.distance();
+	int d = distance;
+	int cleared = 0;
+
+	while(d > 0 && (cleared = clear_hurdle(s,d)) > 0){
+		d--;
+	}
+	if(d > 0 && cleared < 0){
+		return ERR_NOTIMPL;
+	}
+
+	// Only oriented components are left, and they are sorted one by one
+	if(d > 0){
+		int num_components = s.components();
+		std::vector< std::vector<int> > intervals(num_components);
+		int c;
+
+		for(x=0;x<2*n+2;x++){
+			if(s.cc[x] >= 0 && !(s.perm[x] & 1)){
+				intervals[s.cc[x]].push_back(s.perm[x] >> 1);
+			}
+		}
+		for(c=0;c<num_components;c++){
+			if(!sort_component(s,intervals[c])){
+				return ERR_NOTIMPL;
+			}
+		}
+	}
+
+	for(x=1;x<=n;x++){
+		if(s.p[x] != x){
+			return ERR_NOTIMPL;
+		}
+	}
+
+	return scenario.size() == (size_t)distance ? distance : ERR_NOTIMPL;
+}
+
+template int invsort(Genome *, Genome *, std::vector<inversion_t> &);
+template int invsort(Genome32 *, Genome32 *, std::vector<inversion_t> &);
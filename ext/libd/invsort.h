@@ -0,0 +1,35 @@
+#ifndef INVSORT_H
+#define INVSORT_H
+
+#include <vector>
+#include "structs.h"
+
+// Sorting by reversals: a shortest sequence of inversions between two
+// chromosomes, rather than only its length as invdist gives.
+//
+// The hurdles of the breakpoint graph are cleared first, as Hannenhalli and
+// Pevzner do, by merging two of them or cutting one; every candidate is checked
+// against the distance, so each inversion taken is one of a shortest scenario.
+// What is left has only oriented components, which are sorted by Bergeron's
+// rule: of the oriented inversions of a component, the one that leaves the most
+// oriented inversions never makes an unoriented component. Each component keeps
+// its overlap graph as rows of bits, so applying an inversion to the graph and
+// scoring the next ones takes a pass over words rather than over genes.
+
+// One inversion of a scenario: the genes at positions first..last of the order
+// as it stands, counted from 0, are reversed and change strand
+typedef struct inversion_struct
+{
+	int first;
+	int last;
+} inversion_t;
+
+// The inversions that turn chromosome g1 into g2, fewest possible, in the order
+// they apply. The chromosomes must hold the same genes once each. Both must be
+// linear or both circular; a circular g2 may be read from any gene on either
+// strand. Returns the number of inversions, which is the inversion distance,
+// or ERR_CONTENT or ERR_CIRCULAR.
+template <typename T>
+int invsort(GenomeT<T> * g1, GenomeT<T> * g2, std::vector<inversion_t> & scenario);
+
+#endif
@@ -0,0 +1,586 @@
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <time.h>
+#include "median.h"
+#include "invdist.h"
+
+// The genomes generated between two readings of the clock
+#define MEDIAN_CLOCK_EVERY	1024
+
+static double seconds_now(){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The three chromosomes of an inversion median, as 32 bit genes. A circular
+// chromosome is kept read from the anchor gene on its forward strand, so each
+// circular genome has one form in the set of genomes reached.
+typedef struct inversion_search_struct
+{
+	int n;
+	bool circular;
+	int anchor;
+	std::vector<int> input[3];
+	distmem_t * distmem;
+
+	// The inversion distance from x to input i
+	int distance(std::vector<int> & x, int i);
+
+	// Read a circular x from the anchor, on the anchor's forward strand
+	void canonical(std::vector<int> & x) const;
+} inversion_search_t;
+
+int inversion_search_struct::distance(std::vector<int> & x, int i){
+	Genome32 g1 = { x.data(), circular, n };
+	Genome32 g2 = { input[i].data(), circular, n };
+
+	return circular ? invdist_circular(&g1,&g2,distmem) : invdist_noncircular(&g1,&g2,0,distmem);
+}
+
+void inversion_search_struct::canonical(std::vector<int> & x) const {
+	int k,i;
+
+	if(!circular){
+		return;
+	}
+	for(k=0;abs(x[k]) != anchor;k++);
+	if(x[k] > 0){
+		std::rotate(x.begin(),x.begin() + k,x.end());
+	}else{
+		std::rotate(x.begin(),x.begin() + k + 1,x.end());
+		std::reverse(x.begin(),x.end());
+		for(i=0;i<n;i++){
+			x[i] = -x[i];
+		}
+	}
+}
+
+// The least score of a genome k >= 1 inversions past one r inversions from the
+// root, whose distances to the other two genomes add up to s
+static inline int past_bound(int r, int s, int far){
+	int k = std::max(1,(s - far) / 2);
+
+	return r + std::min(std::max(k + far,s - k),std::max(k + 1 + far,s - k - 1));
+}
+
+template <typename T>
+int inversion_median(GenomeT<T> * const g[3], double seconds, median_t & median){
+	inversion_search_t search;
+	int d[3][3];
+	int i,j,r,first,last;
+	int root,o1,o2,far,best;
+	long generated = 0;
+	bool complete = true;
+	double deadline = seconds > 0 ? seconds_now() + seconds : 0;
+
+	search.n = g[0]->len;
+	search.circular = g[0]->circular;
+	if(g[1]->circular != search.circular || g[2]->circular != search.circular){
+		return ERR_CIRCULAR;
+	}
+	for(i=0;i<3;i++){
+		search.input[i].assign(g[i]->pi,g[i]->pi + search.n);
+	}
+	search.anchor = search.n ? abs(search.input[0][0]) : 0;
+	for(i=0;i<3;i++){
+		search.canonical(search.input[i]);
+	}
+	search.distmem = distmem_pool(search.n);
+
+	for(i=0;i<3;i++){
+		d[i][i] = 0;
+		for(j=i+1;j<3;j++){
+			d[i][j] = d[j][i] = search.distance(search.input[i],j);
+		}
+	}
+	median.lower_bound = (d[0][1] + d[0][2] + d[1][2] + 1) / 2;
+	median.evaluated = 3;
+
+	// The best of the three to start with, and the search rooted at the genome
+	// opposite the farthest pair, which leaves the fewest rounds
+	best = 0;
+	root = 0;
+	for(i=1;i<3;i++){
+		if(d[i][0] + d[i][1] + d[i][2] < d[best][0] + d[best][1] + d[best][2]){
+			best = i;
+		}
+		if(d[(i+1)%3][(i+2)%3] > d[(root+1)%3][(root+2)%3]){
+			root = i;
+		}
+	}
+	o1 = (root + 1) % 3;
+	o2 = (root + 2) % 3;
+	far = d[o1][o2];
+
+	std::vector<int> best_genes = search.input[best];
+	int upper = d[best][0] + d[best][1] + d[best][2];
+
+	// The DCJ median, when it is one chromosome of the same kind, is often an
+	// inversion median too, and a low first bound prunes the most
+	if(upper > median.lower_bound){
+		int offsets[2] = { 0, search.n };
+		unsigned char circular = search.circular;
+		GenomeDesc32 genomes[3];
+		median_t dcj;
+
+		for(i=0;i<3;i++){
+			genomes[i].genes = search.input[i].data();
+			genomes[i].offsets = offsets;
+			genomes[i].circular = &circular;
+			genomes[i].num_chromosomes = 1;
+		}
+		const GenomeDesc32 * const inputs[3] = { &genomes[0], &genomes[1], &genomes[2] };
+
+		dcj_median(inputs,dcj);
+		if(dcj.circular.size() == 1 && dcj.circular[0] == circular){
+			search.canonical(dcj.genes);
+			int score = search.distance(dcj.genes,0) + search.distance(dcj.genes,1) + search.distance(dcj.genes,2);
+
+			median.evaluated++;
+			if(score < upper){
+				upper = score;
+				best_genes = dcj.genes;
+			}
+		}
+	}
+
+	// Then improve the best so far by single inversions while one lowers the score
+	std::vector<int> x(search.n);
+	for(bool improved=true;improved && upper > median.lower_bound;){
+		std::vector<int> from = best_genes;
+
+		improved = false;
+		for(i=search.circular ? 1 : 0;i<search.n;i++){
+			for(last=i;last<search.n;last++){
+				x = from;
+				std::reverse(x.begin() + i,x.begin() + last + 1);
+				for(j=i;j<=last;j++){
+					x[j] = -x[j];
+				}
+				search.canonical(x);
+
+				int score = search.distance(x,0) + search.distance(x,1) + search.distance(x,2);
+
+				median.evaluated++;
+				if(score < upper){
+					upper = score;
+					best_genes = x;
+					improved = true;
+				}
+			}
+		}
+	}
+
+	// Each round holds the genomes r inversions from the root that may lead to
+	// a better median, and the sum of their distances to the other two
+	std::vector<int> layer = search.input[root], next;
+	std::vector<int> sums(1,d[root][o1] + d[root][o2]), next_sums;
+	std::unordered_set<std::string> seen;
+
+	seen.insert(std::string((const char *)layer.data(),search.n * sizeof(int)));
+	first = search.circular ? 1 : 0;
+
+	for(r=0;!sums.empty() && upper > median.lower_bound && r + 1 + far < upper;r++){
+		next.clear();
+		next_sums.clear();
+
+		for(size_t l=0;l<sums.size() && upper > median.lower_bound;l++){
+			if(past_bound(r,sums[l],far) >= upper){
+				continue;
+			}
+			for(i=first;i<search.n;i++){
+				for(last=i;last<search.n;last++){
+					x.assign(layer.begin() + l * search.n,layer.begin() + (l + 1) * search.n);
+					std::reverse(x.begin() + i,x.begin() + last + 1);
+					for(j=i;j<=last;j++){
+						x[j] = -x[j];
+					}
+					search.canonical(x);
+
+					if(deadline && ++generated % MEDIAN_CLOCK_EVERY == 0 && seconds_now() > deadline){
+						complete = false;
+						goto done;
+					}
+					if(!seen.insert(std::string((const char *)x.data(),search.n * sizeof(int))).second){
+						continue;
+					}
+					// Genomes that are not one inversion further were reached,
+					// or ruled out, in an earlier round
+					if(search.distance(x,root) != r + 1){
+						continue;
+					}
+					int d1 = search.distance(x,o1);
+					int least = d1 + abs(far - d1);
+
+					if(r + 1 + least >= upper && past_bound(r + 1,least,far) >= upper){
+						continue;
+					}
+					int d2 = search.distance(x,o2);
+
+					median.evaluated++;
+					if(r + 1 + d1 + d2 < upper){
+						upper = r + 1 + d1 + d2;
+						best_genes = x;
+					}
+					next.insert(next.end(),x.begin(),x.end());
+					next_sums.push_back(d1 + d2);
+				}
+			}
+		}
+		layer.swap(next);
+		sums.swap(next_sums);
+	}
+
+done:
+	median.genes = best_genes;
+	median.offsets.assign(1,0);
+	median.offsets.push_back(search.n);
+	median.circular.assign(1,search.circular);
+	median.score = upper;
+	median.optimal = complete || upper == median.lower_bound;
+
+	return upper;
+}
+
+// A genome as the adjacencies of its gene extremities: gene k has its tail at
+// 2k and its head at 2k+1, and adj[e] is the extremity joined to e, or -1 at a
+// telomere
+typedef std::vector<int> adjacencies_t;
+
+// The adjacencies of g, numbering its genes by their place in values
+template <typename T>
+static void adjacency_form(const GenomeDescT<T> & g, const std::vector<int> & values, adjacencies_t & adj){
+	int c,i,k;
+	int first = -1, left, right = -1;
+
+	adj.assign(2 * values.size(),-1);
+	for(c=0;c<g.num_chromosomes;c++){
+		for(i=g.offsets[c];i<g.offsets[c+1];i++){
+			k = std::lower_bound(values.begin(),values.end(),abs((int)g.genes[i])) - values.begin();
+			left = g.genes[i] > 0 ? 2 * k : 2 * k + 1;
+			if(i == g.offsets[c]){
+				first = left;
+			}else{
+				adj[right] = left;
+				adj[left] = right;
+			}
+			right = left ^ 1;
+		}
+		if(g.circular[c] && g.offsets[c+1] > g.offsets[c]){
+			adj[right] = first;
+			adj[first] = right;
+		}
+	}
+}
+
+// A DCJ median being improved, with the adjacency graphs it makes with the
+// three genomes. In the graph of x and a genome, every extremity has at most
+// one adjacency of each, so the graph is a set of cycles and paths, and
+// d = n - (cycles + even paths / 2), counting paths by their adjacencies.
+typedef struct dcj_search_struct
+{
+	int n;
+	adjacencies_t input[3];
+	adjacencies_t x;
+	std::vector<unsigned int> stamp;		/* the extremities counted by the current count */
+	unsigned int counted;
+	int changed[4];							/* the extremities of the move being scored */
+	int old[4];								/* and their adjacencies before it */
+	int num_changed;
+
+	// Twice the cycles plus the even paths, of the components of the graph of
+	// x and input g through the extremities e that no component counted since
+	// the last new_count already holds
+	int components(int g, int e);
+	void new_count();
+
+	// Twice the distance from x to input g
+	int distance2(int g);
+
+	// Join extremities p and q, joining their partners to each other
+	void join(int p, int q);
+
+	// Make p, and the extremity joined to it, telomeres
+	void cut(int p);
+
+	// Undo the last join or cut
+	void undo();
+
+	// The change in twice the score that the last join or cut made, given the
+	// components counted before it
+	int count_changed(int * before);
+} dcj_search_t;
+
+void dcj_search_struct::new_count(){
+	if(++counted == 0){
+		std::fill(stamp.begin(),stamp.end(),0);
+		counted = 1;
+	}
+}
+
+int dcj_search_struct::components(int g, int e){
+	const adjacencies_t & y = input[g];
+	int v,w,edges = 0;
+	bool of_x;
+
+	if(e < 0 || stamp[e] == counted){
+		return 0;
+	}
+	stamp[e] = counted;
+
+	// Walk from e along its adjacency in x, around a cycle or to one end of a
+	// path, then from e along its adjacency in y to the other end
+	for(v=e,of_x=true;(w = of_x ? x[v] : y[v]) >= 0;v=w,of_x=!of_x){
+		edges++;
+		if(w == e){
+			return 2;
+		}
+		stamp[w] = counted;
+	}
+	for(v=e,of_x=false;(w = of_x ? x[v] : y[v]) >= 0;v=w,of_x=!of_x){
+		edges++;
+		stamp[w] = counted;
+	}
+
+	return edges % 2 == 0 ? 1 : 0;
+}
+
+int dcj_search_struct::distance2(int g){
+	int e,sum = 0;
+
+	new_count();
+	for(e=0;e<2*n;e++){
+		sum += components(g,e);
+	}
+
+	return 2 * n - sum;
+}
+
+void dcj_search_struct::join(int p, int q){
+	int a = x[p], b = x[q];
+	int i;
+
+	num_changed = 0;
+	changed[num_changed++] = p;
+	changed[num_changed++] = q;
+	if(a >= 0){
+		changed[num_changed++] = a;
+	}
+	if(b >= 0){
+		changed[num_changed++] = b;
+	}
+	for(i=0;i<num_changed;i++){
+		old[i] = x[changed[i]];
+	}
+
+	x[p] = q;
+	x[q] = p;
+	if(a >= 0){
+		x[a] = b;
+	}
+	if(b >= 0){
+		x[b] = a;
+	}
+}
+
+void dcj_search_struct::cut(int p){
+	int r = x[p];
+
+	num_changed = 2;
+	changed[0] = p;
+	changed[1] = r;
+	old[0] = r;
+	old[1] = p;
+	x[p] = -1;
+	x[r] = -1;
+}
+
+void dcj_search_struct::undo(){
+	int i;
+
+	for(i=0;i<num_changed;i++){
+		x[changed[i]] = old[i];
+	}
+}
+
+int dcj_search_struct::count_changed(int * before){
+	int g,i,after,delta = 0;
+
+	for(g=0;g<3;g++){
+		new_count();
+		after = 0;
+		for(i=0;i<num_changed;i++){
+			after += components(g,changed[i]);
+		}
+		delta += before[g] - after;
+	}
+
+	return delta;
+}
+
+// Descend from x by the best DCJ toward one of the three genomes until none
+// lowers the score. Returns twice the score reached.
+static int dcj_descend(dcj_search_t & search, long * evaluated){
+	int score2 = search.distance2(0) + search.distance2(1) + search.distance2(2);
+	int before[3];
+	int g,p,q,i,delta,best,best_p,best_q;
+
+	for(;;){
+		best = 0;
+		best_p = best_q = -1;
+
+		for(g=0;g<3;g++){
+			const adjacencies_t & y = search.input[g];
+
+			for(p=0;p<2*search.n;p++){
+				q = y[p];
+				// Each join once, from its lower extremity, and each cut once
+				if(q == search.x[p] || (q >= 0 && q < p) || (q < 0 && search.x[p] < p && y[search.x[p]] < 0)){
+					continue;
+				}
+				// The components through the extremities the move changes, before it
+				if(q >= 0){
+					int at[4] = { p, q, search.x[p], search.x[q] };
+
+					for(i=0;i<3;i++){
+						search.new_count();
+						before[i] = search.components(i,at[0]) + search.components(i,at[1]) +
+							search.components(i,at[2]) + search.components(i,at[3]);
+					}
+					search.join(p,q);
+				}else{
+					int at[2] = { p, search.x[p] };
+
+					for(i=0;i<3;i++){
+						search.new_count();
+						before[i] = search.components(i,at[0]) + search.components(i,at[1]);
+					}
+					search.cut(p);
+				}
+				delta = search.count_changed(before);
+				search.undo();
+				(*evaluated)++;
+
+				if(delta < best){
+					best = delta;
+					best_p = p;
+					best_q = q;
+				}
+			}
+		}
+
+		if(best_p < 0){
+			return score2;
+		}
+		if(best_q >= 0){
+			search.join(best_p,best_q);
+		}else{
+			search.cut(best_p);
+		}
+		score2 += best;
+	}
+}
+
+// The chromosomes of the adjacencies x, linear ones first, naming gene k values[k]
+static void adjacency_genome(const adjacencies_t & x, const std::vector<int> & values, median_t & median){
+	int n = values.size();
+	std::vector<bool> placed(n,false);
+	int e,k,next;
+
+	median.genes.clear();
+	median.offsets.assign(1,0);
+	median.circular.clear();
+
+	// Each linear chromosome from one of its telomeres
+	for(e=0;e<2*n;e++){
+		if(x[e] >= 0 || placed[e >> 1]){
+			continue;
+		}
+		for(next=e;next>=0;next=x[next ^ 1]){
+			placed[next >> 1] = true;
+			median.genes.push_back(next & 1 ? -values[next >> 1] : values[next >> 1]);
+		}
+		median.offsets.push_back(median.genes.size());
+		median.circular.push_back(0);
+	}
+
+	// What is left are circular chromosomes, each read from its first gene
+	for(k=0;k<n;k++){
+		if(placed[k]){
+			continue;
+		}
+		next = 2 * k;
+		do{
+			placed[next >> 1] = true;
+			median.genes.push_back(next & 1 ? -values[next >> 1] : values[next >> 1]);
+			next = x[next ^ 1];
+		}while(next != 2 * k);
+		median.offsets.push_back(median.genes.size());
+		median.circular.push_back(1);
+	}
+}
+
+template <typename T>
+int dcj_median(const GenomeDescT<T> * const g[3], median_t & median){
+	dcj_search_t search;
+	std::vector<int> values;
+	int d2[3][3];
+	int i,j,e,best = 0;
+
+	for(i=0;i<g[0]->num_genes();i++){
+		values.push_back(abs((int)g[0]->genes[i]));
+	}
+	std::sort(values.begin(),values.end());
+	search.n = values.size();
+	for(i=0;i<3;i++){
+		adjacency_form(*g[i],values,search.input[i]);
+	}
+	search.stamp.assign(2 * search.n,0);
+	search.counted = 0;
+
+	for(i=0;i<3;i++){
+		search.x = search.input[i];
+		for(j=0;j<3;j++){
+			d2[i][j] = i == j ? 0 : search.distance2(j);
+		}
+		if(d2[i][0] + d2[i][1] + d2[i][2] < d2[best][0] + d2[best][1] + d2[best][2]){
+			best = i;
+		}
+	}
+	median.lower_bound = (d2[0][1] + d2[0][2] + d2[1][2] + 3) / 4;
+	median.evaluated = 0;
+
+	// The adjacencies that two of the three share never conflict, since an
+	// extremity can only have one partner in two genomes at once
+	adjacencies_t shared(2 * search.n);
+	for(e=0;e<2*search.n;e++){
+		const adjacencies_t * in = search.input;
+
+		shared[e] = in[0][e] == in[1][e] || in[0][e] == in[2][e] ? in[0][e] : in[1][e] == in[2][e] ? in[1][e] : -1;
+	}
+
+	search.x = shared;
+	int score2 = dcj_descend(search,&median.evaluated);
+	adjacencies_t found = search.x;
+
+	search.x = search.input[best];
+	int from_best = dcj_descend(search,&median.evaluated);
+	if(from_best < score2){
+		score2 = from_best;
+		found = search.x;
+	}
+
+	adjacency_genome(found,values,median);
+	median.score = score2 / 2;
+	median.optimal = median.score == median.lower_bound;
+
+	return median.score;
+}
+
+template int inversion_median(Genome * const [3], double, median_t &);
+template int inversion_median(Genome32 * const [3], double, median_t &);
+template int dcj_median(const GenomeDesc * const [3], median_t &);
+template int dcj_median(const GenomeDesc32 * const [3], median_t &);
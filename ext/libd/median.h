@@ -0,0 +1,52 @@
+#ifndef MEDIAN_H
+#define MEDIAN_H
+
+#include <vector>
+#include "structs.h"
+
+// Medians of three genomes: a genome whose distances to the three add up to
+// the least. No median scores below half the sum of the distances between the
+// three, which is the lower bound reported with every result.
+//
+// The inversion median is exact, by the search of Siepel and Moret. It starts
+// from the best of the three genomes and the DCJ median, improved by single
+// inversions while one lowers the score, which often meets the lower bound and
+// ends the search before it begins. Otherwise genomes are visited in order of
+// their distance from one of the three, one inversion further each round, and a
+// genome x r inversions away with s = d(x,B) + d(x,C) is expanded only if a
+// genome past it could still beat the best so far: one k inversions further
+// scores at least r + max(k + d(B,C), s - k). The inversion distance is the
+// oracle for every bound, and each genome reached is scored once, however many
+// genomes of the round before lead to it. A time limit stops the search with
+// the best median found so far.
+//
+// The DCJ median is a heuristic. It starts from the best of the three genomes
+// and the genome of the adjacencies that two of them share, and repeatedly takes
+// the DCJ that most lowers the score, among those that bring it one step closer
+// to one of the three. The score of a move is counted only over the cycles and
+// paths of the adjacency graphs that the move touches.
+
+typedef struct median_struct
+{
+	std::vector<int> genes;					/* of every chromosome back to back */
+	std::vector<int> offsets;				/* num_chromosomes + 1 entries, offsets[0] is 0 */
+	std::vector<unsigned char> circular;	/* one flag per chromosome */
+	int score;								/* the sum of the distances to the three genomes */
+	int lower_bound;
+	bool optimal;							/* the score is proven to be the least */
+	long evaluated;							/* the genomes scored on the way */
+} median_t;
+
+// The inversion median of three chromosomes of the same genes, all linear or all
+// circular, searching for at most the given seconds (0 for no limit). The median
+// is optimal unless the time ran out first. Returns its score, or ERR_CIRCULAR.
+template <typename T>
+int inversion_median(GenomeT<T> * const g[3], double seconds, median_t & median);
+
+// A DCJ median of three genomes of the same genes, of any number of linear and
+// circular chromosomes, which is optimal only when its score meets the lower
+// bound. Returns its score.
+template <typename T>
+int dcj_median(const GenomeDescT<T> * const g[3], median_t & median);
+
+#endif
@@ -0,0 +1,34 @@
+#include <algorithm>
+#include <string.h>
+#include "nbrindex.h"
+
+void nbrindex_sort(const int * matrix, int n, int * sorted){
+	int i;
+
+	memcpy(sorted,matrix,(size_t)n * n * sizeof(int));
+	for(i=0;i<n;i++){
+		std::sort(sorted + (size_t)i * n,sorted + (size_t)(i + 1) * n);
+	}
+}
+
+int nbrindex_count(const int * matrix, const int * sorted, int n, int i, int d, bool above,
+				   const int * excluded, int num_excluded){
+	const int * row = sorted + (size_t)i * n;
+	const int * distances = matrix + (size_t)i * n;
+	int k,count;
+
+	if(above){
+		count = row + n - std::upper_bound(row,row + n,d);
+	}else{
+		count = std::lower_bound(row,row + n,d) - row;
+	}
+
+	for(k=0;k<num_excluded;k++){
+		int j = excluded[k];
+
+		if(j >= 0 && j < n && (above ? distances[j] > d : distances[j] < d)){
+			count--;
+		}
+	}
+	return count;
+}
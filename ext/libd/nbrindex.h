@@ -0,0 +1,17 @@
+#ifndef NBRINDEX_H
+#define NBRINDEX_H
+
+// The neighbours of genomes by one distance, indexed from an n*n distance matrix.
+// Each row of the matrix is sorted once, so the genomes closer to or further from
+// genome i than a threshold are counted by binary search rather than by a pass
+// over the row, for any threshold.
+
+// Sort each row of matrix into sorted, which holds n*n distances
+void nbrindex_sort(const int * matrix, int n, int * sorted);
+
+// The number of genomes j with matrix[i*n+j] < d, or > d if above, leaving out
+// the num_excluded genomes listed in excluded
+int nbrindex_count(const int * matrix, const int * sorted, int n, int i, int d, bool above,
+				   const int * excluded, int num_excluded);
+
+#endif
@@ -0,0 +1,156 @@
+#include <thread>
+#include <mutex>
+#include <deque>
+#include "parallel.h"
+#include "invdist.h"
+
+#define TILE_SIZE	16
+
+// A block of the upper triangle of the distance matrix
+typedef struct tile_struct
+{
+	int row_begin;
+	int row_end;
+	int col_begin;
+	int col_end;
+	double cost;				/* estimated work, used to order the tiles */
+} tile_t;
+
+// Every worker owns a deque of tiles. It takes its own tiles from the front,
+// where the most expensive ones are, and when it runs out it steals the
+// cheapest tile from the back of another worker's deque.
+typedef struct worker_struct
+{
+	std::mutex lock;
+	std::deque<tile_t> tiles;
+} worker_t;
+
+static bool next_tile(worker_t * workers, int num_workers, int self, tile_t * tile){
+
+	int k;
+	
+	{
+		std::lock_guard<std::mutex> guard(workers[self].lock);
+		if(!workers[self].tiles.empty()){
+			*tile = workers[self].tiles.front();
+			workers[self].tiles.pop_front();
+			return true;
+		}
+	}
+	
+	for(k=1;k<num_workers;k++){
+		worker_t * victim = &workers[(self + k) % num_workers];
+		
+		std::lock_guard<std::mutex> guard(victim->lock);
+		if(!victim->tiles.empty()){
+			*tile = victim->tiles.back();
+			victim->tiles.pop_back();
+			return true;
+		}
+	}
+	
+	// No tiles are added once the workers start, so empty deques mean we are done
+	return false;
+}
+
+template <typename T>
+static void matrix_worker(std::vector< GenomeDescT<T> > * genomes, int metric, int * matrix,
+						  worker_t * workers, int num_workers, int self, int max_genes, bool validate){
+
+	adjindex_T<T> index;
+	tile_t tile;
+	
+	// Size this thread's workspace for the largest genome up front
+	if(metric == DIST_INVERSIONS){
+		distmem_pool(max_genes);
+	}
+	
+	while(next_tile(workers,num_workers,self,&tile)){
+		_distance_matrix_tile(*genomes,metric,matrix,
+							  tile.row_begin,tile.row_end,tile.col_begin,tile.col_end,index,validate);
+	}
+}
+
+static bool heavier(const tile_t & a, const tile_t & b){
+	return a.cost > b.cost;
+}
+
+template <typename T>
+void _distance_matrix_parallel(std::vector< GenomeDescT<T> > & genomes, int metric, int * matrix,
+							   int num_threads, bool validate){
+
+	int n = genomes.size();
+	int i,j,bi,bj;
+	int max_genes = 0;
+	
+	if(num_threads <= 0){
+		num_threads = std::thread::hardware_concurrency();
+	}
+	
+	if(num_threads <= 1 || n <= TILE_SIZE){
+		_distance_matrix(genomes,metric,matrix,validate);
+		return;
+	}
+	
+	std::vector<int> len(n);
+	for(i=0;i<n;i++){
+		len[i] = genomes[i].num_genes();
+		if(len[i] > max_genes){
+			max_genes = len[i];
+		}
+	}
+	
+	// Split the upper triangle into tiles and estimate the work in each from
+	// the genome lengths, since pairs of long genomes cost far more than short ones.
+	// Each unknown cell counts at least 1, so genomes without genes are compared too.
+	std::vector<tile_t> tiles;
+	for(bi=0;bi<n;bi+=TILE_SIZE){
+		for(bj=bi;bj<n;bj+=TILE_SIZE){
+			tile_t tile;
+			tile.row_begin = bi;
+			tile.row_end = bi + TILE_SIZE < n ? bi + TILE_SIZE : n;
+			tile.col_begin = bj;
+			tile.col_end = bj + TILE_SIZE < n ? bj + TILE_SIZE : n;
+			tile.cost = 0;
+			
+			for(i=tile.row_begin;i<tile.row_end;i++){
+				for(j=(i > bj ? i : bj);j<tile.col_end;j++){
+					if(matrix[(size_t)i * n + j] == DIST_UNKNOWN){
+						tile.cost += len[i] + len[j] + 1;
+					}
+				}
+			}
+			
+			// Skip tiles whose every cell is already known
+			if(tile.cost > 0){
+				tiles.push_back(tile);
+			}
+		}
+	}
+	
+	// Deal the tiles out heaviest first so every deque runs from heavy to light
+	std::sort(tiles.begin(),tiles.end(),heavier);
+	
+	worker_t * workers = new worker_t[num_threads];
+	for(i=0;i<(int)tiles.size();i++){
+		workers[i % num_threads].tiles.push_back(tiles[i]);
+	}
+	
+	// Each cell is written by exactly one tile using the same code as the serial
+	// path, so the result does not depend on the number of threads
+	std::vector<std::thread> threads;
+	for(i=1;i<num_threads;i++){
+		threads.push_back(std::thread(matrix_worker<T>,&genomes,metric,matrix,workers,num_threads,i,max_genes,validate));
+	}
+	
+	matrix_worker(&genomes,metric,matrix,workers,num_threads,0,max_genes,validate);
+	
+	for(i=0;i<(int)threads.size();i++){
+		threads[i].join();
+	}
+	
+	delete[] workers;
+}
+
+template void _distance_matrix_parallel(std::vector<GenomeDesc> &, int, int *, int, bool);
+template void _distance_matrix_parallel(std::vector<GenomeDesc32> &, int, int *, int, bool);
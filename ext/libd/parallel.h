@@ -0,0 +1,10 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "distances.h"
+
+template <typename T>
+void _distance_matrix_parallel(std::vector< GenomeDescT<T> > & genomes, int metric, int * matrix,
+							   int num_threads, bool validate = true);
+
+#endif
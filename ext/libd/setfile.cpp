@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "setfile.h"
+
+static inline unsigned long long aligned(unsigned long long n){
+	return (n + 7) & ~7ULL;
+}
+
+// A string table as written, see setfile.h
+static void strings(const std::vector<std::string> & s, std::string & out){
+	size_t i;
+	unsigned int offset = 0;
+
+	out.clear();
+	for(i=0;i<=s.size();i++){
+		out.append((const char *)&offset,sizeof(offset));
+		if(i < s.size()){
+			offset += s[i].size();
+		}
+	}
+	for(i=0;i<s.size();i++){
+		out.append(s[i]);
+	}
+}
+
+template <typename T>
+static void column(const std::vector<T> & v, std::string & out){
+	out.assign((const char *)(v.empty() ? NULL : &v[0]),v.size() * sizeof(T));
+}
+
+bool setfile_write(const char * path, setfile_columns_t & columns){
+	setfile_header_t header;
+	std::string sections[SETFILE_SECTIONS];
+	std::vector<unsigned int> seen(columns.names.size() + 1,0);
+	unsigned long long offset;
+	size_t i;
+	int s;
+
+	// Note which gene orders repeat no gene, so reading a set need not check
+	for(i=0;i+1<columns.order_chromosomes.size();i++){
+		unsigned int first = columns.chromosome_genes[columns.order_chromosomes[i]];
+		unsigned int last = columns.chromosome_genes[columns.order_chromosomes[i + 1]];
+		unsigned int k;
+		bool valid = true;
+
+		for(k=first;k<last;k++){
+			int g = columns.genes[k] < 0 ? -columns.genes[k] : columns.genes[k];
+
+			if(g == 0 || (size_t)g >= seen.size() || seen[g] == i + 1){
+				valid = false;
+				break;
+			}
+			seen[g] = i + 1;
+		}
+		columns.order_flags[i] = (columns.order_flags[i] & ~SETFILE_VALID) | (valid ? SETFILE_VALID : 0);
+	}
+
+	strings(columns.names,sections[SETFILE_NAMES]);
+	strings(columns.types,sections[SETFILE_TYPES]);
+	column(columns.gene_filtered,sections[SETFILE_GENE_FILTERED]);
+	strings(columns.order_names,sections[SETFILE_ORDER_NAMES]);
+	strings(columns.order_sources,sections[SETFILE_ORDER_SOURCES]);
+	strings(columns.order_classifications,sections[SETFILE_ORDER_CLASSIFICATIONS]);
+	column(columns.order_flags,sections[SETFILE_ORDER_FLAGS]);
+	column(columns.order_chromosomes,sections[SETFILE_ORDER_CHROMOSOMES]);
+	strings(columns.chromosome_sources,sections[SETFILE_CHROMOSOME_SOURCES]);
+	column(columns.chromosome_genes,sections[SETFILE_CHROMOSOME_GENES]);
+	column(columns.chromosome_circular,sections[SETFILE_CHROMOSOME_CIRCULAR]);
+	column(columns.genes,sections[SETFILE_GENES]);
+
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,SETFILE_MAGIC,sizeof(header.magic));
+	header.version = SETFILE_VERSION;
+	header.num_names = columns.names.size();
+	header.num_orders = columns.order_names.size();
+	header.num_chromosomes = columns.chromosome_sources.size();
+	header.num_genes = columns.genes.size();
+
+	offset = aligned(sizeof(header));
+	for(s=0;s<SETFILE_SECTIONS;s++){
+		header.offset[s] = offset;
+		header.length[s] = sections[s].size();
+		offset = aligned(offset + sections[s].size());
+	}
+
+	std::string temporary = std::string(path) + ".tmp";
+	FILE * f = fopen(temporary.c_str(),"wb");
+	static const char padding[8] = {0};
+	bool written;
+
+	if(!f){
+		return false;
+	}
+
+	written = fwrite(&header,sizeof(header),1,f) == 1;
+	offset = sizeof(header);
+	for(s=0;s<SETFILE_SECTIONS && written;s++){
+		written = fwrite(padding,1,header.offset[s] - offset,f) == header.offset[s] - offset &&
+			fwrite(sections[s].data(),1,sections[s].size(),f) == sections[s].size();
+		offset = header.offset[s] + sections[s].size();
+	}
+
+	written = fclose(f) == 0 && written;
+	if(!written || rename(temporary.c_str(),path) != 0){
+		unlink(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+setfile_struct::setfile_struct(){
+	fd = -1;
+	data = NULL;
+	size = 0;
+	header = NULL;
+}
+
+setfile_struct::~setfile_struct(){
+	close();
+}
+
+int setfile_struct::open(const char * path){
+	struct stat st;
+
+	close();
+
+	fd = ::open(path,O_RDONLY);
+	if(fd < 0 || fstat(fd,&st) < 0 || (size_t)st.st_size < sizeof(setfile_header_t)){
+		close();
+		return 0;
+	}
+
+	size = st.st_size;
+	void * map = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+
+	if(map == MAP_FAILED){
+		size = 0;
+		close();
+		return 0;
+	}
+	data = (const char *)map;
+	header = (const setfile_header_t *)data;
+
+	if(memcmp(header->magic,SETFILE_MAGIC,sizeof(header->magic))){
+		close();
+		return 0;
+	}
+	if(header->version != SETFILE_VERSION || !check()){
+		close();
+		return -1;
+	}
+	return 1;
+}
+
+void setfile_struct::close(){
+	if(data){
+		munmap((void *)data,size);
+	}
+	if(fd >= 0){
+		::close(fd);
+	}
+	fd = -1;
+	data = NULL;
+	size = 0;
+	header = NULL;
+}
+
+unsigned int setfile_struct::num_strings(int s) const {
+	switch(s){
+		case SETFILE_NAMES:
+		case SETFILE_TYPES:
+			return header->num_names;
+		case SETFILE_CHROMOSOME_SOURCES:
+			return header->num_chromosomes;
+		default:
+			return header->num_orders;
+	}
+}
+
+const char * setfile_struct::string(int s, unsigned int i, size_t * length) const {
+	const unsigned int * offsets = (const unsigned int *)section(s);
+
+	*length = offsets[i + 1] - offsets[i];
+	return (const char *)(offsets + num_strings(s) + 1) + offsets[i];
+}
+
+// Every section lies within the file, every table and offset within its section,
+// and every gene within the name table
+bool setfile_struct::check() const {
+	int s;
+
+	for(s=0;s<SETFILE_SECTIONS;s++){
+		if(header->offset[s] % 8 || header->offset[s] > size || header->length[s] > size - header->offset[s]){
+			return false;
+		}
+	}
+
+	return check_strings(SETFILE_NAMES,header->num_names) &&
+		check_strings(SETFILE_TYPES,header->num_names) &&
+		header->length[SETFILE_GENE_FILTERED] == header->num_names &&
+		check_strings(SETFILE_ORDER_NAMES,header->num_orders) &&
+		check_strings(SETFILE_ORDER_SOURCES,header->num_orders) &&
+		check_strings(SETFILE_ORDER_CLASSIFICATIONS,header->num_orders) &&
+		header->length[SETFILE_ORDER_FLAGS] == header->num_orders &&
+		check_offsets(SETFILE_ORDER_CHROMOSOMES,header->num_orders,header->num_chromosomes) &&
+		check_strings(SETFILE_CHROMOSOME_SOURCES,header->num_chromosomes) &&
+		check_offsets(SETFILE_CHROMOSOME_GENES,header->num_chromosomes,header->num_genes) &&
+		header->length[SETFILE_CHROMOSOME_CIRCULAR] == header->num_chromosomes &&
+		header->length[SETFILE_GENES] == header->num_genes * sizeof(int) &&
+		check_genes();
+}
+
+// Every gene numbers a name, and every gene order flagged SETFILE_VALID repeats
+// no gene, as readers take the flag rather than check the gene order again
+bool setfile_struct::check_genes() const {
+	const unsigned char * flags = (const unsigned char *)section(SETFILE_ORDER_FLAGS);
+	const unsigned int * chromosomes = (const unsigned int *)section(SETFILE_ORDER_CHROMOSOMES);
+	const unsigned int * offsets = (const unsigned int *)section(SETFILE_CHROMOSOME_GENES);
+	const int * genes = (const int *)section(SETFILE_GENES);
+	std::vector<unsigned int> seen(header->num_names + 1,0);
+	unsigned int i;
+	unsigned int k;
+
+	for(i=0;i<header->num_orders;i++){
+		bool valid = flags[i] & SETFILE_VALID;
+
+		for(k=offsets[chromosomes[i]];k<offsets[chromosomes[i + 1]];k++){
+			unsigned int g = genes[k] < 0 ? 0u - (unsigned int)genes[k] : (unsigned int)genes[k];
+
+			if(g == 0 || g > header->num_names || (valid && seen[g] == i + 1)){
+				return false;
+			}
+			seen[g] = i + 1;
+		}
+	}
+	return true;
+}
+
+bool setfile_struct::check_strings(int s, unsigned long long count) const {
+	unsigned long long table = (count + 1) * sizeof(unsigned int);
+
+	if(header->length[s] < table){
+		return false;
+	}
+	return check_offsets(s,count,header->length[s] - table);
+}
+
+// count + 1 offsets rising from 0 to total
+bool setfile_struct::check_offsets(int s, unsigned long long count, unsigned long long total) const {
+	const unsigned int * offsets = (const unsigned int *)section(s);
+	unsigned long long i;
+
+	if(header->length[s] < (count + 1) * sizeof(unsigned int) || offsets[0] != 0 || offsets[count] != total){
+		return false;
+	}
+	for(i=0;i<count;i++){
+		if(offsets[i] > offsets[i + 1]){
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,106 @@
+#ifndef SETFILE_H
+#define SETFILE_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// A set of gene orders saved in columns. After a header, each section of the
+// file holds one column for every gene, gene order or chromosome. Gene numbers
+// index the gene name table from 1, and the genes of every chromosome lie back
+// to back in one buffer of 32 bit signed gene numbers, so a saved set is read
+// by mapping the file rather than by parsing it.
+//
+// Columns are in native byte order. A file written on a machine of the other
+// byte order fails the version check rather than being misread.
+
+#define SETFILE_MAGIC		"GOSET\0\0"		/* 8 bytes with the terminating 0 */
+#define SETFILE_VERSION		1
+
+// Sections, in the order they are written
+enum {
+	SETFILE_NAMES,					/* string table: the name of each gene number */
+	SETFILE_TYPES,					/* string table: the type of each gene number */
+	SETFILE_GENE_FILTERED,			/* a byte per gene number: 1 if filtered */
+	SETFILE_ORDER_NAMES,			/* string table, per gene order */
+	SETFILE_ORDER_SOURCES,			/* string table, per gene order */
+	SETFILE_ORDER_CLASSIFICATIONS,	/* string table, per gene order, one taxon per line */
+	SETFILE_ORDER_FLAGS,			/* a byte per gene order of SETFILE_FILTERED and SETFILE_VALID */
+	SETFILE_ORDER_CHROMOSOMES,		/* num_orders + 1 offsets into the chromosomes */
+	SETFILE_CHROMOSOME_SOURCES,		/* string table, per chromosome */
+	SETFILE_CHROMOSOME_GENES,		/* num_chromosomes + 1 offsets into the genes */
+	SETFILE_CHROMOSOME_CIRCULAR,	/* a byte per chromosome: 1 if circular */
+	SETFILE_GENES,					/* 32 bit signed gene numbers */
+	SETFILE_SECTIONS
+};
+
+#define SETFILE_FILTERED	1		/* the gene order is filtered */
+#define SETFILE_VALID		2		/* the gene order repeats no gene */
+
+// A string table is num_strings + 1 32 bit offsets into the bytes that follow
+// them, so string i is the bytes from offset i to offset i + 1.
+
+typedef struct setfile_header_struct
+{
+	char magic[8];
+	unsigned int version;
+	unsigned int num_names;
+	unsigned int num_orders;
+	unsigned int num_chromosomes;
+	unsigned long long num_genes;
+	unsigned long long offset[SETFILE_SECTIONS];	/* of each section, 8 byte aligned */
+	unsigned long long length[SETFILE_SECTIONS];	/* in bytes */
+} setfile_header_t;
+
+// The columns of a set to write
+typedef struct setfile_columns_struct
+{
+	std::vector<std::string> names;
+	std::vector<std::string> types;
+	std::vector<unsigned char> gene_filtered;
+	std::vector<std::string> order_names;
+	std::vector<std::string> order_sources;
+	std::vector<std::string> order_classifications;
+	std::vector<unsigned char> order_flags;				/* SETFILE_VALID is worked out on writing */
+	std::vector<unsigned int> order_chromosomes;
+	std::vector<std::string> chromosome_sources;
+	std::vector<unsigned int> chromosome_genes;
+	std::vector<unsigned char> chromosome_circular;
+	std::vector<int> genes;
+} setfile_columns_t;
+
+// Write a set, first to a temporary file that then replaces path, so a set is
+// never left half written. Returns false if the file could not be written.
+bool setfile_write(const char * path, setfile_columns_t & columns);
+
+// A saved set, mapped read only
+typedef struct setfile_struct
+{
+	int fd;
+	const char * data;
+	size_t size;
+	const setfile_header_t * header;
+
+	setfile_struct();
+	~setfile_struct();
+
+	// Returns 1 if path holds a set, 0 if it is some other file and -1 if it
+	// is a set that is damaged or of another version or byte order
+	int open(const char * path);
+	void close();
+
+	const void * section(int s) const { return data + header->offset[s]; }
+
+	// The number of strings of a string table section, and string i of it
+	unsigned int num_strings(int s) const;
+	const char * string(int s, unsigned int i, size_t * length) const;
+
+private:
+	bool check() const;
+	bool check_strings(int s, unsigned long long count) const;
+	bool check_offsets(int s, unsigned long long count, unsigned long long total) const;
+	bool check_genes() const;
+
+} setfile_t;
+
+#endif
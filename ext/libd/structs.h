@@ -8,20 +8,85 @@
 
 #define ERR_NOTIMPL		-5
 
+#define DIST_ADJACENCIES	1
+#define DIST_BREAKPOINTS	2
+#define DIST_INVERSIONS		3
+#define DIST_DCJ			4
+
+// Marks a cell of a distance matrix that has yet to be computed
+#define DIST_UNKNOWN		INT_MIN
+
 #define HURDLE          1
 #define GREATHURDLE (1<<1)
 #define SUPERHURDLE (1<<2)
 
 #include <stdlib.h>
+#include <limits.h>
 #include <stdio.h>
+#include <new>
 
 typedef short intArray; /* T_ARRAY */
+typedef int intArray32;
 
-typedef struct {
-	intArray * pi;
+// A chromosome of signed gene identifiers. Gene orders of up to 32767 genes
+// use 16 bit identifiers, which halves their footprint; larger ones use 32 bits.
+template <typename T>
+struct GenomeT {
+	T * pi;
 	bool circular;
 	int len;
-} Genome;
+};
+
+typedef GenomeT<intArray> Genome;
+typedef GenomeT<intArray32> Genome32;
+
+// A whole genome of one or more chromosomes. The genes of every chromosome lie
+// back to back in one buffer, so a scan over the genome is one pass over memory.
+// Chromosome c holds genes[offsets[c]] .. genes[offsets[c+1]-1].
+template <typename T>
+struct GenomeDescT {
+	T * genes;
+	const int * offsets;				/* num_chromosomes + 1 entries, offsets[0] is 0 */
+	const unsigned char * circular;		/* one flag per chromosome */
+	int num_chromosomes;
+
+	int num_genes() const {
+		return offsets[num_chromosomes];
+	}
+
+	// A view of one chromosome, for the kernels that work a chromosome at a time
+	GenomeT<T> chromosome(int c) const {
+		GenomeT<T> g;
+		g.pi = genes + offsets[c];
+		g.len = offsets[c+1] - offsets[c];
+		g.circular = circular[c];
+		return g;
+	}
+};
+
+typedef GenomeDescT<intArray> GenomeDesc;
+typedef GenomeDescT<intArray32> GenomeDesc32;
+
+// Properties of each width of gene identifier
+template <typename T> struct gene_traits;
+
+template <> struct gene_traits<intArray> {
+	typedef unsigned short ugene;		/* the identifier's bits, without sign extension */
+	typedef unsigned int key;			/* wide enough for two identifiers */
+	typedef unsigned int partner;		/* a stamp and an extremity, see adjmatch.h */
+	enum { max_gene = 32767 };
+	enum { stamp_shift = 16 };
+	enum { max_direct_gene = 32767 };	/* the largest gene indexed by extremity */
+};
+
+template <> struct gene_traits<intArray32> {
+	typedef unsigned int ugene;
+	typedef unsigned long long key;
+	typedef unsigned long long partner;
+	enum { max_gene = 2147483647 };
+	enum { stamp_shift = 32 };
+	enum { max_direct_gene = 1048575 };
+};
 
 typedef struct component_struct
 {
@@ -36,43 +101,88 @@ typedef struct component_struct
     int right;                  /* Index of component to the right of my rightmost block */
 } component_t;
 
+// One vertex of the breakpoint graph. The graph algorithms read these fields
+// together, so they sit together: a pass over the vertices walks one block of
+// memory rather than six arrays. Each field is reused by a later stage once the
+// stage that filled it is done, as noted. Graphs of fewer than 65536 vertices
+// use 16 bit indices, which halves the block.
+template <typename I>
+struct vertex_T {
+	I grey;				/* the other end of the vertex's grey edge, or NONE */
+	I mark;				/* num_cycles: first the position of each value of perm,
+						   then whether the vertex has been put on a cycle */
+	I parent;			/* the first vertex of its cycle, then the root of its component */
+	I range;			/* the rightmost vertex of the cycle it heads,
+						   then whether its grey edge is oriented */
+	I cc;				/* its component or NONE; the range of stack entry i */
+	I next;				/* the next vertex of its component; the root of stack entry i */
+
+	static const I NONE = (I)-1;
+};
+
+typedef vertex_T<unsigned short> vertex16_t;
+typedef vertex_T<int> vertex32_t;
+
+// Graphs of this many vertices or more need 32 bit indices
+#define VERTEX16_LIMIT	65536
+
 typedef struct distmem_struct
 {
 	int *perm1;                 /* DIST_INV: 2*num_genes + 2 */
     int *perm2;
     int *perm;
-    int *done;
-    int *greyEdges;
 
-    int *stack;                 /* DIST_INV: size */
-    int *oriented;
-    int *cc;
-    int *labeled;
+    void *vertices;             /* capacity vertex16_t or vertex32_t records, on
+                                   a cache line boundary */
     component_t *components;
     
+    int capacity;               /* number of vertices the arrays can hold */
+    bool wide;                  /* use 32 bit vertices whatever the size */
+    
+    distmem_struct(){
+    	capacity = 0;
+    	wide = false;
+    	perm1 = perm2 = perm = NULL;
+    	vertices = NULL;
+    	components = NULL;
+    }
     distmem_struct(int n){
-    	perm1 = new int[n];
+    	capacity = 0;
+    	wide = false;
+    	perm1 = perm2 = perm = NULL;
+    	vertices = NULL;
+    	components = NULL;
+    	reserve(n);
+	}
+	~distmem_struct(){
+		release();
+	}
+	
+	/* Grow the arrays to hold n vertices. Smaller requests keep the current arrays. */
+	void reserve(int n){
+		if(n <= capacity)
+			return;
+		
+		release();
+		
+		perm1 = new int[n];
 		perm2 = new int[n];
 		perm = new int[n];
-		done = new int[n];
-		greyEdges = new int[n];
-		stack = new int[n];
-		oriented = new int[n];
-		cc = new int[n];
-		labeled = new int[n];
+		if(posix_memalign(&vertices, 64, n * sizeof(vertex32_t)))
+			throw std::bad_alloc();
 		components = new component_t[n];
+		capacity = n;
 	}
-	~distmem_struct(){
-		delete perm1;
-		delete perm2;
-		delete perm;
-		delete done;
-		delete greyEdges;
-		delete stack;
-		delete oriented;
-		delete cc;
-		delete labeled;
-		delete components;
+	void release(){
+		delete[] perm1;
+		delete[] perm2;
+		delete[] perm;
+		free(vertices);
+		delete[] components;
+		perm1 = perm2 = perm = NULL;
+		vertices = NULL;
+		components = NULL;
+		capacity = 0;
 	}
 
 } distmem_t;
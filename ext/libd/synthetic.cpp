@@ -0,0 +1,80 @@
+#include <algorithm>
+#include "synthetic.h"
+
+synthetic_struct::synthetic_struct(unsigned long long seed){
+	state = seed;
+}
+
+// splitmix64, scaled to the range by a multiply rather than a division
+unsigned int synthetic_struct::below(unsigned int n){
+	unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	z ^= z >> 31;
+	return (unsigned int)(((z >> 32) * n) >> 32);
+}
+
+template <typename T>
+void synthetic_permutation(synthetic_t & random, T * p, int n){
+	int i;
+
+	for(i=0;i<n;i++){
+		p[i] = i + 1;
+	}
+	for(i=n-1;i>0;i--){
+		std::swap(p[i],p[random.below(i + 1)]);
+	}
+	for(i=0;i<n;i++){
+		if(random.below(2)){
+			p[i] = -p[i];
+		}
+	}
+}
+
+template <typename T>
+int synthetic_evolve(synthetic_t & random, T * p, int n, const synthetic_events_t & events){
+	int inversions = events.inversions;
+	int transpositions = events.transpositions;
+	int losses = events.losses;
+
+	while(inversions + transpositions + losses > 0){
+		unsigned int event = random.below(inversions + transpositions + losses);
+
+		if(event < (unsigned int)inversions){
+			int i = random.below(n);
+			int j = random.below(n);
+
+			if(i > j){
+				std::swap(i,j);
+			}
+			std::reverse(p + i,p + j + 1);
+			for(;i<=j;i++){
+				p[i] = -p[i];
+			}
+			inversions--;
+		}else if(event < (unsigned int)(inversions + transpositions)){
+			// Cut at three points and swap the two segments between them
+			int cuts[3] = { (int)random.below(n + 1), (int)random.below(n + 1), (int)random.below(n + 1) };
+
+			std::sort(cuts,cuts + 3);
+			std::rotate(p + cuts[0],p + cuts[1],p + cuts[2]);
+			transpositions--;
+		}else{
+			if(n > 1){
+				int k = random.below(n);
+
+				std::copy(p + k + 1,p + n,p + k);
+				n--;
+			}
+			losses--;
+		}
+	}
+
+	return n;
+}
+
+template void synthetic_permutation(synthetic_t &, intArray *, int);
+template void synthetic_permutation(synthetic_t &, intArray32 *, int);
+template int synthetic_evolve(synthetic_t &, intArray *, int, const synthetic_events_t &);
+template int synthetic_evolve(synthetic_t &, intArray32 *, int, const synthetic_events_t &);
@@ -0,0 +1,41 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include "structs.h"
+
+// Synthetic genomes for the benchmarks: random signed permutations, and copies
+// of them changed by a chosen number of each kind of rearrangement, so the
+// distances between benchmark genomes are like those of related species rather
+// than of unrelated random orders.
+//
+// The generator has its own random numbers, so a seed gives the same genomes
+// on every platform and timings stay comparable from one run to the next.
+
+typedef struct synthetic_struct
+{
+	unsigned long long state;
+
+	synthetic_struct(unsigned long long seed);
+
+	// A random number below n
+	unsigned int below(unsigned int n);
+} synthetic_t;
+
+// The rearrangements applied to a genome, in a random order
+typedef struct synthetic_events_struct
+{
+	int inversions;			/* reverse a segment, changing the sign of its genes */
+	int transpositions;		/* move a segment elsewhere, keeping its strand */
+	int losses;				/* delete a gene */
+} synthetic_events_t;
+
+// A random signed permutation of 1..n
+template <typename T>
+void synthetic_permutation(synthetic_t & random, T * p, int n);
+
+// Apply the events to the n genes of p in place. Returns the number of genes
+// left, which is n less the losses, but never below 1.
+template <typename T>
+int synthetic_evolve(synthetic_t & random, T * p, int n, const synthetic_events_t & events);
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef VPTREE_H
+#define VPTREE_H
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+// A vantage point tree over n items by a distance that is a metric, for k nearest
+// neighbour queries. Each node splits the items below it by their distance to its
+// vantage point: those closer than the node's radius go inside and the rest go
+// outside, so by the triangle inequality a query only descends into a side that
+// may hold an item as close as the k-th nearest found so far. Building costs
+// O(n log n) distances and a query typically far fewer than the n of a scan.
+//
+// The tree is a flat array of nodes with the root first, so it can be kept as one
+// string between calls. Distances are non-negative integers, and items are ranked
+// by distance and then by number, so a query finds exactly the k items that a
+// full scan ranked the same way would. A negative distance is an error: it stops
+// the build or query, which returns it.
+typedef struct vpnode_struct
+{
+	int item;				/* the vantage point */
+	int radius;				/* items inside are closer than this to item */
+	int inside;				/* node of the items closer than radius, or -1 */
+	int outside;			/* node of the rest, or -1 */
+} vpnode_t;
+
+// Build the tree of items 0 .. n-1, where distance(i,j) is the distance between
+// items i and j. Returns 0, or the first negative distance, leaving no nodes.
+template <typename D>
+int vptree_build(int n, D & distance, std::vector<vpnode_t> & nodes){
+
+	struct task_t { int begin; int end; int parent; bool inside; };
+
+	std::vector<int> items(n);
+	std::vector< std::pair<int,int> > scratch;		/* distance to the vantage point, item */
+	std::vector<task_t> tasks;
+	unsigned int seed = 1;
+	int k;
+
+	nodes.clear();
+	for(k=0;k<n;k++){
+		items[k] = k;
+	}
+	if(n > 0){
+		task_t root = { 0, n, -1, false };
+		tasks.push_back(root);
+	}
+
+	while(!tasks.empty()){
+		task_t task = tasks.back();
+		tasks.pop_back();
+
+		// A vantage point drawn at random keeps the tree balanced on sorted input
+		seed = seed * 1103515245u + 12345u;
+		std::swap(items[task.begin],items[task.begin + (seed >> 16) % (task.end - task.begin)]);
+
+		vpnode_t node = { items[task.begin], 0, -1, -1 };
+		int index = nodes.size();
+
+		if(task.parent >= 0){
+			if(task.inside){
+				nodes[task.parent].inside = index;
+			}else{
+				nodes[task.parent].outside = index;
+			}
+		}
+
+		int first = task.begin + 1;
+		if(first < task.end){
+			scratch.clear();
+			for(k=first;k<task.end;k++){
+				int d = distance(node.item,items[k]);
+				if(d < 0){
+					nodes.clear();
+					return d;
+				}
+				scratch.push_back(std::make_pair(d,items[k]));
+			}
+
+			// The median distance splits the items in two, unless it is also the
+			// least, when the items at that distance go inside
+			std::nth_element(scratch.begin(),scratch.begin() + scratch.size() / 2,scratch.end());
+			node.radius = scratch[scratch.size() / 2].first;
+
+			int inside = 0;
+			for(k=0;k<(int)scratch.size();k++){
+				inside += scratch[k].first < node.radius;
+			}
+			if(!inside){
+				node.radius++;
+			}
+
+			int split = first;
+			for(k=0;k<(int)scratch.size();k++){
+				if(scratch[k].first < node.radius){
+					items[split++] = scratch[k].second;
+				}
+			}
+			int rest = split;
+			for(k=0;k<(int)scratch.size();k++){
+				if(scratch[k].first >= node.radius){
+					items[rest++] = scratch[k].second;
+				}
+			}
+
+			if(split < task.end){
+				task_t outside = { split, task.end, index, false };
+				tasks.push_back(outside);
+			}
+			if(split > first){
+				task_t inside_task = { first, split, index, true };
+				tasks.push_back(inside_task);
+			}
+		}
+
+		nodes.push_back(node);
+	}
+
+	return 0;
+}
+
+// The k items nearest a query, nearest first, as (distance, item) pairs, where
+// distance(i) is the distance from the query to item i. Items flagged in skip,
+// if it is not NULL, are passed over but still guide the search. Returns 0, or
+// the first negative distance, leaving nearest empty.
+template <typename D>
+int vptree_nearest(const vpnode_t * nodes, int num_nodes, int k, D & distance, const unsigned char * skip,
+					std::vector< std::pair<int,int> > & nearest){
+
+	std::vector< std::pair<int,int> > stack;		/* node, least distance of any item below it */
+	std::vector< std::pair<int,int> > & heap = nearest;
+
+	heap.clear();
+	if(num_nodes <= 0 || k <= 0){
+		return 0;
+	}
+
+	stack.push_back(std::make_pair(0,0));
+	while(!stack.empty()){
+		int n = stack.back().first;
+		int bound = stack.back().second;
+		stack.pop_back();
+
+		// A subtree is searched unless it cannot hold an item ranked before the k-th
+		if((int)heap.size() == k && bound > heap.front().first){
+			continue;
+		}
+
+		const vpnode_t & node = nodes[n];
+		int d = distance(node.item);
+		if(d < 0){
+			heap.clear();
+			return d;
+		}
+
+		if(!skip || !skip[node.item]){
+			std::pair<int,int> found(d,node.item);
+
+			if((int)heap.size() < k){
+				heap.push_back(found);
+				std::push_heap(heap.begin(),heap.end());
+			}else if(found < heap.front()){
+				std::pop_heap(heap.begin(),heap.end());
+				heap.back() = found;
+				std::push_heap(heap.begin(),heap.end());
+			}
+		}
+
+		// Items inside are at least d - radius + 1 from the query, and items
+		// outside at least radius - d, besides the bound of this node. The
+		// nearer side is pushed last so it is searched first.
+		int inside_bound = std::max(bound,d - node.radius + 1);
+		int outside_bound = std::max(bound,node.radius - d);
+
+		if(d < node.radius){
+			if(node.outside >= 0){
+				stack.push_back(std::make_pair(node.outside,outside_bound));
+			}
+			if(node.inside >= 0){
+				stack.push_back(std::make_pair(node.inside,inside_bound));
+			}
+		}else{
+			if(node.inside >= 0){
+				stack.push_back(std::make_pair(node.inside,inside_bound));
+			}
+			if(node.outside >= 0){
+				stack.push_back(std::make_pair(node.outside,outside_bound));
+			}
+		}
+	}
+
+	std::sort_heap(heap.begin(),heap.end());
+
+	return 0;
+}
+
+#endif
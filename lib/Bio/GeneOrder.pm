@@ -129,10 +129,16 @@ use Bio::GeneOrder::Distance;
 use Storable;
 
 use base qw(Bio::Root::Root);
-use vars qw(%REV %FILTER %SWITCH $LINEAR);
+use vars qw(%REV %FILTER %SWITCH $LINEAR $GENERATION $REVISION $SESSION);
 
 BEGIN {
 	$LINEAR = '~';
+	#Counts changes to any permutation or gene filter. Each permutation and key
+	#is stamped with the count of its own last change and the session
+	$GENERATION = 0;
+	#Counts changes to permutations alone, which gene filters leave alone
+	$REVISION = 0;
+	$SESSION = "$$.".time;
 	%REV = ( '+' => '-',
 			 '' => '-',
 			 '-' => '' );
@@ -157,6 +163,7 @@ BEGIN {
  Returns : A Bio::GeneOrder object initialized with a Bio::SeqI compliant object
  Args    : Accepts an array of Bio::SeqI compliant objects, gene order strings, or
            Bio::GeneOrder::permutation objects with the additional optional arguments.
+           Permutations that all share one gene key keep it.
            -name              => a string representing the name of this gene order
                                  required if -order is provided
                                  [default is species from source sequence]
@@ -191,11 +198,20 @@ sub new {
 		if( !defined($param{'-file'}) && exists($param{'-file'}) );
 
 	if( defined $param{'-file'}){
+		my ($key,@loaded) = Bio::GeneOrder::Distance::_load_orders($param{'-file'});
+		
+		if(defined $key){
+			$self->throw($param{'-file'}." holds ".scalar(@loaded)." gene orders, not one")
+				unless @loaded == 1;
+			return $loaded[0];
+		}
+		
+		#gene orders saved with Storable, before the columnar format
 		return retrieve($param{'-file'}) || $self->throw("GeneOrder object could not be opened from ".$param{'-file'});
 	}
 
 	$caller->throw("no sequences provided") 	
-		unless(@seqs || @orders);
+		unless(@seqs || @orders || @perms);
 	$caller->throw("-name argument is required when not providing sequence objects") 	
 		unless(@seqs || defined $param{'-name'});
 	$caller->throw("name argument provided, but with an undefined value")
@@ -310,8 +326,8 @@ sub new {
 			my $circular = 1;
 			$circular = 0 if($order =~ s/^$LINEAR\s*//);
 			
-			my @names = map( /^[\-+]?(\S+)/, split / /, $order);
-			my @strands = map( /^([\-+])?\S+/, split / /, $order);
+			my @names = map( /^[\-+]?(\S+)/, split ' ', $order);
+			my @strands = map( /^([\-+])?\S+/, split ' ', $order);
 			map(eval{$_ = '+' unless $_},@strands);
 
 			for(my $u=0;$u<@names;$u++){
@@ -338,21 +354,43 @@ sub new {
 		
 	}
 	
+	my $shared;
 	if(@perms){
-	
-		foreach my $permutation (@perms){
 		
-			my $key = $permutation->_key;
-			my %names = keys %{$key->{'index'}};
-			
-			
+		if(!@seqs && !@orders && !grep($_->_key != $perms[0]->_key, @perms)){
+			#Permutations numbered from one key, as those read from one file are,
+			#keep it, so their genes are not looked up again
+			$self->{'key'} = $perms[0]->_key;
+			push @permutations, @perms;
+			$shared = 1;
+		}else{
+			foreach my $permutation (@perms){
+				my $key = $permutation->_key;
+				my @pi;
+				
+				foreach my $gene ($permutation->pi('all')){
+					my $name = $key->{'name'}->{abs($gene)};
+					
+					unless(defined $self->{'key'}->{'index'}->{$name}){
+						$self->{'key'}->{'name'}->{$i} = $name;
+						$self->{'key'}->{'index'}->{$name} = $i++;
+						$self->{'key'}->{'type'}->{$name} = $key->{'type'}->{$name};
+					}
+					
+					push @pi, $gene < 0 ? -$self->{'key'}->{'index'}->{$name} : $self->{'key'}->{'index'}->{$name};
+				}
+				
+				push @permutations, Bio::GeneOrder::permutation->new( -circular => $permutation->is_circular,
+																	  -source   => $permutation->source,
+																	  -pi       => \@pi );
+			}
 		}
 	}
 
 	$self->{'pi'} = \@permutations;
 	$self->{'name'} =~ s/\s/_/g;
 	$self->{'circular'} = ${$self->{'pi'}}[0]->is_circular && @{$self->{'pi'}} == 1 ? 1 : -1;
-	map( $self->{'key'}->{'filt'}->{$_} = 0, keys %{$self->{'key'}->{'index'}});
+	map( $self->{'key'}->{'filt'}->{$_} = 0, keys %{$self->{'key'}->{'index'}}) unless $shared;
 	map( $_->{'key'} = $self->{'key'} , $self->pi );
 	$self->filtered(0);
 	
@@ -633,6 +671,23 @@ sub breakpoints {
 	return $orderA->distance->breakpoints($orderA,$orderB);
 }
 
+=head2 signature
+
+ Title   : signature
+ Usage   : my $signature = $geneOrderA->signature();
+ Function: Returns the adjacencies of this gene order in a canonical form. Gene
+           orders with equal signatures are 0 breakpoints apart (see
+           Bio::GeneOrder::Distance::signature).
+ Returns : A packed string
+
+=cut
+
+sub signature {
+	my $self = shift;
+
+	return $self->distance->signature($self);
+}
+
 =head2 filter_genes
 
  Title   : filter_genes
@@ -713,13 +768,14 @@ sub filter_genes {
 				map( $self->{'key'}->{'filt'}->{$_} = 1, @matched);
 			}
 			
+			_refilter($self->{'key'});
 			$self->{'distance'}->_cache('clear');
 		}
 		
 	}elsif( keys %{ $self->{'key'}->{'filt'} } ){
 		map( $self->{'key'}->{'filt'}->{$_} = 0, @genes);
+		_refilter($self->{'key'});
 		$self->{'distance'}->_cache('clear');
-		$self->_key($self->{'key'});
 	}
 	
 	return @matched;
@@ -941,7 +997,8 @@ sub distance {
 
  Title   : save
  Usage   : $geneOrderA->save('filename');
- Function: Save the GeneOrder object to a file for later recovery.
+ Function: Save the GeneOrder object to a file for later recovery, in the
+           format of Bio::GeneOrder::Set::save.
  Returns : 1 for success, 0 for failure.
 
 =cut
@@ -949,11 +1006,38 @@ sub distance {
 sub save {
 	my ($self,$file) = @_;
 
-	store $self, $file || $self->throw("GeneOrder could not be saved to $file");
+	Bio::GeneOrder::Distance::_save_orders($file, $self->_key, $self)
+		|| $self->throw("GeneOrder could not be saved to $file");
 
 	return 1;
 }
 
+=head2 _packed
+
+ Title   : _packed
+ Usage   : $geneOrder->_packed('reduce',$arrayRef);
+ Function: Get/set a packed form of the permutations, as built by
+           Bio::GeneOrder::Distance. It is kept until a permutation of this
+           gene order or a gene filter of its key changes, so repeated
+           distance calls reuse it while other gene orders change.
+ Returns : The packed string, or undef if none is current
+ Args    : The kind of packing and optionally the packed string
+
+=cut
+
+sub _packed {
+	my ($self,$kind,$packed) = @_;
+	
+	my $stamp = join(';', $self->{'key'}->{'generation'} || '', map( $_->{'revision'} || '', @{$self->{'pi'}}));
+	if( !defined $self->{'packed'} || $self->{'packed'}->{'stamp'} ne $stamp){
+		$self->{'packed'} = { 'stamp' => $stamp };
+	}
+	
+	$self->{'packed'}->{$kind} = $packed if defined $packed;
+	
+	return $self->{'packed'}->{$kind};
+}
+
 =head2 _key
 
  Title   : _key
@@ -974,5 +1058,23 @@ sub _key {
 	return $self->{'key'};
 }
 
+=head2 _refilter
+
+ Title   : _refilter
+ Usage   : Bio::GeneOrder::_refilter($key);
+ Function: Counts a change to the gene filters of a key in $GENERATION, and
+           stamps the key with it, so the packed permutations of every gene
+           order that shares the key are rebuilt.
+ Args    : The gene name/number key
+
+=cut
+
+sub _refilter {
+	my $key = shift;
+	
+	$GENERATION++;
+	$key->{'generation'} = "$SESSION.$GENERATION";
+}
+
 
 1;
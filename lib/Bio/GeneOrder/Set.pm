@@ -122,9 +122,23 @@ sub new {
 	if($args[0] eq '-file'){
 		$caller->throw("file argument provided but with an undefined value") 
 			unless $args[1];
-		$self = retrieve($args[1]) || $caller->throw("Set object could not be opened from $args[1]");
 		
-		my @orders = $self->orders;
+		my ($key,@orders) = Bio::GeneOrder::Distance::_load_orders($args[1]);
+		if(defined $key){
+			$self = $caller->SUPER::new();
+			bless $self, $caller;
+			
+			$self->{'orders'} = [ @orders ];
+			$self->{'key'} = $key;
+			$self->{'no_orders'} = scalar @orders;
+			map( $self->{ $_->name } = $_, @orders);
+			$self->{'distance'} = Bio::GeneOrder::Distance->new();
+		}else{
+			#sets saved with Storable, before the columnar format
+			$self = retrieve($args[1]) || $caller->throw("Set object could not be opened from $args[1]");
+		}
+		
+		@orders = $self->orders;
 		for(my $i = 0; $i<scalar @orders;$i++){
 			$self->{'indices'}{ $orders[$i]->name } = $i;
 		}
@@ -147,9 +161,9 @@ sub new {
 	$self->throw("at least one GeneOrder object is required to initialize a Set object") 
 		unless( @args);
 	
-	$self->push(@args);
-	
 	$self->{'distance'} = Bio::GeneOrder::Distance->new();
+	
+	$self->push(@args);
 
 	return $self;
 }
@@ -207,6 +221,11 @@ sub index {
 	
 	$self->throw("name argument not provided") 
 		if( !defined $name );
+	
+	unless(defined $self->{'indices'}){
+		my $i = 0;
+		map $self->{'indices'}{$_->name} = $i++ , $self->orders;
+	}
 		
 	return $self->{'indices'}{ $name };
 		
@@ -314,28 +333,64 @@ sub push {
 		$self->{'no_orders'}++;
 	}
 	
-	#update key
-	my (@genes,%types);
-	map( eval{ push @genes, $_->genes(-all => 1) }, @orders);
-	map( eval{ @types{ keys %{ $_->_key()->{'type'} } } = values %{ $_->_key()->{'type'} } }, @orders);
-	
-	my %saw;
-	@saw{@genes} = ();
-	@genes = keys %saw;
+	#update key: number every gene of the set by name so that packed permutations,
+	#and the distance cache keyed on them, are the same in every session. Gene
+	#orders read from one file share a key, so each key is only merged once.
+	my %keys;
+	map( $keys{ $_->_key } = $_->_key, @{ $self->{'orders'} });
 	
-	map( $self->{'key'}->{'filt'}->{$_} = 0, @genes);
+	my (%index,%types);
+	foreach my $key (values %keys){
+		@index{ keys %{ $key->{'index'} } } = ();
+		@types{ keys %{ $key->{'type'} } } = values %{ $key->{'type'} };
+	}
 	
 	$i = 1;
-	map($self->{'key'}->{'index'}->{$_} = $i++, @genes);
-	%{ $self->{'key'}->{'name'} } = reverse(%{ $self->{'key'}->{'index'} });
-	$self->{'key'}->{'type'} = \%types;
+	map( $index{$_} = $i++, sort keys %index);
+	
+	#a table from the numbers of each key to the new ones
+	my %tables;
+	foreach my $key (values %keys){
+		my @table = (0) x (1 + scalar keys %{ $key->{'name'} });
+		while( my ($name,$number) = each %{ $key->{'index'} }){
+			$table[$number] = $index{$name};
+		}
+		$tables{"$key"} = pack("l*", map( defined $_ ? $_ : 0, @table));
+	}
+	
+	#genes already in the set stay filtered
+	my $key = $self->{'key'} ||= {};
+	my %filt = %{ $key->{'filt'} || {} };
 	
-	$self->_key($self->{'key'});
+	%{ $key->{'index'} } = %index;
+	%{ $key->{'name'} } = reverse %index;
+	%{ $key->{'filt'} } = map( ($_ => $filt{$_} ? 1 : 0), keys %index);
+	$key->{'type'} = \%types;
+	
+	foreach my $order (@{ $self->{'orders'} }){
+		my $table = $tables{ $order->_key };
+		map( $_->_renumber($key,$table), $order->pi);
+		$order->{'key'} = $key;
+	}
+	Bio::GeneOrder::_refilter($key);
+	
+	#size the distance workspace for the largest gene order
+	my $max_genes = 0;
+	foreach my $order (@orders){
+		my $no_genes = 0;
+		map( $no_genes += scalar($_->pi('all')), $order->pi);
+		$max_genes = $no_genes if $no_genes > $max_genes;
+	}
+	$self->distance->reserve($max_genes);
 	
 	#update filters
 	$self->filter_genes(%GFILTER) if %GFILTER;
 	$self->filter_orders(%OFILTER) if %OFILTER;
 	
+	#check each gene order once so distances between them can skip the checks;
+	#renumbering the set above changed the genes of every order
+	map( $self->distance->validate($_), @{ $self->{'orders'} });
+	
 	#update index values
 	my @orders = $self->orders;
 	$i = 0;
@@ -481,8 +536,8 @@ sub filter_orders {
 				my @matched = grep($_->name =~ $regexp, @{ $self->{'orders'} });
 				foreach my $match (@matched){
 					if($param{'-unique'}){
-						my @unique = grep( $match->breakpoints($_) == 0, 
-												  $self->orders);
+						my $signature = $match->signature;
+						my @unique = grep( $_->signature eq $signature, $self->orders);
 						foreach(@unique){
 							CORE::push @filtered, $self->filter_orders( '-name' => $_->name );
 						}
@@ -496,8 +551,8 @@ sub filter_orders {
 					}
 				}
 			}elsif($param{'-unique'}){
-				my @unique = grep( $self->{ $param{'-name'} }->breakpoints($_) == 0, 
-										  $self->orders);
+				my $signature = $self->{ $param{'-name'} }->signature;
+				my @unique = grep( $_->signature eq $signature, $self->orders);
 				foreach(@unique){
 					CORE::push @filtered, $self->filter_orders( '-name' => $_->name );
 				}
@@ -538,16 +593,25 @@ sub filter_orders {
 			($bound_count{$_}++) for map ($_->bounds, @{ $self->{'orders'} });
 			my $max_bound_count = (sort {$bound_count{$b} <=> $bound_count{$a}} keys %bound_count)[0];
 			
+			#-unique groups the unfiltered gene orders by adjacency signature, in
+			#one pass, rather than comparing every pair
+			my %num_identical;
+			map( $num_identical{ $_->signature }++, $self->orders) if $param{'-unique'};
+			
+			#and distance thresholds count neighbors through an index, leaving out
+			#the gene orders filtered so far, packed once by their rows in the index
+			my @orders = @{ $self->{'orders'} };
+			my $excluded = pack("l*", grep( $orders[$_]->filtered, 0 .. $#orders));
+			
 			my $matched =0;
-			foreach my $order (@{ $self->{'orders'} }){
+			foreach my $row (0 .. $#orders){
+				my $order = $orders[$row];
+				
 				#If this order has already been filtered, we need not filter it again
 				unless( $order->filtered ){
 					#-unique
 					if( $param{'-unique'}){
-						my $num_identical = grep( $order->breakpoints($_) == 0, 
-												  $self->orders);
-		
-						if( $num_identical > 1){
+						if( $num_identical{ $order->signature } > 1){
 								$matched++;
 								CORE::push @filtered, $self->filter_orders( '-name' => $order->name, );
 						}
@@ -634,7 +698,9 @@ sub filter_orders {
 						#for which the specified arguments apply
 						
 						foreach my $d (@d){
-							my $num_neighbors = grep( $self->distance->$d($order,$_) < $param{"-min_$d"}, $self->orders);
+							my $num_neighbors = $self->_neighbors($d)
+								? $self->_count_neighbors($d,$row,$param{"-min_$d"},0,$excluded)
+								: grep( $self->distance->$d($order,$_) < $param{"-min_$d"}, $self->orders);
 							
 							if( ($num_neighbors-1) > $cluster_size){
 								$matched++;
@@ -650,7 +716,9 @@ sub filter_orders {
 						#for which the specified arguments apply
 						
 						foreach my $d (@d){
-							my $num_neighbors = grep( $self->distance->$d($_,$order) > $param{"-max_$d"}, $self->orders);
+							my $num_neighbors = $self->_neighbors($d)
+								? $self->_count_neighbors($d,$row,$param{"-max_$d"},1,$excluded)
+								: grep( $self->distance->$d($_,$order) > $param{"-max_$d"}, $self->orders);
 						
 							if( $num_neighbors > $cluster_size){
 								$matched++;
@@ -663,6 +731,12 @@ sub filter_orders {
 					if($param{'-invert'} && $matched == 0){
 						CORE::push @filtered, $self->filter_orders( '-name' => $order->name, );
 					}
+					
+					#an order filtered here no longer counts as a copy or a neighbor of the rest
+					if($order->filtered){
+						$num_identical{ $order->signature }-- if $param{'-unique'};
+						$excluded .= pack("l", $row);
+					}
 				}
 			}
 			
@@ -675,10 +749,8 @@ sub filter_orders {
 		%OFILTER = ();
 	}
 	
-	#update index values
-	my $i = 0;
-	$self->{'indices'} = {};
-	map $self->{'indices'}{$_->name} = $i++ , $self->orders;
+	#index values are rebuilt when next asked for, not once per filtered order
+	delete $self->{'indices'};
 		
 	return @filtered;
 }
@@ -769,7 +841,7 @@ sub filter_genes {
 	}
 	
 	if($filtered){
-		$self->_key($self->{'key'});
+		Bio::GeneOrder::_refilter($self->{'key'});
 		$self->distance->_cache('clear');
 	}
 	
@@ -1034,12 +1106,84 @@ sub distance {
 	return shift->{'distance'};
 }
 
+=head2 nearest
+
+ Title   : nearest
+ Usage   : my @nearest = $geneOrderSet->nearest($geneOrder, 5, 'breakpoints');
+ Function: Finds the unfiltered gene orders of the set closest to a gene order
+           by breakpoint or DCJ distance. The gene order need not belong to the
+           set: its genes are matched to the set's by name, and genes the set
+           filters are left out. DCJ distances are only defined between gene
+           orders of the same genes, so only those are searched.
+           The first query of a distance indexes the set in a vantage point tree,
+           which later queries search without comparing the gene order with
+           every one of the set. The index is kept until gene orders are added
+           or genes change.
+ Returns : Up to k Bio::GeneOrder objects, nearest first. Gene orders as near as
+           each other keep the order of the set. A gene order of the set is not
+           returned as its own neighbor.
+ Args    : A Bio::GeneOrder object, the number of gene orders to return [default 1]
+           and the distance, 'breakpoints' or 'DCJ' [default 'breakpoints']
+
+=cut
+
+sub nearest {
+	my ($self,$order,$k,$distance) = @_;
+	
+	$k = 1 unless defined $k;
+	$distance = 'breakpoints' unless defined $distance;
+	
+	$self->throw("a Bio::GeneOrder object is required") 
+		unless ref $order && $order->isa('Bio::GeneOrder');
+	$self->throw("k must be a positive integer") 
+		unless $k =~ /^\d+$/ && $k > 0;
+	$self->throw("distance '$distance' can not be searched, use 'breakpoints' or 'DCJ'") 
+		unless $distance eq 'breakpoints' || $distance eq 'DCJ';
+	
+	my @chromosomes = $self->_query_genome($order);
+	
+	my $content = '';
+	if($distance eq 'DCJ'){
+		my %genes;
+		map( @genes{ map(abs($_), @{$_}[1..$#$_]) } = (), @chromosomes);
+		
+		#number the genes 1..N in the order of their numbers, as pack_order_reduce does
+		my $i = 1;
+		my @numbers = sort {$a <=> $b} keys %genes;
+		map( $genes{$_} = $i++, @numbers);
+		foreach my $chromosome (@chromosomes){
+			my ($circular,@genes) = @$chromosome;
+			$chromosome = [ $circular, map($_/abs($_)*$genes{abs($_)}, @genes) ];
+		}
+		
+		$content = join(',', @numbers);
+		return () if Bio::GeneOrder::Distance::validate_xs(Bio::GeneOrder::Distance::_pack_genome(@chromosomes));
+	}
+	
+	my $group = $self->_nearest_index($distance)->{ $content };
+	return () unless defined $group;
+	
+	my $skip = pack("C*", map( $_->filtered || $_ == $order ? 1 : 0, @{ $group->{'orders'} }));
+	my @found = Bio::GeneOrder::Distance::vptree_nearest_xs($group->{'packed'}, $group->{'tree'}, $distance,
+		Bio::GeneOrder::Distance::_pack_genome(@chromosomes), $k, $skip);
+	pop @found;
+	
+	my @nearest;
+	while(my ($item,$d) = splice(@found,0,2)){
+		CORE::push @nearest, $group->{'orders'}->[$item];
+	}
+	
+	return @nearest;
+}
+
 =head2 save
 
  Title   : save
  Usage   : $geneOrderSet->save('filename');
  Function: Save the GeneOrder set object to a file for later recovery.
-           Depending on the size of your set, this could be a large file.
+           The file holds the genes of every gene order in one buffer that
+           is mapped when the set is opened again with new(-file => ...),
+           and it does not depend on the version of Perl.
  Returns : 1 for success, 0 for failure.
 
 =cut
@@ -1047,7 +1191,8 @@ sub distance {
 sub save {
 	my ($self,$file) = @_;
 
-	store $self, $file || $self->throw("GeneOrder::Set could not be saved to $file");
+	Bio::GeneOrder::Distance::_save_orders($file, $self->_key, @{ $self->{'orders'} })
+		|| $self->throw("GeneOrder::Set could not be saved to $file");
 
 	return 1;
 }
@@ -1063,6 +1208,194 @@ sub max_genes {
 	return $max_genes;
 }
 
+=head2 _neighbors
+
+ Title   : _neighbors
+ Usage   : my $index = $orderSet->_neighbors('breakpoints');
+ Function: Returns the neighbor index of a distance: the distance matrix of every
+           gene order of the set, filtered or not, with a row per gene order in
+           the order of the set and each row also sorted, so the gene orders
+           closer to or further from one than any threshold are counted by
+           binary search. It is built once per distance and kept until
+           gene orders are added or their genes change, so changing a threshold,
+           a cluster size or the filtered gene orders computes no distances.
+ Returns : A hash reference holding the matrix and the sorted rows, or undef if
+           the distance has no matrix
+ Args    : The name of a distance
+
+=cut
+
+sub _neighbors {
+	my ($self,$distance) = @_;
+	
+	return unless grep($_ eq $distance, qw(adjacencies breakpoints inversions DCJ));
+	
+	my $stamp = "$Bio::GeneOrder::SESSION.$Bio::GeneOrder::GENERATION.".scalar @{ $self->{'orders'} };
+	my $index = $self->{'neighbors'}->{$distance};
+	
+	unless(defined $index && $index->{'stamp'} eq $stamp){
+		my @orders = @{ $self->{'orders'} };
+		my $n = scalar @orders;
+		
+		my $matrix = $self->distance->_matrix($distance,@orders);
+		$index = $self->{'neighbors'}->{$distance} = {
+			'stamp'  => $stamp,
+			'n'      => $n,
+			'matrix' => $matrix,
+			'sorted' => Bio::GeneOrder::Distance::neighbors_build_xs($matrix,$n),
+		};
+	}
+	
+	return $index;
+}
+
+=head2 _count_neighbors
+
+ Title   : _count_neighbors
+ Usage   : my $count = $orderSet->_count_neighbors('breakpoints',$row,3,0,$excluded);
+ Function: Counts the unfiltered gene orders, the gene order itself included,
+           closer to a gene order than a distance or, with $above, further from
+           it, through the neighbor index
+ Returns : Scalar value
+ Args    : The name of a distance, the position of the gene order in the set,
+           the distance, whether to count the gene orders above it and the
+           positions of the filtered gene orders packed as longs, which the
+           caller keeps up to date as it filters rather than packing them anew
+           for every gene order
+
+=cut
+
+sub _count_neighbors {
+	my ($self,$distance,$row,$threshold,$above,$excluded) = @_;
+	
+	my $index = $self->_neighbors($distance);
+	
+	return Bio::GeneOrder::Distance::neighbors_count_xs($index->{'matrix'},$index->{'sorted'},$index->{'n'},
+		$row,$threshold,$above ? 1 : 0,$excluded);
+}
+
+=head2 _nearest_index
+
+ Title   : _nearest_index
+ Usage   : my $groups = $orderSet->_nearest_index('DCJ');
+ Function: Returns the vantage point trees searched by nearest, building them if
+           gene orders were added or genes changed since. Breakpoint distances
+           index every gene order of the set, filtered or not, in one tree.
+           DCJ distances index the gene orders without duplicate genes in one
+           tree for each set of genes, packed as by pack_order_reduce.
+           The trees are kept while _content is unchanged.
+ Returns : A hash reference of groups by their genes ('' for breakpoints), each
+           holding the gene orders, their packed forms and the tree
+ Args    : 'breakpoints' or 'DCJ'
+
+=cut
+
+sub _nearest_index {
+	my ($self,$distance) = @_;
+	
+	my $stamp = "$Bio::GeneOrder::SESSION.$Bio::GeneOrder::GENERATION.$Bio::GeneOrder::REVISION";
+	my $index = $self->{'nearest'}->{$distance};
+	
+	#every gene order made anywhere, such as the one searched for, moves the
+	#stamp, so the gene orders and filters of the set are checked before building
+	my $content;
+	if(defined $index && $index->{'stamp'} ne $stamp){
+		$content = $self->_content;
+		$index->{'stamp'} = $stamp if $content eq $index->{'content'};
+	}
+	return $index->{'groups'} if defined $index && $index->{'stamp'} eq $stamp;
+	$content = $self->_content unless defined $content;
+	
+	my %groups;
+	foreach my $order (@{ $self->{'orders'} }){
+		my $content = '';
+		my $packed;
+		
+		if($distance eq 'DCJ'){
+			next unless $self->distance->validate($order);
+			
+			my %genes;
+			map( @genes{ map(abs($_), $_->pi) } = (), $order->pi);
+			$content = join(',', sort {$a <=> $b} keys %genes);
+			$packed = $self->distance->pack_order_reduce($order);
+		}else{
+			$packed = $self->distance->pack_order($order);
+		}
+		
+		CORE::push @{ $groups{$content}->{'orders'} }, $order;
+		CORE::push @{ $groups{$content}->{'packed'} }, $packed;
+	}
+	
+	foreach my $group (values %groups){
+		$group->{'tree'} = Bio::GeneOrder::Distance::vptree_build_xs($group->{'packed'},$distance);
+	}
+	
+	$self->{'nearest'}->{$distance} = { 'stamp' => $stamp, 'content' => $content, 'groups' => \%groups };
+	
+	return \%groups;
+}
+
+=head2 _content
+
+ Title   : _content
+ Usage   : my $content = $orderSet->_content;
+ Function: Describes the gene orders of the set, their permutations and the
+           genes the set filters in one string, so that indices of the set can
+           tell whether it changed in one comparison, without packing its gene
+           orders again.
+ Returns : A packed string
+
+=cut
+
+sub _content {
+	my $self = shift;
+	
+	my $key = $self->_key;
+	my @filtered = sort {$a <=> $b} map($key->{'index'}->{$_}, grep($key->{'filt'}->{$_}, keys %{ $key->{'filt'} }));
+	
+	return pack("(w/a)*", join(',', @filtered), map(("$_", map($_->{'pi'}, @{ $_->{'pi'} })), @{ $self->{'orders'} }));
+}
+
+=head2 _query_genome
+
+ Title   : _query_genome
+ Usage   : my @chromosomes = $orderSet->_query_genome($geneOrder);
+ Function: Numbers the unfiltered genes of a gene order by the set's key, as
+           _pack_genome takes them. Genes the set filters are left out, and
+           genes the set does not have are numbered after all of its genes.
+ Returns : An array of array references, each the circular flag of a
+           chromosome followed by its genes
+ Args    : A Bio::GeneOrder object
+
+=cut
+
+sub _query_genome {
+	my ($self,$order) = @_;
+	
+	my $key = $self->_key;
+	my $names = $order->_key->{'name'};
+	
+	my $next = 1;
+	map( $next = $_ >= $next ? $_ + 1 : $next, keys %{ $key->{'name'} });
+	
+	my (@chromosomes,%unknown);
+	foreach my $pi ($order->pi){
+		my @genes;
+		foreach my $gene ($pi->pi){
+			my $name = $names->{abs($gene)};
+			next if $key->{'filt'}->{$name};
+			
+			my $number = $key->{'index'}->{$name};
+			$number = $unknown{$name} ||= $next++ unless defined $number;
+			
+			CORE::push @genes, $gene < 0 ? -$number : $number;
+		}
+		CORE::push @chromosomes, [ $pi->is_circular ? 1 : 0, @genes ];
+	}
+	
+	return @chromosomes;
+}
+
 =head2 _sort_orders
 
  Title   : _sort_orders
@@ -129,15 +129,74 @@ sub next_set {
 
 	return 1 if($test);
 
-	my (@orders,@pi,$entry,$name,$order);
+	my @orders;
+	
+	while( my $order = $self->next_order ){
+		push @orders, $order;
+	}
+	
+	return @orders;
+}
+
+=head2 next_order
+
+ Title   : next_order
+ Usage   : while( my $order = $stream->next_order() ){ ... }
+ Function: Reads the next gene order from the stream. Files are memory mapped
+           and tokenized by the XS library one gene order at a time, other streams
+           are read line by line. Either way the genes of every gene order read
+           from one stream are numbered in one shared key, so each gene name is
+           only looked up once.
+
+           As the key holds the gene filters, filtering a gene on one gene order
+           read from a stream filters it on every other gene order read from that
+           stream, as it does within a Bio::GeneOrder::Set.
+ Returns : A Bio::GeneOrder object, or undef at the end of the stream
+
+=cut
+
+sub next_order {
+	my $self = shift;
+	
+	my $reader = $self->_reader;
+	return $self->_next_order_lines unless $reader;
+	
+	my ($name,@packed) = eval { Bio::GeneOrder::Distance::fasta_next_xs($reader) };
+	$self->throw("gene order file '". $self->file. "' not formatted correctly: $@") if $@;
+	
+	return unless defined $name;
+	
+	#add the genes first seen in this gene order to the key
+	map( $self->_add_gene($_), Bio::GeneOrder::Distance::fasta_names_xs($reader,$self->{'no_genes'} + 1));
+	
+	my @pi = map( Bio::GeneOrder::permutation->new( -packed => $_ ), @packed);
+	map( $_->{'key'} = $self->{'key'}, @pi);
+	
+	return Bio::GeneOrder->new(@pi,-name => $name);
+}
+
+=head2 _next_order_lines
+
+ Title   : _next_order_lines
+ Usage   : my $order = $stream->_next_order_lines();
+ Function: Reads the next gene order line by line, for streams that are not
+           plain files and so can not be memory mapped
+ Returns : A Bio::GeneOrder object, or undef at the end of the stream
+
+=cut
+
+sub _next_order_lines {
+	my $self = shift;
+	
+	my (@pi,$entry,$name);
 	
 	while (defined ($entry = $self->_readline) ) {
 		chomp $entry;
+		$entry =~ s/\r$//;
 		if ( $entry =~ /^>(.*)/ ) {
 			if(defined $name){
-				#print "$name\n";
-				push @orders, Bio::GeneOrder->new(@pi,-name => $name);
-				@pi = ();
+				$self->_pushback("$entry\n");
+				last;
 			}
 			$name = $1;
 		
@@ -149,12 +208,112 @@ sub next_set {
 		}
 	}
 	
-	if(defined $name){
-		push @orders, Bio::GeneOrder->new(@pi,-name => $name);
-		@pi = ();
+	return unless defined $name;
+	
+	#number the genes in the key of the stream, as the mapped reader does
+	my $key = $self->_stream_key;
+	my @perms;
+	foreach my $order (@pi){
+		my $circular = 1;
+		$circular = 0 if($order =~ s/^$LINEAR\s*//);
+		
+		my @pi;
+		foreach my $gene (split ' ', $order){
+			my ($strand,$gene) = $gene =~ /^([\-+])?(\S+)/;
+			$gene =~ s/\s/_/g;
+			
+			$self->_add_gene($gene) unless defined $key->{'index'}->{$gene};
+			push @pi, $SWITCH{$strand || '+'} * $key->{'index'}->{$gene};
+		}
+		
+		my $permutation = Bio::GeneOrder::permutation->new( -circular => $circular, -pi => \@pi );
+		$permutation->{'key'} = $key;
+		push @perms, $permutation;
 	}
 	
-	return @orders;
+	return Bio::GeneOrder->new(@perms,-name => $name);
+}
+
+=head2 _stream_key
+
+ Title   : _stream_key
+ Usage   : my $key = $stream->_stream_key();
+ Function: Gets the gene name/number key shared by every gene order read from
+           the stream, starting an empty one on first use
+ Returns : The gene name/number key
+
+=cut
+
+sub _stream_key {
+	my $self = shift;
+	
+	unless(defined $self->{'key'}){
+		$self->{'key'} = {};
+		$self->{'no_genes'} = 0;
+	}
+	
+	return $self->{'key'};
+}
+
+=head2 _add_gene
+
+ Title   : _add_gene
+ Usage   : $stream->_add_gene($name);
+ Function: Numbers a gene first seen in the stream in the key of the stream
+ Args    : The name of the gene
+
+=cut
+
+sub _add_gene {
+	my ($self,$gene) = @_;
+	
+	my $key = $self->_stream_key;
+	my $i = ++$self->{'no_genes'};
+	
+	$key->{'name'}->{$i} = $gene;
+	$key->{'index'}->{$gene} = $i;
+	$key->{'filt'}->{$gene} = 0;
+	
+	if($gene =~ /trn/i){
+		$key->{'type'}->{$gene} = 'tRNA';
+	}elsif($gene =~ /rrn/i){
+		$key->{'type'}->{$gene} = 'rRNA';
+	}else{
+		$key->{'type'}->{$gene} = 'CDS';
+	}
+}
+
+=head2 _reader
+
+ Title   : _reader
+ Usage   : my $reader = $stream->_reader();
+ Function: Opens the file of the stream in the XS library on first use
+ Returns : A handle for the XS library, or undef if the stream is not a plain file
+
+=cut
+
+sub _reader {
+	my $self = shift;
+	
+	unless(exists $self->{'reader'}){
+		$self->{'reader'} = undef;
+		
+		my $file = $self->file;
+		if(defined $file && $file =~ /^\s*<?\s*([^<>|]+?)\s*$/ && -f $1){
+			$self->{'reader'} = Bio::GeneOrder::Distance::fasta_open_xs($1) || undef;
+			$self->_stream_key;
+			$self->_register_for_cleanup(\&_close_reader) if $self->{'reader'};
+		}
+	}
+	
+	return $self->{'reader'};
+}
+
+sub _close_reader {
+	my $self = shift;
+	
+	Bio::GeneOrder::Distance::fasta_close_xs($self->{'reader'}) if $self->{'reader'};
+	$self->{'reader'} = undef;
 }
 
 =head2 write_set
@@ -102,7 +102,6 @@ methods. Internal methods are usually preceded with a _
 package Bio::GeneOrder::SetIO::nexus;
 
 use strict;
-use Thread;
 use Bio::GeneOrder::Distance;
 
 use base qw(Bio::GeneOrder::SetIO);
@@ -326,14 +325,19 @@ sub get_matrix {
 	}elsif( grep($_ eq $encoding, Bio::GeneOrder::Distance->supported_distances) ){
 		
 		$MISSING = '?';
-		my @threads;
 		
-		foreach my $order ( @sorted){
+		#compute every pairwise distance in one call to the distance library,
+		#which spreads the work over $set->distance->threads threads
+		my $distances = $set->distance->matrix($encoding,@sorted);
+		
+		for(my $i=0;$i<@sorted;$i++){
+			my $order = $sorted[$i];
 			$TAXLABELS .= "\t'".$order->name."'\n";
 			$MARGIN = length($order->name) +$SPACE if length($order->name) +$SPACE > $MARGIN;
 
-			foreach my $order2 ( @sorted){
-				my $count = $order->distance->$encoding($order,$order2);
+			for(my $j=0;$j<@sorted;$j++){
+				my $order2 = $sorted[$j];
+				my $count = $distances->[$i][$j];
 
 				$MAX = $count if $count > $MAX;
 				$CHARWIDTH = (length($count)+1) if (length($count)+1) > $CHARWIDTH;
@@ -342,8 +346,6 @@ sub get_matrix {
 			}
 		}
 		
-		map( $_->join, @threads);
-		
 		@SYMBOLS = (0..$MAX);
 		map( @{ $STATELABELS{ $_->name}} = @SYMBOLS, @sorted);
 		
@@ -61,6 +61,8 @@ use base qw(Bio::Root::Root);
  Args    : -source            => an accession number or other reference	
            -circular          => a value of 1 or 0 [default 0]
            -pi                => a reference to an array of signed integers
+           -packed            => alternative to -circular and -pi: the circular flag
+                                 and genes already packed as by _pack
 
 =cut
 
@@ -77,11 +79,16 @@ sub new {
 	$caller->throw("circular argument provided, but with an undefined value") 
 		if( exists($param{'-circular'}) && !defined($param{'-circular'}) );
 	$caller->throw("pi argument is required") 
-		if( !defined($param{'-pi'}) );
+		if( !defined($param{'-pi'}) && !defined($param{'-packed'}) );
 	
 	$self->source($param{'-source'}) if defined $param{'-source'};
-	$self->is_circular(defined $param{'-circular'} ? $param{'-circular'} : 0);
-	$self->pi(@{$param{'-pi'}});
+	if(defined $param{'-packed'}){
+		$self->{'pi'} = $param{'-packed'};
+		$self->_revise;
+	}else{
+		$self->is_circular(defined $param{'-circular'} ? $param{'-circular'} : 0);
+		$self->pi(@{$param{'-pi'}});
+	}
 	
 	return $self;
 }
@@ -140,20 +147,20 @@ sub pi {
 
 	if( @pi){
 		if($pi[0] eq 'all'){
-			@pi = unpack("s*", $self->{'pi'});
+			@pi = _unpack($self->{'pi'});
 			shift @pi;
 			
 			return @pi;
 		}
 		
 		my @return = @pi;
-		unshift @pi, $self->is_circular;
-		$self->{'pi'} = pack("s*", @pi);
+		$self->{'pi'} = _pack($self->is_circular, @pi);
+		$self->_revise;
 		
 		return @return;
 	}else{
 		
-		@pi = unpack("s*", $self->{'pi'});
+		@pi = _unpack($self->{'pi'});
 		
 		shift @pi;
 		@pi = grep($self->{'key'}->{'filt'}->{ $self->{'key'}->{'name'}->{abs($_)} } == 0, @pi);
@@ -161,6 +168,49 @@ sub pi {
 	}
 }
 
+=head2 _pack
+
+ Title   : _pack
+ Usage   : my $packed = Bio::GeneOrder::permutation::_pack($circular,@pi);
+ Function: Packs a permutation behind a short of flags: 1 if it is circular,
+           and 2 if its gene numbers do not fit in shorts. Narrow permutations
+           are packed as shorts, wide ones as a short of padding and longs.
+ Returns : A packed string
+
+=cut
+
+sub _pack {
+	my ($circular,@pi) = @_;
+	
+	$circular = $circular ? 1 : 0;
+	
+	return pack("s*", $circular, @pi) 
+		unless grep($_ > 32767 || $_ < -32767, @pi);
+	
+	return pack("s s l*", $circular | 2, 0, @pi);
+}
+
+=head2 _unpack
+
+ Title   : _unpack
+ Usage   : my ($circular,@pi) = Bio::GeneOrder::permutation::_unpack($packed);
+ Function: Unpacks a string made by _pack
+ Returns : The circular flag followed by the gene numbers
+
+=cut
+
+sub _unpack {
+	my $packed = shift;
+	
+	my $flags = unpack("s", $packed);
+	
+	return unpack("s*", $packed) unless $flags & 2;
+	
+	my (undef, undef, @pi) = unpack("s s l*", $packed);
+	
+	return ($flags & 1, @pi);
+}
+
 =head2 is_circular
 
  Title   : is_circular
@@ -177,14 +227,14 @@ sub is_circular {
 	my @pi = ();
 	
 	if(defined $self->{'pi'}){
-		@pi = unpack("s*", $self->{'pi'});
+		@pi = _unpack($self->{'pi'});
 		$circular = shift @pi;
 	}
 
 	if( defined $value){
 		$circular = $value;
-		unshift @pi, $circular;
-		$self->{'pi'} = pack("s*", @pi);
+		$self->{'pi'} = _pack($circular, @pi);
+		$self->_revise;
 	}
 	
 	return $circular;
@@ -210,6 +260,44 @@ sub source {
 	return $self->{'source'};
 }
 
+=head2 _renumber
+
+ Title   : _renumber
+ Usage   : $permutation->_renumber($key,$table);
+ Function: Renumbers the genes through a table from their current numbers to
+           the numbers of a new key, in one call to the XS library, and adopts
+           the key.
+ Args    : The new key and the table, packed as longs indexed by current number
+
+=cut
+
+sub _renumber {
+	my ($self,$key,$table) = @_;
+	
+	$self->{'pi'} = Bio::GeneOrder::Distance::renumber_xs($self->{'pi'},$table);
+	$self->{'key'} = $key;
+	$self->_revise;
+}
+
+=head2 _revise
+
+ Title   : _revise
+ Usage   : $permutation->_revise();
+ Function: Counts a change to the permutation, in $Bio::GeneOrder::GENERATION
+           and $Bio::GeneOrder::REVISION, and gives the permutation a revision
+           of its own that no earlier state of it had, in this session or in
+           the one that saved it.
+
+=cut
+
+sub _revise {
+	my $self = shift;
+	
+	$Bio::GeneOrder::GENERATION++;
+	$Bio::GeneOrder::REVISION++;
+	$self->{'revision'} = "$Bio::GeneOrder::SESSION.$Bio::GeneOrder::REVISION";
+}
+
 =head2 _key
 
  Title   : _key
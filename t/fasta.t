@@ -0,0 +1,104 @@
+#!perl -T
+
+use strict;
+use warnings;
+use Test::More tests => 13;
+use File::Temp qw(tempdir);
+
+use Bio::GeneOrder;
+use Bio::GeneOrder::SetIO;
+
+# Gene orders read from a plain file go through the memory mapped reader, and
+# ones read from a filehandle through the line reader. Both must agree, on
+# tabs and double spaces between genes too.
+
+my $dir = tempdir( CLEANUP => 1 );
+
+my $text = <<'END';
+;a comment before the first gene order
+
+>Lampsilis ornata|NC_005335
++nad1 -cox1  cox2	trnD
+
+>B
+~ nad1 cox1 -cox2
+;a comment between chromosomes
+
+- trnD + rrnL
+>C
+~nad1 -trnD cox2 cox1
+END
+
+sub write_file {
+	my ($name,$content) = @_;
+
+	my $file = "$dir/$name";
+	open my $fh, '>', $file or die "could not write $file: $!";
+	binmode $fh;
+	print $fh $content;
+	close $fh;
+
+	return $file;
+}
+
+sub stream {
+	my ($file,$mapped) = @_;
+
+	return Bio::GeneOrder::SetIO->new( -file => $file, -format => 'fasta' ) if $mapped;
+
+	open my $fh, '<', $file or die "could not read $file: $!";
+	return Bio::GeneOrder::SetIO->new( -fh => $fh, -format => 'fasta' );
+}
+
+# The name, chromosomes and gene types of each gene order in a stream
+sub describe {
+	my $in = shift;
+
+	my @orders;
+	while( my $order = $in->next_order ){
+		my @lines = split /\n/, $order->order;
+		my @circular = map( $_->is_circular, $order->pi );
+
+		push @orders, join("\n",
+			$order->name,
+			map( ($circular[$_] ? '' : '~').$lines[$_], 0 .. $#lines ),
+			join(' ', map( "$_=".$order->_key->{'type'}->{$_}, $order->genes ))
+		);
+	}
+
+	return \@orders;
+}
+
+my $lf = write_file('lf.go',$text);
+(my $crlf_text = $text) =~ s/\n/\r\n/g;
+my $crlf = write_file('crlf.go',$crlf_text);
+
+ok( stream($lf,1)->_reader, 'plain files are memory mapped' );
+ok( !stream($lf,0)->_reader, 'filehandles are read line by line' );
+
+my $mapped = describe(stream($lf,1));
+is( scalar @$mapped, 3, 'three gene orders read' );
+is_deeply( $mapped, describe(stream($lf,0)), 'mapped and line readers agree' );
+is( $mapped->[1], "B\n~nad1 cox1 -cox2\n- trnD + rrnL\n+=CDS -=CDS cox1=CDS cox2=CDS nad1=CDS rrnL=rRNA trnD=tRNA",
+	'linear chromosomes, comments between chromosomes and lone signs as names' );
+
+my $mapped_crlf = describe(stream($crlf,1));
+is_deeply( $mapped_crlf, $mapped, 'CRLF files read like LF files when mapped' );
+is_deeply( describe(stream($crlf,0)), $mapped, 'CRLF files read like LF files line by line' );
+
+my $early = write_file('early.go',"nad1 cox1\n>A\nnad1 cox1\n");
+eval { stream($early,1)->next_order };
+like( $@, qr/not formatted correctly/, 'mapped reader throws on genes before the first name' );
+eval { stream($early,0)->next_order };
+like( $@, qr/not formatted correctly/, 'line reader throws on genes before the first name' );
+
+# Gene orders read from one stream share a key, and so their gene filters,
+# whichever reader reads them
+foreach my $mapped (1,0){
+	my $reader = $mapped ? 'mapped' : 'line';
+	my $in = stream($lf,$mapped);
+	my ($a,$b) = ($in->next_order, $in->next_order);
+	is( $a->_key, $b->_key, "$reader reader gives gene orders of one stream one key" );
+	$a->filter_genes( -name => 'cox2' );
+	ok( !grep( $_ eq 'cox2', $b->genes ), "$reader reader: filtering a gene on one filters it on its siblings" );
+}
@@ -0,0 +1,87 @@
+#!perl -T
+
+use strict;
+use warnings;
+use Test::More tests => 20;
+
+use Bio::GeneOrder;
+use Bio::GeneOrder::Set;
+
+# Breakpoint and adjacency matrices kept current across gene filters must
+# match the ones computed in full
+
+my @orders = (
+	Bio::GeneOrder->new("a b c d e f g h i j", -name => 'A'),
+	Bio::GeneOrder->new("a -d -c -b e f g h i j", -name => 'B'),
+	Bio::GeneOrder->new("~ a b c g f -e -d h i j", -name => 'C'),
+	Bio::GeneOrder->new("a b c d e", "~ -j -i h g f", -name => 'D'),
+	Bio::GeneOrder->new("~ j i h g f e d c b a", -name => 'E'),
+	Bio::GeneOrder->new("a b c d e f c g h i j", -name => 'repeat'),
+);
+my $set = Bio::GeneOrder::Set->new(@orders);
+
+# A list with a gene order that repeats a gene is computed in full
+my ($repeat) = grep( $_->name eq 'repeat', $set->orders );
+@orders = grep( $_ != $repeat, $set->orders );
+
+# Distance is a singleton, so the matrices computed in full come straight from
+# the XS library, as _matrix computes them without the incremental distances
+my $inc = Bio::GeneOrder::Distance->new();
+
+sub full {
+	my ($distance,@list) = @_;
+
+	my $n = scalar @list;
+	my @d = unpack("i*", Bio::GeneOrder::Distance::distance_matrix_xs(
+		[ map( $inc->pack_order($_), @list ) ], $distance, 1, 1 ));
+
+	return [ map( [ @d[$_*$n .. ($_+1)*$n - 1] ], 0 .. $n - 1 ) ];
+}
+
+sub agree {
+	my $when = shift;
+
+	foreach my $distance (qw(breakpoints adjacencies)){
+		is_deeply( $inc->matrix($distance,@orders), full($distance,@orders), "$distance $when" );
+	}
+}
+
+agree('before any filter');
+ok( !exists $inc->{'incdist'}->{'valid'}, 'gene orders are not indexed before a gene filter' );
+
+$set->filter_genes( -name => 'c' );
+agree('after a gene filter on the set');
+my $index = $inc->{'incdist'};
+ok( $index && $index->{'valid'}, 'gene orders indexed after a gene filter' );
+
+$orders[0]->filter_genes( -name => 'h' );
+agree('after a gene filter on one gene order');
+is( $inc->{'incdist'}, $index, 'a gene filter keeps the index' );
+
+$set->filter_genes( -name => 'c', -unfilter => 1 );
+agree('after a gene is restored');
+
+# Pairwise breakpoints are read from the same index
+$inc->_cache('clear');
+my $rows = full('breakpoints',@orders);
+my $pairs = 1;
+for(my $i=0;$i<@orders;$i++){
+	for(my $j=0;$j<@orders;$j++){
+		$pairs = 0 if $inc->breakpoints($orders[$j],$orders[$i]) != $rows->[$i][$j];
+	}
+}
+ok( $pairs, 'pairwise breakpoints' );
+
+($orders[1]->pi)[0]->pi( map( $orders[1]->_key->{'index'}->{$_}, qw(a b c d e f g h i j) ) );
+agree('after a gene order is edited');
+
+$set->filter_genes( -name => 'h', -unfilter => 1 );
+agree('after every gene is restored');
+ok( $inc->{'incdist'} != $index && $inc->{'incdist'}->{'valid'}, 'an edited gene order is indexed again' );
+
+is_deeply( $inc->matrix('breakpoints',@orders,$repeat), full('breakpoints',@orders,$repeat),
+	'breakpoints with a gene order that repeats a gene' );
+$set->filter_genes( -name => 'a' );
+is_deeply( $inc->matrix('breakpoints',@orders,$repeat), full('breakpoints',@orders,$repeat),
+	'breakpoints with a gene order that repeats a gene after a gene filter' );
+ok( !$inc->{'incdist'}->{'valid'}, 'gene orders that repeat a gene are not indexed' );
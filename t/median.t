@@ -0,0 +1,88 @@
+#!perl -T
+
+use strict;
+use warnings;
+use Test::More tests => 11;
+
+use Bio::GeneOrder;
+use Bio::GeneOrder::Set;
+
+# The median found for three gene orders, mapped back to their gene names, must
+# be as far from them as its score says, and no nearer than its lower bound
+
+sub new_set {
+	my @orders;
+	while( @_ ){
+		my ($name,$order) = (shift,shift);
+		push @orders, Bio::GeneOrder->new($order, -name => $name);
+	}
+
+	#the filters of one set are applied to the next, so each starts without
+	%Bio::GeneOrder::Set::OFILTER = ();
+	%Bio::GeneOrder::Set::GFILTER = ();
+
+	return Bio::GeneOrder::Set->new(@orders);
+}
+
+# The median of the first three gene orders of a set and the sum of its
+# distances to them. The median is pushed onto the set, which numbers its
+# genes by name as it does those of the others.
+sub median {
+	my ($set,$distance) = @_;
+
+	my @orders = ($set->orders)[0 .. 2];
+	my ($median,$score,$optimal,$bound) = $orders[0]->distance->median($distance,@orders);
+	$set->push($median);
+
+	my $sum = 0;
+	$sum += $median->distance->$distance($median,$_) foreach @orders;
+
+	return ($median,$score,$bound,$sum);
+}
+
+my @triple = ( 'A' => "~ a -b c d e f", 'B' => "~ a b c -d e f", 'C' => "~ a b c d e -f" );
+
+foreach my $distance (qw(inversions DCJ)){
+	my ($median,$score,$bound,$sum) = median(new_set(@triple),$distance);
+	is( $sum, $score, "$distance median as far from the gene orders as its score" );
+	ok( $bound <= $score, "$distance median no nearer than its lower bound" );
+
+	# Filtering a gene leaves a gap in the numbers the median is mapped back from
+	my $set = new_set(@triple);
+	$set->filter_genes( -name => 'c' );
+	($median,$score,$bound,$sum) = median($set,$distance);
+	is( $sum, $score, "$distance median as far from the gene orders as its score with a filtered gene" );
+	ok( $bound <= $score, "$distance median no nearer than its lower bound with a filtered gene" );
+}
+
+my $set = new_set(@triple);
+$set->filter_genes( -name => 'c' );
+my ($median) = median($set,'inversions');
+is( join(' ', sort $median->genes), 'a b d e f', 'the median holds the unfiltered genes by name' );
+
+# Gene orders a few inversions apart
+srand(5);
+my @genes = ('a' .. 'h');
+my ($sums,$bounds) = (1,1);
+for(my $i=0;$i<8;$i++){
+	my @orders;
+	for my $name (qw(A B C)){
+		my @pi = @genes;
+		for(1 .. 1 + int(rand(3))){
+			my ($x,$y) = sort { $a <=> $b } (int(rand(@pi)), int(rand(@pi)));
+			@pi[$x .. $y] = map( /^-(.*)/ ? $1 : "-$_", reverse @pi[$x .. $y] );
+		}
+		push @orders, $name => '~ '.join(' ', @pi);
+	}
+
+	foreach my $distance (qw(inversions DCJ)){
+		$set = new_set(@orders);
+		$set->filter_genes( -name => 'd' ) if $i % 2;
+
+		my (undef,$score,$bound,$sum) = median($set,$distance);
+		$sums = 0 if $sum != $score;
+		$bounds = 0 if $bound > $score;
+	}
+}
+ok( $sums, 'medians of random gene orders as far from them as their scores' );
+ok( $bounds, 'medians of random gene orders no nearer than their lower bounds' );
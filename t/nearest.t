@@ -0,0 +1,107 @@
+#!perl -T
+
+use strict;
+use warnings;
+use Test::More tests => 14;
+
+use Bio::GeneOrder;
+use Bio::GeneOrder::Set;
+
+# The gene orders nearest a query, found through the vantage point tree index,
+# must be the ones a scan of the set ranks first, by distance and then by their
+# order in the set, however the set's gene orders and genes are filtered
+
+sub new_set {
+	my @orders;
+	while( @_ ){
+		my ($name,$order) = (shift,shift);
+		push @orders, Bio::GeneOrder->new($order, -name => $name);
+	}
+
+	#the filters of one set are applied to the next, so each starts without
+	%Bio::GeneOrder::Set::OFILTER = ();
+	%Bio::GeneOrder::Set::GFILTER = ();
+
+	return Bio::GeneOrder::Set->new(@orders);
+}
+
+sub names {
+	return join ' ', map( $_->name, @_ );
+}
+
+sub content {
+	return join ' ', sort shift->genes;
+}
+
+# The k unfiltered gene orders of the set nearest a query of it, by a scan. DCJ
+# distances are only defined between gene orders of the same genes.
+sub scan {
+	my ($set,$query,$k,$distance) = @_;
+
+	my $i = 0;
+	my @ranked = map( $_->[0], sort { $a->[1] <=> $b->[1] || $a->[2] <=> $b->[2] }
+		map( [ $_, $set->distance->$distance($query,$_), $i++ ],
+			grep( $_ != $query && ($distance ne 'DCJ' || content($_) eq content($query)), $set->orders )));
+
+	return @ranked[0 .. ($k < @ranked ? $k : scalar @ranked) - 1];
+}
+
+# Whether every gene order of the set is given its nearest as a scan ranks them
+sub agree {
+	my ($set,$k,$distance) = @_;
+
+	foreach my $query ($set->orders){
+		return 0 unless names($set->nearest($query,$k,$distance)) eq names(scan($set,$query,$k,$distance));
+	}
+	return 1;
+}
+
+# Gene orders a few inversions apart, some of them without gene l, so that
+# some are equally near a query and DCJ searches two groups of gene orders. The
+# set lists its gene orders by name, so names in the order of the set keep the
+# scan's ties as nearest breaks them.
+srand(23);
+my @genes = ('a' .. 'l');
+my @orders;
+for(my $i=0;$i<60;$i++){
+	my @pi = $i % 5 ? @genes : @genes[0 .. 10];
+	for(1 .. int(rand(4))){
+		my ($x,$y) = sort { $a <=> $b } (int(rand(@pi)), int(rand(@pi)));
+		@pi[$x .. $y] = map( /^-(.*)/ ? $1 : "-$_", reverse @pi[$x .. $y] );
+	}
+	push @orders, sprintf("O%02d",$i) => ($i % 3 ? '~ ' : '').join(' ', @pi);
+}
+my $set = new_set(@orders);
+
+ok( agree($set,5,'breakpoints'), 'nearest by breakpoints as a scan ranks them' );
+ok( agree($set,5,'DCJ'), 'nearest by DCJ as a scan ranks them' );
+ok( agree($set,100,'breakpoints'), 'every gene order ranked when k exceeds the set' );
+
+$set->filter_genes( -name => 'c' );
+ok( agree($set,5,'breakpoints'), 'nearest by breakpoints after a gene filter' );
+ok( agree($set,5,'DCJ'), 'nearest by DCJ after a gene filter' );
+
+$set->filter_orders( -name => $_ ) foreach qw(O01 O07 O12 O33);
+ok( !grep( $_->filtered, map( $set->nearest($_,10,'breakpoints'), $set->orders( -all => 1 ) )),
+	'filtered gene orders are not returned' );
+ok( agree($set,5,'breakpoints'), 'nearest by breakpoints after an order filter' );
+ok( agree($set,5,'DCJ'), 'nearest by DCJ after an order filter' );
+
+$set->filter_genes( -name => 'c', -unfilter => 1 );
+ok( agree($set,5,'DCJ'), 'nearest by DCJ after a gene is restored' );
+
+# A gene order from outside the set is matched to the set's genes by name; once
+# it is pushed onto the set, it must find the same gene orders, as a scan does
+my $query = Bio::GeneOrder->new("~ a b -e -d -c f g h i j k l", -name => 'query');
+my @found = $set->nearest($query,5,'breakpoints');
+my @found_dcj = $set->nearest($query,5,'DCJ');
+$set->push($query);
+is( names(@found), names(scan($set,$query,5,'breakpoints')), 'nearest by breakpoints to a gene order outside the set' );
+is( names(@found_dcj), names(scan($set,$query,5,'DCJ')), 'nearest by DCJ to a gene order outside the set' );
+ok( agree($set,5,'DCJ'), 'the index is rebuilt once a gene order is pushed' );
+
+# DCJ distances are only defined between gene orders of the same genes
+is_deeply( [ $set->nearest(Bio::GeneOrder->new("a b c d e f g h i j k l z", -name => 'extra'),5,'DCJ') ], [],
+	'no DCJ neighbors for a gene order with a gene the set lacks' );
+is_deeply( [ $set->nearest(Bio::GeneOrder->new("a b c d e f", -name => 'short'),5,'DCJ') ], [],
+	'no DCJ neighbors for a gene order of genes no gene order of the set has' );
@@ -0,0 +1,120 @@
+#!perl -T
+
+use strict;
+use warnings;
+use Test::More tests => 15;
+use File::Temp qw(tempdir);
+use Storable;
+
+use Bio::GeneOrder;
+use Bio::GeneOrder::Set;
+
+# A set saved with Set::save must open again as the same set, and so must one
+# saved with Storable before the columnar format
+
+my $dir = tempdir( CLEANUP => 1 );
+
+sub new_set {
+	my $a = Bio::GeneOrder->new("a b c d e f g h", -name => 'A');
+	my $b = Bio::GeneOrder->new("~ a -c -b d e f h g", -name => 'B');
+	my $c = Bio::GeneOrder->new("a b c d", "~ -h -g e f", -name => 'C');
+	my $d = Bio::GeneOrder->new("a b c d e f g h", -name => 'D');
+
+	$a->classification([ 'Metazoa', 'Mollusca' ]);
+	$c->classification([ 'Metazoa' ]);
+
+	my $set = Bio::GeneOrder::Set->new($a,$b,$c,$d);
+	$set->filter_genes( -name => 'e' );
+	$set->filter_orders( -name => 'D' );
+
+	return $set;
+}
+
+# Everything a saved set keeps, gene order by gene order
+sub describe {
+	my $set = shift;
+
+	my @orders;
+	foreach my $order ($set->orders( -all => 1 )){
+		my @lines = split /\n/, $order->order;
+		my @circular = map( $_->is_circular, $order->pi );
+		my @classification = grep( defined, $order->classification );
+
+		push @orders, {
+			'name'           => $order->name,
+			'filtered'       => $order->filtered ? 1 : 0,
+			'classification' => \@classification,
+			'chromosomes'    => [ map( ($circular[$_] ? '' : '~').$lines[$_], 0 .. $#lines ) ],
+			'genes'          => [ $order->genes ],
+			'filtered genes' => [ $order->genes( -filtered => 1 ) ],
+		};
+	}
+
+	return { 'genes' => [ sort $set->genes ], 'orders' => \@orders };
+}
+
+my $set = new_set();
+my $expected = describe($set);
+
+is_deeply( [ map( $_->{'name'}, @{ $expected->{'orders'} } ) ], [ qw(A B C D) ], 'four gene orders' );
+is_deeply( $expected->{'orders'}->[2]->{'chromosomes'}, [ 'a b c d', '~-h -g f' ], 'a circular and a linear chromosome' );
+is_deeply( $expected->{'orders'}->[0]->{'filtered genes'}, [ 'e' ], 'gene e filtered' );
+is( $expected->{'orders'}->[3]->{'filtered'}, 1, 'gene order D filtered' );
+
+my $file = "$dir/set";
+ok( $set->save($file), 'set saved' );
+
+my $loaded = Bio::GeneOrder::Set->new( -file => $file );
+is_deeply( describe($loaded), $expected, 'saved set opens as it was' );
+my ($a,$b) = map( $loaded->orders( -name => $_ ), qw(A B) );
+is( $a->breakpoints($b), $set->orders( -name => 'A' )->breakpoints($set->orders( -name => 'B' )),
+	'opened gene orders are as far apart' );
+
+my $order = $set->orders( -name => 'C' );
+ok( $order->save("$dir/order"), 'gene order saved' );
+my $reloaded = Bio::GeneOrder->new( -file => "$dir/order" );
+is( $reloaded->order, $order->order, 'saved gene order opens as it was' );
+
+# Sets saved before the columnar format were Storable images
+my $legacy = "$dir/legacy";
+store new_set(), $legacy;
+is_deeply( describe(Bio::GeneOrder::Set->new( -file => $legacy )), $expected, 'Storable set still opens' );
+
+# A file that starts as a saved set but is cut short must not be read
+open my $in, '<', $file or die "could not read $file: $!";
+binmode $in;
+my $data = do { local $/; <$in> };
+close $in;
+
+my $damaged = "$dir/damaged";
+open my $out, '>', $damaged or die "could not write $damaged: $!";
+binmode $out;
+print $out substr($data, 0, length($data) - 16);
+close $out;
+
+my $opened = eval { Bio::GeneOrder::Set->new( -file => $damaged ) };
+ok( !defined $opened, 'damaged set not opened' );
+like( $@, qr/damaged saved set/, 'damaged set throws' );
+
+# Nor one whose genes are edited: a gene must number a name, and a gene order
+# the file notes as repeating no gene must not repeat one
+sub edited {
+	my ($name,$edit) = @_;
+
+	# The genes section is the last of the header's 12 section offsets
+	my $genes = unpack("Q", substr($data, 32 + 11 * 8, 8));
+	my $copy = $data;
+	substr($copy, $genes, 8) = pack("l2", $edit->(unpack("l2", substr($copy, $genes, 8))));
+
+	my $file = "$dir/$name";
+	open my $out, '>', $file or die "could not write $file: $!";
+	binmode $out;
+	print $out $copy;
+	close $out;
+
+	return eval { Bio::GeneOrder::Set->new( -file => $file ) } ? '' : $@;
+}
+
+like( edited('repeat', sub { ($_[1],$_[1]) }), qr/damaged saved set/, 'a repeated gene in a valid gene order throws' );
+like( edited('zero', sub { (0,$_[1]) }), qr/damaged saved set/, 'gene 0 throws' );
+like( edited('unnamed', sub { (1000,$_[1]) }), qr/damaged saved set/, 'a gene with no name throws' );
@@ -0,0 +1,96 @@
+#!perl -T
+
+use strict;
+use warnings;
+use Test::More tests => 8;
+
+use Bio::GeneOrder;
+use Bio::GeneOrder::Set;
+
+# An inversion scenario must be as long as the inversion distance, and its
+# inversions, replayed by the names of the genes they invert, must turn the
+# first gene order into the second
+
+sub new_set {
+	my @orders;
+	while( @_ ){
+		my ($name,$order) = (shift,shift);
+		push @orders, Bio::GeneOrder->new($order, -name => $name);
+	}
+
+	#the filters of one set are applied to the next, so each starts without
+	%Bio::GeneOrder::Set::OFILTER = ();
+	%Bio::GeneOrder::Set::GFILTER = ();
+
+	return Bio::GeneOrder::Set->new(@orders);
+}
+
+# The signed gene names of a single chromosome gene order
+sub signed {
+	my $order = shift;
+
+	(my $line = $order->order) =~ s/^\s*~\s*//;
+	return [ split ' ', $line ];
+}
+
+# Replays a scenario on the first gene order: each inversion must name a run of
+# genes as they read before it, which it reverses and switches strand
+sub replay {
+	my ($orderA,@scenario) = @_;
+
+	my @genes = @{ signed($orderA) };
+	foreach my $segment (@scenario){
+		my $n = scalar @$segment;
+		my ($first) = grep( "@genes[$_ .. $_ + $n - 1]" eq "@$segment", 0 .. @genes - $n );
+		return unless defined $first;
+
+		@genes[$first .. $first + $n - 1] = map( /^-(.*)/ ? $1 : "-$_", reverse @$segment );
+	}
+
+	return \@genes;
+}
+
+sub check {
+	my ($set,$when) = @_;
+
+	my ($orderA,$orderB) = $set->orders;
+	my @scenario = $orderA->distance->inversion_scenario($orderA,$orderB);
+
+	is( scalar @scenario, $orderA->distance->inversions($orderA,$orderB), "as many inversions as the distance$when" );
+	is_deeply( replay($orderA,@scenario), signed($orderB), "the inversions turn the first gene order into the second$when" );
+}
+
+my $set = new_set( 'A' => "~ a b c d e f g h", 'B' => "~ a -d -c -b e h g f" );
+check($set,'');
+
+$set->filter_genes( -name => 'c' );
+check($set,' with a filtered gene');
+
+$set = new_set( 'A' => "~ a b c d", 'B' => "~ a b c d" );
+my ($orderA,$orderB) = $set->orders;
+is( scalar $orderA->distance->inversion_scenario($orderA,$orderB), 0, 'no inversions between equal gene orders' );
+
+# Linear gene orders a few inversions apart
+srand(29);
+my @genes = ('a' .. 'l');
+my ($length,$reached) = (1,1);
+for(my $i=0;$i<20;$i++){
+	my @pi = @genes;
+	for(1 .. 1 + int(rand(5))){
+		my ($x,$y) = sort { $a <=> $b } (int(rand(@pi)), int(rand(@pi)));
+		@pi[$x .. $y] = map( /^-(.*)/ ? $1 : "-$_", reverse @pi[$x .. $y] );
+	}
+	$set = new_set( 'A' => '~ '.join(' ', @genes), 'B' => '~ '.join(' ', @pi) );
+
+	($orderA,$orderB) = $set->orders;
+	my @scenario = $orderA->distance->inversion_scenario($orderA,$orderB);
+	$length = 0 if @scenario != $orderA->distance->inversions($orderA,$orderB);
+	$reached = 0 unless join(' ', @{ replay($orderA,@scenario) || [] }) eq join(' ', @pi);
+}
+ok( $length, 'as many inversions as the distance on random gene orders' );
+ok( $reached, 'the inversions reach the second of random gene orders' );
+
+# The scenario names genes by the first gene order's key
+$set = new_set( 'A' => "~ x y z", 'B' => "~ x -y z" );
+($orderA,$orderB) = $set->orders;
+is_deeply( [ $orderA->distance->inversion_scenario($orderA,$orderB) ], [ [ 'y' ] ], 'a single gene inverted by name' );
@@ -0,0 +1,88 @@
+#!perl -T
+
+use strict;
+use warnings;
+use Test::More tests => 11;
+
+use Bio::GeneOrder;
+use Bio::GeneOrder::Set;
+
+# Gene orders have equal signatures exactly when they are 0 breakpoints apart,
+# and filter_orders(-unique) keeps one gene order of each signature
+
+sub new_set {
+	my @orders;
+	while( @_ ){
+		my ($name,$order) = (shift,shift);
+		push @orders, Bio::GeneOrder->new(ref $order ? @$order : $order, -name => $name);
+	}
+
+	#the filters of one set are applied to the next, so each starts without
+	%Bio::GeneOrder::Set::OFILTER = ();
+	%Bio::GeneOrder::Set::GFILTER = ();
+
+	return Bio::GeneOrder::Set->new(@orders);
+}
+
+sub names {
+	return join ' ', sort map( $_->name, @_ );
+}
+
+my $set = new_set(
+	'A'        => "a b c d e f",
+	'rotated'  => "d e f a b c",
+	'reversed' => "-c -b -a -f -e -d",
+	'B'        => "a -c -b d e f",
+	'linear'   => "~ a b c d e f",
+	'flipped'  => "~ -f -e -d -c -b -a",
+	'split'    => [ "a b c", "d e f" ],
+);
+my %order = map( ($_->name => $_), $set->orders );
+
+is( $order{'rotated'}->signature, $order{'A'}->signature, 'a circular chromosome read from another gene' );
+is( $order{'reversed'}->signature, $order{'A'}->signature, 'a circular chromosome read from the other strand' );
+is( $order{'flipped'}->signature, $order{'linear'}->signature, 'a linear chromosome read from the other strand' );
+isnt( $order{'linear'}->signature, $order{'A'}->signature, 'linear and circular chromosomes differ' );
+isnt( $order{'split'}->signature, $order{'A'}->signature, 'one chromosome and two differ' );
+
+# Gene orders a few inversions apart, so that some repeat
+srand(17);
+my @genes = ('a' .. 'h');
+my @pairs;
+for(my $i=0;$i<40;$i++){
+	my @pi = @genes;
+	for(1 .. int(rand(3))){
+		my ($x,$y) = sort { $a <=> $b } (int(rand(@pi)), int(rand(@pi)));
+		@pi[$x .. $y] = map( /^-(.*)/ ? $1 : "-$_", reverse @pi[$x .. $y] );
+	}
+	push @pairs, "O$i" => ($i % 3 ? '~ ' : '').join(' ', @pi);
+}
+$set = new_set(@pairs);
+my @orders = $set->orders;
+
+my $agree = 1;
+foreach my $x (@orders){
+	foreach my $y (@orders){
+		$agree = 0 if ($x->signature eq $y->signature) != ($x->breakpoints($y) == 0);
+	}
+}
+ok( $agree, 'equal signatures exactly when 0 breakpoints apart' );
+
+my %signatures = map( ($_->signature => 1), @orders );
+ok( keys %signatures < @orders, 'some gene orders repeat' );
+
+$set->filter_orders( -unique => 1 );
+my @kept = $set->orders;
+is( scalar @kept, scalar keys %signatures, 'one gene order kept of each signature' );
+is_deeply( [ sort map( $_->signature, @kept ) ], [ sort keys %signatures ], 'every signature kept' );
+
+# Filtering genes changes the signatures of the gene orders that held them
+$set = new_set( 'A' => "a b c d", 'B' => "a c b d", 'C' => "a -b c d" );
+$set->filter_genes( -name => 'b' );
+%order = map( ($_->name => $_), $set->orders );
+ok( $order{'A'}->signature eq $order{'B'}->signature && $order{'A'}->signature eq $order{'C'}->signature,
+	'gene orders equal once a gene is filtered' );
+
+$set = new_set( 'A' => "a b c d", 'B' => "d a b c", 'C' => "a c b d" );
+$set->filter_orders( -name => 'A', -unique => 1 );
+is( names($set->orders( -filtered => 1 )), 'A B', 'named -unique filters the gene orders equal to one' );